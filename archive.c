@@ -0,0 +1,526 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "archive.h"
+#include "engine.h"
+
+/*
+    Columnar game archive. Games are grouped in blocks and each block stores
+    its columns one after the other: game lengths, dices, pawns, captures and
+    outcomes, bit packed or as varints. The file is the header (board
+    dimensions and safe cells), the blocks, the index of the blocks (offset,
+    column sizes and min/max of the values a query filters on) and a trailer
+    that points to the index. Readers map the file in memory.
+*/
+
+/**
+ * Header at the start of an archive file, followed by the safe cells (one byte
+ * per cell, padded to 8 bytes).
+ */
+typedef struct {
+    char magic[4];  // "NTCA"
+    uint32_t version;
+    uint32_t rows, cols;
+    uint32_t totalCells;
+    uint32_t reserved;
+} archiveHeader;
+
+/**
+ * Trailer at the end of an archive file.
+ */
+typedef struct {
+    uint64_t indexOffset;  // Offset of the block index
+    uint64_t totalGames;
+    uint32_t totalBlocks;
+    char magic[4];  // "NTCA"
+} archiveTrailer;
+
+
+/**
+ * @brief Rounds a size up to a multiple of 8.
+ * @param size The size
+ * @return Returns the rounded size
+ */
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t) 7;
+}
+
+/**
+ * @brief Makes room for more bytes in a buffer.
+ * @param buffer The buffer
+ * @param bytes Bytes that will be appended
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int reserveBuffer(archiveBuffer *buffer, size_t bytes) {
+    if (buffer->length + bytes > buffer->capacity) {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+        unsigned char *data;
+
+        while (capacity < buffer->length + bytes) {
+            capacity *= 2;
+        }
+
+        data = realloc(buffer->data, capacity);
+        if (data == NULL) {
+            return 1;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Appends a varint to a buffer.
+ * @param block The block (marked as failed if there is no memory)
+ * @param buffer The buffer
+ * @param value The value
+ */
+static void writeVarint(archiveBlock *block, archiveBuffer *buffer, uint32_t value) {
+    if (reserveBuffer(buffer, 5) == 1) {
+        block->failed = true;
+        return;
+    }
+
+    while (value >= 0x80) {
+        buffer->data[buffer->length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    buffer->data[buffer->length++] = (unsigned char) value;
+}
+
+/**
+ * @brief Appends a value of a few bits to a bit packed column.
+ * @param block The block (marked as failed if there is no memory)
+ * @param buffer The column
+ * @param position Number of values already in the column
+ * @param bits Bits per value (2 or 4)
+ * @param value The value
+ */
+static void writePacked(archiveBlock *block, archiveBuffer *buffer, uint32_t position, int bits, unsigned value) {
+    int perByte = 8 / bits;
+
+    if (position % perByte == 0) {
+        if (reserveBuffer(buffer, 1) == 1) {
+            block->failed = true;
+            return;
+        }
+        buffer->data[buffer->length++] = 0;
+    }
+
+    buffer->data[buffer->length - 1] |= (unsigned char) (value << (position % perByte * bits));
+}
+
+/**
+ * @brief Initializes an empty block.
+ * @param block The block
+ */
+void archiveBlockInit(archiveBlock *block) {
+    memset(block, 0, sizeof(archiveBlock));
+    archiveBlockReset(block, 0);
+}
+
+/**
+ * @brief Frees the memory of a block.
+ * @param block The block
+ */
+void archiveBlockFree(archiveBlock *block) {
+    for (int column = 0; column < ARCHIVE_COLUMNS; column++) {
+        free(block->columns[column].data);
+    }
+    free(block->gameCaptures.data);
+    memset(block, 0, sizeof(archiveBlock));
+}
+
+/**
+ * @brief Empties a block, keeping its memory, to record the next games.
+ * @param block The block
+ * @param firstGame Number of the first game the block will have
+ */
+void archiveBlockReset(archiveBlock *block, uint64_t firstGame) {
+    for (int column = 0; column < ARCHIVE_COLUMNS; column++) {
+        block->columns[column].length = 0;
+    }
+
+    memset(&block->index, 0, sizeof(archiveBlockIndex));
+    block->index.firstGame = firstGame;
+    block->index.minPlays = UINT32_MAX;
+    block->index.minCaptureCell = UINT32_MAX;
+    block->index.minCapturePlay = UINT32_MAX;
+    block->failed = false;
+}
+
+/**
+ * @brief Starts recording a game in a block.
+ * @param block The block
+ */
+void archiveBeginGame(archiveBlock *block) {
+    block->gameCaptures.length = 0;
+    block->gamePlays = 0;
+    block->gameCaptureCount = 0;
+    block->lastCapturePlay = 0;
+}
+
+/**
+ * @brief Makes a play (see 'makePlay') and records it in the game being
+ * recorded: dices, pawn and the cell of every captured pawn (the adversary
+ * pawns only leave their cell when captured).
+ * @param block The block
+ * @param boardCells Board with all cells
+ * @param pawn The pawn to play
+ * @param dicesValue The dices value
+ * @return Returns the number of adversary pawns captured in the play
+ */
+int archiveMakePlay(archiveBlock *block, list *boardCells, char pawn, int dicesValue) {
+    int player = getPawnPlayer(pawn);
+    int adversary = 1 - player;
+    int before[4];
+    int captures;
+
+    memcpy(before, boardCells->pawnCells[adversary], sizeof(before));
+    captures = makePlay(boardCells, pawn, dicesValue);
+
+    writePacked(block, &block->columns[ARCHIVE_DICES], block->index.plays, 4, (unsigned) (dicesValue - 2));
+    writePacked(block, &block->columns[ARCHIVE_PAWNS], block->index.plays, 2, (unsigned) getPawnIndex(pawn));
+    block->index.plays++;
+    block->gamePlays++;
+
+    for (int pawnIndex = 0; pawnIndex < 4 && captures > 0; pawnIndex++) {
+        uint32_t cell = (uint32_t) before[pawnIndex];
+
+        if (boardCells->pawnCells[adversary][pawnIndex] == before[pawnIndex]) {
+            continue;
+        }
+
+        writeVarint(block, &block->gameCaptures, block->gamePlays - block->lastCapturePlay);
+        writeVarint(block, &block->gameCaptures, cell);
+        block->lastCapturePlay = block->gamePlays;
+        block->gameCaptureCount++;
+        block->index.captures++;
+
+        block->index.minCaptureCell = cell < block->index.minCaptureCell ? cell : block->index.minCaptureCell;
+        block->index.maxCaptureCell = cell > block->index.maxCaptureCell ? cell : block->index.maxCaptureCell;
+        block->index.minCapturePlay = block->gamePlays < block->index.minCapturePlay ? block->gamePlays : block->index.minCapturePlay;
+        block->index.maxCapturePlay = block->gamePlays > block->index.maxCapturePlay ? block->gamePlays : block->index.maxCapturePlay;
+    }
+
+    return captures;
+}
+
+/**
+ * @brief Ends the game being recorded.
+ * @param block The block
+ * @param winner The winner (0 - unfinished, 1 - P1, 2 - P2)
+ */
+void archiveEndGame(archiveBlock *block, int winner) {
+    archiveBuffer *captures = &block->columns[ARCHIVE_CAPTURES];
+
+    writeVarint(block, &block->columns[ARCHIVE_LENGTHS], block->gamePlays);
+    writeVarint(block, captures, block->gameCaptureCount);
+    if (reserveBuffer(captures, block->gameCaptures.length) == 1) {
+        block->failed = true;
+    } else if (block->gameCaptures.length > 0) {
+        memcpy(captures->data + captures->length, block->gameCaptures.data, block->gameCaptures.length);
+        captures->length += block->gameCaptures.length;
+    }
+    writePacked(block, &block->columns[ARCHIVE_OUTCOMES], block->index.games, 2, (unsigned) winner);
+
+    block->index.minPlays = block->gamePlays < block->index.minPlays ? block->gamePlays : block->index.minPlays;
+    block->index.maxPlays = block->gamePlays > block->index.maxPlays ? block->gamePlays : block->index.maxPlays;
+    block->index.wins[winner]++;
+    block->index.games++;
+}
+
+/**
+ * @brief Creates an archive file.
+ * @param fileName The name of the archive file
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param boardCells Board of the games (cells and safe cells)
+ * @param writer Receives the writer
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int archiveWriterOpen(const char *fileName, const unsigned int rows, const unsigned int cols, const list *boardCells, archiveWriter *writer) {
+    archiveHeader header = {{'N', 'T', 'C', 'A'}, ARCHIVE_VERSION, rows, cols, (uint32_t) boardCells->length, 0};
+    size_t safeSize = align8(boardCells->length);
+    unsigned char *isSafe = calloc(safeSize, 1);
+    bool failed;
+
+    memset(writer, 0, sizeof(archiveWriter));
+    // The pawns and dices columns are packed for the standard game
+    if (isSafe == NULL || boardCells->pawns != STANDARD_PAWNS || boardCells->dices != STANDARD_DICES) {
+        free(isSafe);
+        return 1;
+    }
+
+    for (int cellIndex = 0; cellIndex < boardCells->length; cellIndex++) {
+        isSafe[cellIndex] = casaIsSafe(boardCells->cells[cellIndex]) == TRUE;
+    }
+
+    writer->file = fopen(fileName, "wb");
+    failed = writer->file == NULL ||
+             fwrite(&header, sizeof(header), 1, writer->file) != 1 ||
+             fwrite(isSafe, safeSize, 1, writer->file) != 1;
+    free(isSafe);
+
+    if (failed) {
+        if (writer->file != NULL) {
+            fclose(writer->file);
+        }
+        writer->file = NULL;
+        return 1;
+    }
+
+    writer->offset = sizeof(header) + safeSize;
+    return 0;
+}
+
+/**
+ * @brief Appends a block to an archive file (not thread safe).
+ * @param writer The writer
+ * @param block The block, with at least one game
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int archiveWriteBlock(archiveWriter *writer, const archiveBlock *block) {
+    archiveBlockIndex *entry;
+
+    if (block->failed || block->index.games == 0) {
+        return 1;
+    }
+
+    if (writer->totalBlocks == writer->indexCapacity) {
+        uint32_t capacity = writer->indexCapacity > 0 ? writer->indexCapacity * 2 : 64;
+        archiveBlockIndex *index = realloc(writer->index, sizeof(archiveBlockIndex) * capacity);
+
+        if (index == NULL) {
+            return 1;
+        }
+        writer->index = index;
+        writer->indexCapacity = capacity;
+    }
+
+    entry = &writer->index[writer->totalBlocks];
+    *entry = block->index;
+    entry->offset = writer->offset;
+
+    for (int column = 0; column < ARCHIVE_COLUMNS; column++) {
+        const archiveBuffer *buffer = &block->columns[column];
+
+        if (buffer->length > UINT32_MAX || (buffer->length > 0 && fwrite(buffer->data, buffer->length, 1, writer->file) != 1)) {
+            return 1;
+        }
+        entry->columnSize[column] = (uint32_t) buffer->length;
+        writer->offset += buffer->length;
+    }
+
+    writer->totalBlocks++;
+    return 0;
+}
+
+/**
+ * @brief Writes the block index and the trailer and closes the archive file.
+ * @param writer The writer
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int archiveWriterClose(archiveWriter *writer) {
+    static const char zeros[8];
+    archiveTrailer trailer = {align8(writer->offset), 0, writer->totalBlocks, {'N', 'T', 'C', 'A'}};
+    size_t padding = trailer.indexOffset - writer->offset;
+    bool failed;
+
+    if (writer->file == NULL) {
+        return 1;
+    }
+
+    for (uint32_t blockNumber = 0; blockNumber < writer->totalBlocks; blockNumber++) {
+        trailer.totalGames += writer->index[blockNumber].games;
+    }
+
+    failed = (padding > 0 && fwrite(zeros, padding, 1, writer->file) != 1) ||
+             (writer->totalBlocks > 0 && fwrite(writer->index, sizeof(archiveBlockIndex) * writer->totalBlocks, 1, writer->file) != 1) ||
+             fwrite(&trailer, sizeof(trailer), 1, writer->file) != 1;
+
+    if (fclose(writer->file) != 0) {
+        failed = true;
+    }
+    free(writer->index);
+    memset(writer, 0, sizeof(archiveWriter));
+
+    return failed;
+}
+
+/**
+ * @brief Decodes the varint columns of a block: the game lengths must add up to
+ * the plays of the block, the captures to its captured pawns, and both columns
+ * must end exactly at their size.
+ * @param entry The index entry (its columns fit in the file)
+ * @param block First byte of the block
+ * @param totalCells Cells of the board of the games
+ * @return Returns whether the columns are valid
+ */
+static bool validColumns(const archiveBlockIndex *entry, const unsigned char *block, uint32_t totalCells) {
+    const unsigned char *lengths = block;
+    const unsigned char *lengthsEnd = lengths + entry->columnSize[ARCHIVE_LENGTHS];
+    const unsigned char *captures = block + entry->columnSize[ARCHIVE_LENGTHS] + entry->columnSize[ARCHIVE_DICES] +
+                                    entry->columnSize[ARCHIVE_PAWNS];
+    const unsigned char *capturesEnd = captures + entry->columnSize[ARCHIVE_CAPTURES];
+    uint64_t totalPlays = 0, totalCaptures = 0;
+
+    for (uint32_t game = 0; game < entry->games; game++) {
+        uint32_t plays, events, play = 0;
+
+        if (archiveReadVarint(&lengths, lengthsEnd, &plays) == 1 || plays < entry->minPlays || plays > entry->maxPlays ||
+            archiveReadVarint(&captures, capturesEnd, &events) == 1 || events > entry->captures) {
+            return false;
+        }
+
+        for (uint32_t event = 0; event < events; event++) {
+            uint32_t delta, cell;
+
+            if (archiveReadVarint(&captures, capturesEnd, &delta) == 1 || delta > plays - play ||
+                archiveReadVarint(&captures, capturesEnd, &cell) == 1 || cell >= totalCells) {
+                return false;
+            }
+            play += delta;
+        }
+
+        totalPlays += plays;
+        totalCaptures += events;
+    }
+
+    return lengths == lengthsEnd && captures == capturesEnd && totalPlays == entry->plays && totalCaptures == entry->captures;
+}
+
+/**
+ * @brief Checks that the index entry of a block fits in the file, that its
+ * columns have the sizes of its plays and games, and that they can be decoded.
+ * @param entry The index entry
+ * @param mapping The archive file
+ * @param dataStart Offset of the first block
+ * @param indexOffset Offset of the block index
+ * @param totalCells Cells of the board of the games
+ * @return Returns whether the entry is valid
+ */
+static bool validBlock(const archiveBlockIndex *entry, const void *mapping, uint64_t dataStart, uint64_t indexOffset, uint32_t totalCells) {
+    uint64_t size = 0;
+
+    for (int column = 0; column < ARCHIVE_COLUMNS; column++) {
+        size += entry->columnSize[column];
+    }
+
+    return entry->offset >= dataStart && entry->offset <= indexOffset && size <= indexOffset - entry->offset &&
+           entry->games > 0 && entry->minPlays <= entry->maxPlays &&
+           entry->columnSize[ARCHIVE_DICES] == ((uint64_t) entry->plays + 1) / 2 &&
+           entry->columnSize[ARCHIVE_PAWNS] == ((uint64_t) entry->plays + 3) / 4 &&
+           entry->columnSize[ARCHIVE_OUTCOMES] == ((uint64_t) entry->games + 3) / 4 &&
+           entry->columnSize[ARCHIVE_LENGTHS] >= entry->games &&
+           entry->columnSize[ARCHIVE_CAPTURES] >= entry->games + (uint64_t) entry->captures * 2 &&
+           validColumns(entry, (const unsigned char *) mapping + entry->offset, totalCells);
+}
+
+/**
+ * @brief Maps an archive file in memory, checking its header, index and trailer.
+ * @param fileName The name of the archive file
+ * @param reader Receives the mapped archive
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (missing or invalid file)
+ */
+int archiveReaderOpen(const char *fileName, archiveReader *reader) {
+    const archiveHeader *header;
+    const archiveTrailer *trailer;
+    struct stat fileInfo;
+    uint64_t dataStart, totalGames = 0;
+    int fileDescriptor;
+    void *mapping;
+    size_t size;
+
+    memset(reader, 0, sizeof(archiveReader));
+
+    fileDescriptor = open(fileName, O_RDONLY);
+    if (fileDescriptor < 0) {
+        return 1;
+    }
+
+    if (fstat(fileDescriptor, &fileInfo) != 0 || (size_t) fileInfo.st_size < sizeof(archiveHeader) + sizeof(archiveTrailer)) {
+        close(fileDescriptor);
+        return 1;
+    }
+
+    size = fileInfo.st_size;
+    mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        return 1;
+    }
+
+    // Validates the header and the trailer before using the index
+    header = mapping;
+    trailer = (const archiveTrailer *) ((const char *) mapping + size - sizeof(archiveTrailer));
+    dataStart = sizeof(archiveHeader) + align8(header->totalCells);
+    if (memcmp(header->magic, "NTCA", 4) != 0 || header->version != ARCHIVE_VERSION ||
+        header->totalCells == 0 || header->totalCells != header->rows * 2 + (header->cols - 2) * 2 ||
+        memcmp(trailer->magic, "NTCA", 4) != 0 || trailer->indexOffset % 8 != 0 || trailer->indexOffset < dataStart ||
+        trailer->indexOffset > size - sizeof(archiveTrailer) ||
+        (size - sizeof(archiveTrailer) - trailer->indexOffset) / sizeof(archiveBlockIndex) != trailer->totalBlocks ||
+        (size - sizeof(archiveTrailer) - trailer->indexOffset) % sizeof(archiveBlockIndex) != 0) {
+        munmap(mapping, size);
+        return 1;
+    }
+
+    reader->index = (const archiveBlockIndex *) ((const char *) mapping + trailer->indexOffset);
+    for (uint32_t blockNumber = 0; blockNumber < trailer->totalBlocks; blockNumber++) {
+        if (!validBlock(&reader->index[blockNumber], mapping, dataStart, trailer->indexOffset, header->totalCells)) {
+            munmap(mapping, size);
+            return 1;
+        }
+        totalGames += reader->index[blockNumber].games;
+    }
+
+    if (totalGames != trailer->totalGames) {
+        munmap(mapping, size);
+        return 1;
+    }
+
+    reader->mapping = mapping;
+    reader->size = size;
+    reader->rows = header->rows;
+    reader->cols = header->cols;
+    reader->totalCells = header->totalCells;
+    reader->isSafe = (const unsigned char *) mapping + sizeof(archiveHeader);
+    reader->totalBlocks = trailer->totalBlocks;
+    reader->totalGames = totalGames;
+
+    return 0;
+}
+
+/**
+ * @brief Gets a column of a block.
+ * @param reader The archive
+ * @param blockNumber The block
+ * @param column The column
+ * @return Returns the first byte of the column (its size is in the block index)
+ */
+const unsigned char *archiveColumn(const archiveReader *reader, uint32_t blockNumber, archiveColumnId column) {
+    const archiveBlockIndex *entry = &reader->index[blockNumber];
+    uint64_t offset = entry->offset;
+
+    for (int previous = 0; previous < (int) column; previous++) {
+        offset += entry->columnSize[previous];
+    }
+
+    return (const unsigned char *) reader->mapping + offset;
+}
+
+/**
+ * @brief Unmaps an archive.
+ * @param reader The archive
+ */
+void archiveReaderClose(archiveReader *reader) {
+    if (reader->mapping != NULL) {
+        munmap(reader->mapping, reader->size);
+    }
+    memset(reader, 0, sizeof(archiveReader));
+}
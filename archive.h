@@ -0,0 +1,157 @@
+#ifndef __archive_h__
+#define __archive_h__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "board.h"
+
+#define ARCHIVE_VERSION 1  // Archive file format version
+#define ARCHIVE_BLOCK_GAMES 4096  // Default number of games per block
+
+/**
+ * Columns of a block. Each column holds one kind of data of all the games of
+ * the block, so a query only reads the columns it needs.
+ */
+typedef enum {
+    ARCHIVE_LENGTHS = 0,  // Number of plays of each game (varint)
+    ARCHIVE_DICES = 1,  // Dices value of each play, 4 bits (value less 2)
+    ARCHIVE_PAWNS = 2,  // Pawn of each play (0 to 3), 2 bits, the player alternates starting with P1
+    ARCHIVE_CAPTURES = 3,  // Per game: number of captured pawns, then per pawn the play number delta and the cell (varints)
+    ARCHIVE_OUTCOMES = 4,  // Winner of each game (0 - unfinished, 1 - P1, 2 - P2), 2 bits
+    ARCHIVE_COLUMNS = 5  // Number of columns
+} archiveColumnId;
+
+/**
+ * Index entry of a block: where it is and the ranges of its values, so a
+ * query skips the blocks that can not match.
+ */
+typedef struct {
+    uint64_t offset;  // Offset of the block in the file
+    uint64_t firstGame;  // Number of the first game of the block
+    uint32_t columnSize[ARCHIVE_COLUMNS];  // Bytes of each column, stored in order
+    uint32_t games;  // Number of games
+    uint32_t plays;  // Number of plays of all games
+    uint32_t captures;  // Number of captured pawns of all games
+    uint32_t minPlays, maxPlays;  // Range of the plays of a game
+    uint32_t minCaptureCell, maxCaptureCell;  // Range of the cells where a pawn was captured
+    uint32_t minCapturePlay, maxCapturePlay;  // Range of the plays (from 1) where a pawn was captured
+    uint32_t wins[3];  // Games per outcome (unfinished, P1 won, P2 won)
+    uint32_t reserved;
+} archiveBlockIndex;
+
+/**
+ * Growable byte buffer of a column.
+ */
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} archiveBuffer;
+
+/**
+ * Block being written: the columns of the games recorded so far.
+ */
+typedef struct {
+    archiveBuffer columns[ARCHIVE_COLUMNS];
+    archiveBlockIndex index;
+    archiveBuffer gameCaptures;  // Capture events of the current game (the count goes first)
+    uint32_t gamePlays;  // Plays of the current game
+    uint32_t gameCaptureCount;  // Captured pawns of the current game
+    uint32_t lastCapturePlay;  // Play of the last capture of the current game
+    bool failed;  // Whether an allocation failed
+} archiveBlock;
+
+/**
+ * Archive file being written.
+ */
+typedef struct {
+    FILE *file;
+    uint64_t offset;  // Offset of the next block
+    archiveBlockIndex *index;  // Index of the blocks written
+    uint32_t totalBlocks;
+    uint32_t indexCapacity;
+} archiveWriter;
+
+/**
+ * Archive file mapped in memory (read only).
+ */
+typedef struct {
+    void *mapping;  // The whole archive file, NULL if no archive is open
+    size_t size;  // Size of the mapping in bytes
+    uint32_t totalCells;  // Cells of the board of the games
+    uint32_t rows, cols;  // Dimensions of the board of the games
+    const unsigned char *isSafe;  // 'totalCells' bytes, 1 for a safe cell
+    const archiveBlockIndex *index;  // Index of every block
+    uint32_t totalBlocks;
+    uint64_t totalGames;
+} archiveReader;
+
+void archiveBlockInit(archiveBlock *block);
+void archiveBlockFree(archiveBlock *block);
+void archiveBlockReset(archiveBlock *block, uint64_t firstGame);
+void archiveBeginGame(archiveBlock *block);
+int archiveMakePlay(archiveBlock *block, list *boardCells, char pawn, int dicesValue);
+void archiveEndGame(archiveBlock *block, int winner);
+int archiveWriterOpen(const char *fileName, const unsigned int rows, const unsigned int cols, const list *boardCells, archiveWriter *writer);
+int archiveWriteBlock(archiveWriter *writer, const archiveBlock *block);
+int archiveWriterClose(archiveWriter *writer);
+int archiveReaderOpen(const char *fileName, archiveReader *reader);
+const unsigned char *archiveColumn(const archiveReader *reader, uint32_t blockNumber, archiveColumnId column);
+void archiveReaderClose(archiveReader *reader);
+
+/**
+ * @brief Reads a varint and moves the cursor past it, without reading past the end of the column.
+ * @param cursor Cursor in a column
+ * @param end End of the column (one past its last byte)
+ * @param value Receives the value
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (the varint overruns the column or is longer than 5 bytes)
+ */
+static inline int archiveReadVarint(const unsigned char **cursor, const unsigned char *end, uint32_t *value) {
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 35 && *cursor < end; shift += 7) {
+        unsigned char byte = *(*cursor)++;
+
+        result |= (uint32_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Gets the dices value of a play from the dices column.
+ * @param dices The dices column of a block
+ * @param play Index of the play in the block
+ * @return Returns the dices value (2 to 12)
+ */
+static inline int archiveDices(const unsigned char *dices, uint32_t play) {
+    return (dices[play / 2] >> (play % 2 * 4) & 0x0F) + 2;
+}
+
+/**
+ * @brief Gets the pawn index of a play from the pawns column.
+ * @param pawns The pawns column of a block
+ * @param play Index of the play in the block
+ * @return Returns the pawn index (0 to 3)
+ */
+static inline int archivePawn(const unsigned char *pawns, uint32_t play) {
+    return pawns[play / 4] >> (play % 4 * 2) & 0x03;
+}
+
+/**
+ * @brief Gets the outcome of a game from the outcomes column.
+ * @param outcomes The outcomes column of a block
+ * @param game Index of the game in the block
+ * @return Returns 0 if the game did not finish, 1 if P1 won, 2 if P2 won
+ */
+static inline int archiveOutcome(const unsigned char *outcomes, uint32_t game) {
+    return outcomes[game / 4] >> (game % 4 * 2) & 0x03;
+}
+
+#endif
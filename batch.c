@@ -0,0 +1,234 @@
+#include <stdint.h>
+#include <string.h>
+#include "batch.h"
+#include "simulate.h"
+#include "engine.h"
+#include "rng.h"
+#include "memtrack.h"
+
+/*
+    Structure-of-arrays engine: 'BATCH_GAMES' independent games are advanced
+    together, one play per game in each step.
+
+    Each pawn is stored as its progress (cells walked from its home cell),
+    which turns the rules of 'movePawn', 'pawnCompletesLapInCurrentPlay' and
+    'makePlay' into plain arithmetic for both players:
+        - a pawn with progress 'p' moved 'n' cells completes a lap if p + n >= totalCells
+        - the cells checked for captures are the progress values p + 1 .. min(p + n, totalCells - 1)
+        - an adversary pawn with progress 'a' is at progress (a + totalCells / 2) % totalCells
+          from the moving player home cell
+    A progress equal to 'totalCells' means the pawn is WIN.
+
+    Dices and pawn choices are drawn in the same order as 'simulateGame', and
+    game 'n' is seeded with 'seed + n', so both engines give the same results.
+*/
+
+#define BATCH_PAWNS 8  // Pawns per game, P1 'abcd' then P2 'wxyz'
+
+/**
+ * State of all games of a batch, one array entry per game.
+ */
+typedef struct {
+    int32_t totalCells;
+    unsigned char *safe;  // Safe cells, plus a safe entry at 'totalCells' for WIN pawns ('totalCells' + 1 entries)
+    int32_t progress[BATCH_PAWNS][BATCH_GAMES];  // Progress of each pawn of each game
+    int32_t side[BATCH_GAMES];  // Player to move (0 - P1, 1 - P2)
+    int32_t dice[BATCH_GAMES];  // Dices value of the current step
+    int32_t chosen[BATCH_GAMES];  // Pawn chosen in the current step (0 to 3)
+    int32_t won[BATCH_GAMES];  // Whether the player that just moved won the game
+    int32_t plays[BATCH_GAMES];
+    int32_t captures[BATCH_GAMES];
+    long gameIndex[BATCH_GAMES];  // Index of the game in each slot, -1 if the slot is idle
+    rngState rng[BATCH_GAMES];
+} gameBatch;
+
+
+/**
+ * @brief Starts a new game in a batch slot.
+ * @param batch The batch
+ * @param slot The slot
+ * @param gameIndex Index of the new game
+ * @param seed Base seed of the simulation
+ */
+static void batchStartGame(gameBatch *batch, int slot, long gameIndex, uint64_t seed) {
+    for (int pawn = 0; pawn < BATCH_PAWNS; pawn++) {
+        batch->progress[pawn][slot] = 0;
+    }
+
+    batch->side[slot] = 0;
+    batch->plays[slot] = 0;
+    batch->captures[slot] = 0;
+    batch->won[slot] = 0;
+    batch->gameIndex[slot] = gameIndex;
+    rngSeed(&batch->rng[slot], seed + gameIndex);
+}
+
+/**
+ * @brief Rolls the dices and chooses a random movable pawn for every game of the batch.
+ * @param batch The batch
+ */
+static void batchRollAndChoose(gameBatch *batch) {
+    const int32_t totalCells = batch->totalCells;
+
+    for (int slot = 0; slot < BATCH_GAMES; slot++) {
+        int32_t side = batch->side[slot];
+        int32_t movable = 0;
+        int32_t seen = 0;
+        int32_t pick;
+        int32_t chosen = 0;
+
+        batch->dice[slot] = rngRollDice(&batch->rng[slot], 2);
+
+        for (int pawn = 0; pawn < 4; pawn++) {
+            movable += (side ? batch->progress[4 + pawn][slot] : batch->progress[pawn][slot]) < totalCells;
+        }
+
+        // Picks the 'pick'-th movable pawn, same as 'chooseRandomPawn'
+        pick = rngRange(&batch->rng[slot], movable);
+        for (int pawn = 0; pawn < 4; pawn++) {
+            int32_t isMovable = (side ? batch->progress[4 + pawn][slot] : batch->progress[pawn][slot]) < totalCells;
+
+            chosen = isMovable & (seen == pick) ? pawn : chosen;
+            seen += isMovable;
+        }
+
+        batch->chosen[slot] = chosen;
+    }
+}
+
+/**
+ * @brief Moves the chosen pawn of every game of the batch and captures the
+ * adversary pawns it goes through. Branch free, so the loop can be vectorised.
+ * @param batch The batch
+ */
+static void batchMoveAndCapture(gameBatch *batch) {
+    const int32_t totalCells = batch->totalCells;
+    const int32_t half = totalCells / 2;
+
+    for (int slot = 0; slot < BATCH_GAMES; slot++) {
+        int32_t side = batch->side[slot];
+        int32_t own[4], adversary[4];
+        int32_t current = 0, next, last, captures = 0, won = 1;
+
+        for (int pawn = 0; pawn < 4; pawn++) {
+            own[pawn] = side ? batch->progress[4 + pawn][slot] : batch->progress[pawn][slot];
+            adversary[pawn] = side ? batch->progress[pawn][slot] : batch->progress[4 + pawn][slot];
+            current = batch->chosen[slot] == pawn ? own[pawn] : current;
+        }
+
+        // Move and lap ('movePawn' and 'pawnCompletesLapInCurrentPlay')
+        next = current + batch->dice[slot];
+        last = next < totalCells - 1 ? next : totalCells - 1;
+        next = next >= totalCells ? totalCells : next;
+
+        // Captures ('makePlay'): adversary pawns in the cells walked through that are not safe
+        for (int pawn = 0; pawn < 4; pawn++) {
+            int32_t relative = adversary[pawn] + half;
+            int32_t cell;
+            int32_t captured;
+
+            relative -= relative >= totalCells ? totalCells : 0;
+            cell = side ? adversary[pawn] : relative;
+            captured = (adversary[pawn] < totalCells) & (relative > current) & (relative <= last) & (batch->safe[cell] == 0);
+
+            adversary[pawn] = captured ? 0 : adversary[pawn];
+            captures += captured;
+        }
+
+        for (int pawn = 0; pawn < 4; pawn++) {
+            own[pawn] = batch->chosen[slot] == pawn ? next : own[pawn];
+            won &= own[pawn] == totalCells;
+        }
+
+        for (int pawn = 0; pawn < 4; pawn++) {
+            batch->progress[pawn][slot] = side ? adversary[pawn] : own[pawn];
+            batch->progress[4 + pawn][slot] = side ? own[pawn] : adversary[pawn];
+        }
+
+        batch->won[slot] = won;
+        batch->captures[slot] += captures;
+        batch->plays[slot]++;
+        batch->side[slot] = side ^ 1;
+    }
+}
+
+/**
+ * @brief Simulates several games choosing pawns at random, advancing
+ * 'BATCH_GAMES' games at a time. Gives the same results as 'simulateGames'.
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param safeCells Safe cells read from the config file
+ * @param games Number of games to simulate
+ * @param seed Seed for the dices and pawn choices, game 'n' is seeded with 'seed + n'
+ * @param stats Receives the accumulated results (added to the values it already has)
+ * @param results Array that receives the result of each game (can be NULL)
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int batchSimulateGames(unsigned int rows, unsigned int cols, const safeCellSet *safeCells, long games, uint64_t seed, simulationStats *stats, gameResult *results) {
+    gameBatch batch;
+    int32_t totalCells = rows * 2 + (cols - 2) * 2;
+    long nextGame = 0;  // Index of the next game to start
+    int activeSlots = 0;  // Number of slots with a game in progress
+
+    if (totalCells > MAX_CELLS) {
+        return 1;
+    }
+
+    memset(&batch, 0, sizeof(batch));
+    batch.totalCells = totalCells;
+    batch.safe = memCalloc(NULL, MEM_SAFE_CELLS, totalCells + 1, sizeof(unsigned char));
+    if (batch.safe == NULL) {
+        return 1;
+    }
+    for (int cellIndex = 0; cellIndex < totalCells && cellIndex < safeCells->length; cellIndex++) {
+        batch.safe[cellIndex] = safeCells->isSafe[cellIndex];
+    }
+    batch.safe[0] = batch.safe[totalCells / 2] = batch.safe[totalCells] = 1;
+
+    for (int slot = 0; slot < BATCH_GAMES; slot++) {
+        if (nextGame < games) {
+            batchStartGame(&batch, slot, nextGame++, seed);
+            activeSlots++;
+        } else {
+            batchStartGame(&batch, slot, -1, seed);
+        }
+    }
+
+    while (activeSlots > 0) {
+        batchRollAndChoose(&batch);
+        batchMoveAndCapture(&batch);
+
+        // Finished games are recorded and their slots refilled with new games
+        for (int slot = 0; slot < BATCH_GAMES; slot++) {
+            gameResult result;
+
+            if (batch.gameIndex[slot] < 0 || (!batch.won[slot] && batch.plays[slot] < SIMULATION_MAX_PLAYS)) {
+                continue;
+            }
+
+            // Same as 'simulateGame', a win on the last allowed play is not seen
+            result.winner = batch.won[slot] && batch.plays[slot] < SIMULATION_MAX_PLAYS ? 2 - batch.side[slot] : 0;
+            result.plays = batch.plays[slot];
+            result.captures = batch.captures[slot];
+
+            if (results != NULL) {
+                results[batch.gameIndex[slot]] = result;
+            }
+            stats->games++;
+            stats->p1Wins += result.winner == 1;
+            stats->p2Wins += result.winner == 2;
+            stats->plays += result.plays;
+            stats->captures += result.captures;
+
+            if (nextGame < games) {
+                batchStartGame(&batch, slot, nextGame++, seed);
+            } else {
+                batch.gameIndex[slot] = -1;
+                activeSlots--;
+            }
+        }
+    }
+
+    memFree(NULL, batch.safe);
+    return 0;
+}
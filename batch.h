@@ -0,0 +1,11 @@
+#ifndef __batch_h__
+#define __batch_h__
+
+#include <stdint.h>
+#include "simulate.h"
+
+#define BATCH_GAMES 64  // Number of games advanced together in each step
+
+int batchSimulateGames(unsigned int rows, unsigned int cols, const safeCellSet *safeCells, long games, uint64_t seed, simulationStats *stats, gameResult *results);
+
+#endif
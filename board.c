@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include <assert.h>
 #include <stdlib.h>
 
@@ -6,18 +7,8 @@
 
 
 #define PEAO1 0
-#define PEAO2 1
-#define PEAO3 2
-#define PEAO4 3
-#define DICE_SIZE 6
 
 
-/**
-	Nomeia cada linha quando uma casa e desenhada
-	o topo da casa é o HEADER, e o fundo da casa desenhada é o TAIL
-*/
-typedef enum {HEADER = 0, OCCUPANCY_1 = 1, SAFE_HOUSE = 2, OCCUPANCY_2 = 3, TAIL = 4} line_rendering;
-
 /**
 	Obtem uma determinada casa do tabuleiro que está definido na lista 
 	localizada pela sua posicao
@@ -27,47 +18,176 @@ typedef enum {HEADER = 0, OCCUPANCY_1 = 1, SAFE_HOUSE = 2, OCCUPANCY_2 = 3, TAIL
 */
 casa * listCasaAt(list theBoard, int idx);
 
+/**
+	Obtem o simbolo de um peao numa casa
+	
+	cell - casa do tabuleiro
+	player - jogador dono do peao (JOGADOR1 ou JOGADOR2)
+	pawn - numero do peao (0 a MAX_PAWNS - 1)
+*/
+char pawnSymbol(casa cell, int player, int pawn);
+
+/**
+	Imprime a linha de uma casa com os peoes de um jogador
+	
+	out - destino onde a linha é escrita
+	cell - casa do tabuleiro
+	player - jogador dono dos peoes (JOGADOR1 ou JOGADOR2)
+	pawns - Numero de peoes de cada jogador
+	width - Largura das casas (no minimo pawns - 2)
+*/
+void printCasaPawns(boardWriter *out, casa cell, int player, int pawns, int width);
+
 /**
 	Imprime o conteudo dentro de uma casa do tabuleiro linha a linha
 	Incluindo peoes presentes na casa e simbolo das casas seguras
 	
+	out - destino onde a linha é escrita
 	line - linha da casa a imprimir
 	pos - Numero de posicao da casa a imprimir
 	theBoard - Lista contendo o tabuleiro
+	width - Numero de digitos dos numeros das casas
+*/
+void printCasaLine(boardWriter *out, line_rendering line, int pos, list theBoard, int width);
+
+/**
+	Imprime uma linha de uma casa do tabuleiro, adaptando printCasaLine
+	a boardPrintLayout
+	
+	out - destino onde a linha é escrita
+	line - linha da casa a imprimir
+	pos - Numero de posicao da casa a imprimir
+	data - Lista contendo o tabuleiro
+	width - Numero de digitos dos numeros das casas
+*/
+void printBoardCasaLine(boardWriter *out, line_rendering line, int pos, const void *data, int width);
+
+/**
+	Escreve o tabuleiro no destino dado
+	
+	out - destino onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - imprime a posicao dos peoes se for 1, nao imprime se for 0
+*/
+void boardWrite(boardWriter *out, const unsigned int rows, const unsigned int cols, list theBoard, const int modo);
+
+/**
+	Obtem o numero de digitos necessarios para numerar todas as casas,
+	no minimo 2 (largura das casas nos tabuleiros pequenos)
+	
+	Ncasas - Numero de casas do tabuleiro
+*/
+int cellLabelWidth(int Ncasas);
+
+
+/**
+	Imprime o tabuleiro no ecrã
+	
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - imprime a posicao dos peoes se for 1, nao imprime se for 0
+*/
+void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard, const int modo)
+{
+	boardPrintTo(stdout, rows, cols, theBoard, modo);
+}
+
+/**
+	Escreve o tabuleiro num ficheiro
+	
+	out - ficheiro onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - imprime a posicao dos peoes se for 1, nao imprime se for 0
+*/
+void boardPrintTo(FILE *out, const unsigned int rows, const unsigned int cols, list theBoard, const int modo)
+{
+	boardWriter writer = {out, NULL, 0, 0};
+
+	boardWrite(&writer, rows, cols, theBoard, modo);
+}
+
+/**
+	Escreve o tabuleiro num buffer, cortado e terminado como em snprintf
+	
+	buffer - buffer que recebe o texto (pode ser NULL se size for 0)
+	size - tamanho do buffer
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - imprime a posicao dos peoes se for 1, nao imprime se for 0
+	
+	Devolve o numero de caracteres do tabuleiro (o buffer precisa de mais 1)
 */
-void printCasaLine(line_rendering line, int pos, list theBoard);
+size_t boardPrintToBuffer(char *buffer, size_t size, const unsigned int rows, const unsigned int cols, list theBoard, const int modo)
+{
+	boardWriter writer = {NULL, buffer, size, 0};
+
+	if (size > 0)
+		buffer[0] = '\0';
 
+	boardWrite(&writer, rows, cols, theBoard, modo);
+	return writer.written;
+}
 
 /**
-	Simula o dado do jogo
+	Escreve texto formatado (como printf) no destino
 	
-	numberOfDices - Numero de dados a jogar
+	out - destino do texto
+	format - formato do texto
 */
-int rolldice(int numberOfDices)
+void boardWriterPrintf(boardWriter *out, const char *format, ...)
 {
-	int i, sum;
+	va_list args;
+	size_t room = out->written < out->size ? out->size - out->written : 0;
+	int length;
+
+	va_start(args, format);
+	if (out->file != NULL)
+		length = vfprintf(out->file, format, args);
+	else
+		length = vsnprintf(room > 0 ? out->buffer + out->written : NULL, room, format, args);
+	va_end(args);
+
+	if (length > 0)
+		out->written += length;
+}
 
-	for (i = sum = 0 ; i < numberOfDices ; i++)
+/**
+	Escreve um caracter no destino
+	
+	out - destino do texto
+	c - caracter a escrever
+*/
+void boardWriterPutc(boardWriter *out, char c)
+{
+	if (out->file != NULL)
+		fputc(c, out->file);
+	else if (out->written + 1 < out->size)
 	{
-		sum += rand() % DICE_SIZE + 1;
+		out->buffer[out->written] = c;
+		out->buffer[out->written + 1] = '\0';
 	}
 
-	return sum;
+	out->written++;
 }
 
 /**
-	Imprime o tabuleiro no ecrã
+	Escreve o tabuleiro no destino dado
 	
+	out - destino onde o tabuleiro é escrito
 	rows - Numero de linhas do tabuleiro
 	cols - Numero de colunas do tabuleiro
 	theBoard - Lista que contem as casas do tabuleiro
 	modo - imprime a posicao dos peoes se for 1, nao imprime se for 0
 */
-void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard, const int modo)
+void boardWrite(boardWriter *out, const unsigned int rows, const unsigned int cols, list theBoard, const int modo)
 {
-	unsigned int i, k, pos, right_pos, left_pos, pos_l, pos_r;
-	line_rendering line;
-	node *t;
+	unsigned int i, k;
 	casa *it;
 
 	const int Ncasas = 2*(cols+rows-2);
@@ -75,48 +195,67 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 	assert(rows >= MIN_ROWS && rows % 2 && "Tabuleiro tem de ter no minimo 3 linhas e impar");
 	assert(cols > MIN_COLS && "Numero colunas do tabuleiro tem de ser superior a 4");
 	assert(theBoard.length == Ncasas && "Falha na construcao do tabuleiro, demasiado grande");
-	assert(theBoard.head != NULL && "Falha na construcao do tabuleiro");
+	assert(theBoard.cells != NULL && "Falha na construcao do tabuleiro");
 
 	assert(modo == 0 || modo == 1);
 
 	if (modo)
 	{
-		i = 0;
-		for (t = theBoard.head; (unsigned) i < (unsigned) Ncasas ; t = t-> next, i++)
+		for (i = 0; i < (unsigned) Ncasas ; i++)
 		{
-			it = &(t -> item);
-			printf("%d ", i); 
-
-			if (it->jogador_peao[JOGADOR1][PEAO1])
-				printf("%c", it->jogador_peao[JOGADOR1][PEAO1] == WIN ? SYMBOLS_J1[5]: SYMBOLS_J1[1]);
-
-			if (it->jogador_peao[JOGADOR1][PEAO2])
-				printf("%c", it->jogador_peao[JOGADOR1][PEAO2] == WIN ? SYMBOLS_J1[6]: SYMBOLS_J1[2]);
+			it = &theBoard.cells[i];
+			boardWriterPrintf(out, "%d ", i); 
 
-			if (it->jogador_peao[JOGADOR1][PEAO3])
-				printf("%c", it->jogador_peao[JOGADOR1][PEAO3] == WIN ? SYMBOLS_J1[7]: SYMBOLS_J1[3]);
+			for (k = PEAO1 ; k < (unsigned) theBoard.pawns ; k++)
+				if (casaPawnState(*it, JOGADOR1, k))
+					boardWriterPutc(out, pawnSymbol(*it, JOGADOR1, k));
 
-			if (it->jogador_peao[JOGADOR1][PEAO4])
-				printf("%c", it->jogador_peao[JOGADOR1][PEAO4] == WIN ? SYMBOLS_J1[8]: SYMBOLS_J1[4]);
+			for (k = PEAO1 ; k < (unsigned) theBoard.pawns ; k++)
+				if (casaPawnState(*it, JOGADOR2, k))
+					boardWriterPutc(out, pawnSymbol(*it, JOGADOR2, k));
 
+			boardWriterPutc(out, '.');
+		}
+		boardWriterPutc(out, '\n');
+		return;
+	}
 
-			if (it->jogador_peao[JOGADOR2][PEAO1])
-				printf("%c", it->jogador_peao[JOGADOR2][PEAO1] == WIN ? SYMBOLS_J2[5]: SYMBOLS_J2[1]);
-
-			if (it->jogador_peao[JOGADOR2][PEAO2])
-				printf("%c", it->jogador_peao[JOGADOR2][PEAO2] == WIN ? SYMBOLS_J2[6]: SYMBOLS_J2[2]);
+	/* As casas tem de ter espaco para os peoes de um jogador numa linha */
+	boardPrintLayoutWidth(out, rows, cols, cellLabelWidth(Ncasas) > theBoard.pawns - 2 ? cellLabelWidth(Ncasas) : theBoard.pawns - 2,
+		printBoardCasaLine, &theBoard);
+}
 
-			if (it->jogador_peao[JOGADOR2][PEAO3])
-				printf("%c", it->jogador_peao[JOGADOR2][PEAO3] == WIN ? SYMBOLS_J2[7]: SYMBOLS_J2[3]);
+/**
+	Imprime as casas com a disposicao do tabuleiro, sendo o conteudo
+	de cada casa impresso pela funcao dada
+	
+	out - destino onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	printCasa - funcao que imprime cada linha de uma casa
+	data - dados passados a printCasa
+*/
+void boardPrintLayout(boardWriter *out, const unsigned int rows, const unsigned int cols, casaLinePrinter printCasa, const void *data)
+{
+	boardPrintLayoutWidth(out, rows, cols, cellLabelWidth(2*(cols+rows-2)), printCasa, data);
+}
 
-			if (it->jogador_peao[JOGADOR2][PEAO4])
-				printf("%c", it->jogador_peao[JOGADOR2][PEAO4] == WIN ? SYMBOLS_J2[8]: SYMBOLS_J2[4]);
+/**
+	Imprime as casas com a disposicao do tabuleiro, com a largura dada
+	
+	out - destino onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	width - Largura das casas (cada casa tem width + 6 caracteres), no minimo a dos numeros das casas
+	printCasa - funcao que imprime cada linha de uma casa
+	data - dados passados a printCasa
+*/
+void boardPrintLayoutWidth(boardWriter *out, const unsigned int rows, const unsigned int cols, const int width, casaLinePrinter printCasa, const void *data)
+{
+	unsigned int i, k, pos, right_pos, left_pos, pos_l, pos_r;
+	line_rendering line;
 
-			putchar('.');
-		}
-		putchar('\n');
-		return;
-	}
+	const int Ncasas = 2*(cols+rows-2);
 
 	/* print first line */
 	/* first line starts in position floor(rows/2) */
@@ -124,8 +263,8 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 	{
 		pos = rows/2;
 		for (i = 0 ; i < cols ; i++, pos++)
-			printCasaLine(line, pos, theBoard);
-		putchar('\n');
+			printCasa(out, line, pos, data, width);
+		boardWriterPutc(out, '\n');
 	}
 
 	/* print intermediate top lines down to middle line inclusive */
@@ -140,13 +279,13 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 			for (k = 0 ; k < cols ; k++)
 			{
 				if (k == 0)
-					printCasaLine(line, pos_l, theBoard);
+					printCasa(out, line, pos_l, data, width);
 				else if (k == cols-1)
-					printCasaLine(line, pos_r, theBoard);
+					printCasa(out, line, pos_r, data, width);
 				else
-					printf("        ");
+					boardWriterPrintf(out, "%*s", width + 6, "");
 			}
-			putchar('\n');
+			boardWriterPutc(out, '\n');
 		}
 	}
 
@@ -161,13 +300,13 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 			for (k = 0 ; k < cols ; k++)
 			{
 				if (k == 0)
-					printCasaLine(line, pos_l, theBoard);
+					printCasa(out, line, pos_l, data, width);
 				else if (k == cols-1)
-					printCasaLine(line, pos_r, theBoard);
+					printCasa(out, line, pos_r, data, width);
 				else
-					printf("        ");				
+					boardWriterPrintf(out, "%*s", width + 6, "");				
 			}
-			putchar('\n');
+			boardWriterPutc(out, '\n');
 		}
 	}
 	
@@ -176,10 +315,25 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 	{
 		pos = left_pos;
 		for (i = 0 ; i < cols ; i++, pos--)
-			printCasaLine(line, pos, theBoard);
-		putchar('\n');
+			printCasa(out, line, pos, data, width);
+		boardWriterPutc(out, '\n');
 	}
-	fflush(stdout);
+}
+
+/**
+	Obtem o numero de digitos necessarios para numerar todas as casas,
+	no minimo 2 (largura das casas nos tabuleiros pequenos)
+	
+	Ncasas - Numero de casas do tabuleiro
+*/
+int cellLabelWidth(int Ncasas)
+{
+	int width = 1;
+
+	for (int last = Ncasas - 1; last >= 10; last /= 10)
+		width++;
+
+	return width < 2 ? 2 : width;
 }
 
 /**
@@ -191,27 +345,75 @@ void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard,
 */
 casa * listCasaAt(list theBoard, int idx)
 {
-	/* ponteiro para um node da lista */
-	node *t;
+	return idx >= 0 && idx < theBoard.length ? &theBoard.cells[idx] : NULL;
+}
+
+/**
+	Obtem o simbolo de um peao numa casa: a letra do peao, em maiuscula se
+	o peao ja deu a volta, ou espaco se o peao nao esta na casa
 	
-	/* iterador do ciclo for */
-	int i;
+	cell - casa do tabuleiro
+	player - jogador dono do peao (JOGADOR1 ou JOGADOR2)
+	pawn - numero do peao (0 a MAX_PAWNS - 1)
+*/
+char pawnSymbol(casa cell, int player, int pawn)
+{
+	const char *symbols = player == JOGADOR1 ? SYMBOLS_J1 : SYMBOLS_J2;
+
+	switch (casaPawnState(cell, player, pawn))
+	{
+		case TRUE:
+			return symbols[pawn + 1];
+		case WIN:
+			return symbols[pawn + 1 + MAX_PAWNS];
+		default:
+			return symbols[0];
+	}
+}
 
-	for (t = theBoard.head, i = 0 ; t != NULL && i < idx ; t = t-> next, i++)
-		;
+/**
+	Imprime a linha de uma casa com os peoes de um jogador
+	
+	out - destino onde a linha é escrita
+	cell - casa do tabuleiro
+	player - jogador dono dos peoes (JOGADOR1 ou JOGADOR2)
+	pawns - Numero de peoes de cada jogador
+	width - Largura das casas (no minimo pawns - 2)
+*/
+void printCasaPawns(boardWriter *out, casa cell, int player, int pawns, int width)
+{
+	boardWriterPrintf(out, "| ");
+	for (int k = PEAO1 ; k < pawns ; k++)
+		boardWriterPutc(out, pawnSymbol(cell, player, k));
+	boardWriterPrintf(out, "%*s|", width + 3 - pawns, "");
+}
 
-	return t != NULL ? &(t -> item) : NULL;
+/**
+	Imprime uma linha de uma casa do tabuleiro, adaptando printCasaLine
+	a boardPrintLayout
+	
+	out - destino onde a linha é escrita
+	line - linha da casa a imprimir
+	pos - Numero de posicao da casa a imprimir
+	data - Lista contendo o tabuleiro
+	width - Numero de digitos dos numeros das casas
+*/
+void printBoardCasaLine(boardWriter *out, line_rendering line, int pos, const void *data, int width)
+{
+	printCasaLine(out, line, pos, *(const list *) data, width);
 }
 
 /**
 	Imprime o conteudo dentro de uma casa do tabuleiro linha a linha
 	Incluindo peoes presentes na casa e simbolo das casas seguras
 	
+	out - destino onde a linha é escrita
 	line - linha da casa a imprimir
 	pos - Numero de posicao da casa a imprimir
 	theBoard - Lista contendo o tabuleiro
+	width - Numero de digitos dos numeros das casas
 */
-void printCasaLine(line_rendering line, int pos, list theBoard)
+void printCasaLine(boardWriter *out, line_rendering line, int pos, list theBoard, int width)
 {
 	/* Valor temporario da casa do tabuleiro que esta a ser processada */
 	casa *it;
@@ -219,67 +421,30 @@ void printCasaLine(line_rendering line, int pos, list theBoard)
 	switch(line)
 	{
 		case HEADER: /* imprime numero da casa na linha 0 */
-			printf("+--%2d--+", pos);
+			boardWriterPrintf(out, "+--%*d--+", width, pos);
 			break;
 		case OCCUPANCY_1: /* imprime peoes do jogador 1 presentes, na linha 1 */
 			it = listCasaAt(theBoard, pos);
 			assert(it != NULL);
-			printf("| %c%c%c%c |", 
-				it->jogador_peao[JOGADOR1][PEAO1] ? 
-					(it->jogador_peao[JOGADOR1][PEAO1] == WIN ? 
-						SYMBOLS_J1[5]:
-						SYMBOLS_J1[1]):
-					SYMBOLS_J1[0],
-				it->jogador_peao[JOGADOR1][PEAO2] ?
-					(it->jogador_peao[JOGADOR1][PEAO2] == WIN ?
-						SYMBOLS_J1[6]:
-						SYMBOLS_J1[2]):
-					SYMBOLS_J1[0],
-				it->jogador_peao[JOGADOR1][PEAO3] ?
-					(it->jogador_peao[JOGADOR1][PEAO3] == WIN ?
-						SYMBOLS_J1[7]:
-						SYMBOLS_J1[3]):
-					SYMBOLS_J1[0],
-				it->jogador_peao[JOGADOR1][PEAO4] ?
-					(it->jogador_peao[JOGADOR1][PEAO4] == WIN ?
-						SYMBOLS_J1[8]:
-						SYMBOLS_J1[4]):
-					SYMBOLS_J1[0]);
+			printCasaPawns(out, *it, JOGADOR1, theBoard.pawns, width);
 			break;
 		case SAFE_HOUSE: /* imprime se casa e segura, na linha 2 */
 			it = listCasaAt(theBoard, pos);
 			assert(it != NULL);
-			if (it->casaSegura)
-				printf("| **** |");
+			if (casaIsSafe(*it))
+				boardWriterPrintf(out, "| **** %*s|", width - 2, "");
 			else
-				printf("|      |");
+				boardWriterPrintf(out, "|%*s|", width + 4, "");
 			break;
 		case OCCUPANCY_2: /* imprime peoes do jogador 2 presentes, na linha 3 */
 			it = listCasaAt(theBoard, pos);
 			assert(it != NULL);
-			printf("| %c%c%c%c |", 
-				it->jogador_peao[JOGADOR2][PEAO1] ?
-					(it->jogador_peao[JOGADOR2][PEAO1] == WIN ?
-						SYMBOLS_J2[5]:
-						SYMBOLS_J2[1]):
-					SYMBOLS_J2[0],
-				it->jogador_peao[JOGADOR2][PEAO2] ?
-					(it->jogador_peao[JOGADOR2][PEAO2] == WIN ?
-						SYMBOLS_J2[6]:
-						SYMBOLS_J2[2]):
-					SYMBOLS_J2[0],
-				it->jogador_peao[JOGADOR2][PEAO3] ?
-					(it->jogador_peao[JOGADOR2][PEAO3] == WIN ?
-						SYMBOLS_J2[7]:
-						SYMBOLS_J2[3]):
-					SYMBOLS_J2[0],
-				it->jogador_peao[JOGADOR2][PEAO4] ?
-					(it->jogador_peao[JOGADOR2][PEAO4] == WIN ?
-						SYMBOLS_J2[8]:
-						SYMBOLS_J2[4]):
-					SYMBOLS_J2[0]);
+			printCasaPawns(out, *it, JOGADOR2, theBoard.pawns, width);
 			break;
 		case TAIL:
-			printf("+------+");
+			boardWriterPutc(out, '+');
+			for (int k = 0; k < width + 4; k++)
+				boardWriterPutc(out, '-');
+			boardWriterPutc(out, '+');
 	}
 }
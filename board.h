@@ -1,14 +1,26 @@
 #ifndef __BOARD_H__
 #define __BOARD_H__
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 // definicoes que podem, ou nao, ser uteis:
-#define SYMBOLS_J1 " abcdABCD"
-#define SYMBOLS_J2 " wxyzWXYZ"
+#define SYMBOLS_J1 " abcdefiABCDEFI"
+#define SYMBOLS_J2 " wxyzvutWXYZVUT"
 #define JOGADOR1 0
 #define JOGADOR2 1
 #define MIN_ROWS 3
 #define MIN_COLS 4
 
+/* Peoes por jogador: o jogo normal tem 4, podem ser configurados de 1 a MAX_PAWNS */
+#define STANDARD_PAWNS 4
+#define MAX_PAWNS 7
+
+/* Dados lancados em cada jogada: o jogo normal tem 2, podem ser configurados de 1 a MAX_DICES */
+#define STANDARD_DICES 2
+#define MAX_DICES 4
+
 
 
 // mensagem que deve ser apresentada qundo os parametros do main nao sao validos
@@ -28,6 +40,12 @@
 // mensagem apresentada se a leitur do ficheiro falhar
 #define FILE_ERR2 "Erro na leitura do ficheiro\n"
 
+// mensagens apresentadas ao gravar/restaurar o jogo
+#define SAVE_OK "Jogo gravado"
+#define SAVE_ERR "Erro ao gravar o jogo"
+#define LOAD_OK "Jogo restaurado"
+#define LOAD_ERR "Erro ao restaurar o jogo"
+
 #define PL1_MOVE "------ Jogador 1 ------"
 #define PL2_MOVE "------ Jogador 2 ------"
 
@@ -41,51 +59,174 @@
 typedef enum {FALSE = 0, TRUE = 1, WIN = 2} state;
 
 /**
-	Casa de um tabuleiro
+	Casa de um tabuleiro, guardada numa unica palavra de 32 bits
+	
+	bits 0-6   - peoes 1 a 7 do jogador 1 presentes na casa (TRUE)
+	bits 7-13  - peoes 1 a 7 do jogador 2 presentes na casa (TRUE)
+	bits 14-20 - peoes 1 a 7 do jogador 1 que ja deram a volta (WIN)
+	bits 21-27 - peoes 1 a 7 do jogador 2 que ja deram a volta (WIN)
+	bit 28     - indica se a casa é segura e nao podem comer os peoes
+	
+	Os bits dos peoes alem do numero de peoes do jogo ficam sempre a 0.
+	Deve ser acedida atraves das funcoes casa*
+*/
+typedef uint32_t casa;
+
+#define CASA_PAWN_PRESENT(player, pawn) ((casa) 1 << ((player) * MAX_PAWNS + (pawn)))
+#define CASA_PAWN_WIN(player, pawn) ((casa) 1 << (2 * MAX_PAWNS + (player) * MAX_PAWNS + (pawn)))
+#define CASA_PLAYER_PAWNS(player) ((((casa) 1 << MAX_PAWNS) - 1) << ((player) * MAX_PAWNS))
+#define CASA_PLAYER_WINS(player, pawns) ((((casa) 1 << (pawns)) - 1) << (2 * MAX_PAWNS + (player) * MAX_PAWNS))
+#define CASA_SAFE ((casa) 1 << (4 * MAX_PAWNS))
+
+/**
+	Tabuleiro: bloco contiguo com todas as casas, pela ordem do percurso
 */
-typedef struct
+typedef struct list
 {
-	/** jogador 1 e 2 e seus peoes 1 a 4 presentes TRUE ou nao FALSE */
-	state jogador_peao[2][4];
+	/* Casas do tabuleiro, a casa 0 é a casa mae do jogador 1 */
+	casa * cells;
 	
-	/** Indica se a casa é segura e nao podem comer os peoes */
-	state casaSegura;
-} casa;
+	/* Numero de casas do tabuleiro */
+	int length;
+
+	/* Peoes por jogador (1 a MAX_PAWNS) e dados por jogada (1 a MAX_DICES), definidos antes do boardSetup */
+	int pawns;
+	int dices;
+
+	/* Indice de posicao: casa onde esta cada peao, por jogador (JOGADOR1 ou JOGADOR2) e peao (0 a pawns - 1) */
+	int pawnCells[2][MAX_PAWNS];
+
+	/* Jogada especializada para o numero de casas e de peoes, escolhida no boardSetup */
+	int (*play)(struct list * boardCells, char pawn, int amount);
+
+	/* Contabilidade da memoria das casas (NULL se nao for contabilizada), passa para as copias */
+	struct memTracker * memory;
+} list;
+
 
 /**
-	Node de uma lista, que contem a casa de um tabuleiro
+	Obtem o estado de um peao numa casa
+	
+	cell - casa do tabuleiro
+	player - jogador dono do peao (JOGADOR1 ou JOGADOR2)
+	pawn - numero do peao (0 a MAX_PAWNS - 1)
 */
-typedef struct _node
+static inline state casaPawnState(casa cell, int player, int pawn)
 {
-	/* informação retida numa cada do tabuleiro */
-	casa item;
+	if (cell & CASA_PAWN_PRESENT(player, pawn))
+		return TRUE;
+
+	return cell & CASA_PAWN_WIN(player, pawn) ? WIN : FALSE;
+}
+
+/**
+	Altera o estado de um peao numa casa
 	
-	/* Ponteiro para a proxima "node", proxima casa do tabuleiro */
-	struct _node * next;
-} node;
+	cell - casa do tabuleiro
+	player - jogador dono do peao (JOGADOR1 ou JOGADOR2)
+	pawn - numero do peao (0 a MAX_PAWNS - 1)
+	pawnState - novo estado do peao
+*/
+static inline void casaSetPawnState(casa *cell, int player, int pawn, state pawnState)
+{
+	*cell &= ~(CASA_PAWN_PRESENT(player, pawn) | CASA_PAWN_WIN(player, pawn));
+
+	if (pawnState == TRUE)
+		*cell |= CASA_PAWN_PRESENT(player, pawn);
+	else if (pawnState == WIN)
+		*cell |= CASA_PAWN_WIN(player, pawn);
+}
 
 /**
-	Lista de "nodes", é uma lista de casas, e logo um tabuleiro
+	Indica se a casa é segura (TRUE) ou nao (FALSE)
+	
+	cell - casa do tabuleiro
 */
-typedef struct 
+static inline state casaIsSafe(casa cell)
 {
-	/* Ponteiro para o primeiro "node" da lista, a primeira casa do tabuleiro */
-	node * head;
+	return cell & CASA_SAFE ? TRUE : FALSE;
+}
+
+/**
+	Altera a indicacao de casa segura
 	
-	/* Ponteiro para o ultimo "node" da lista, a ultima casa do tabuleiro */
-	node * tail;
+	cell - casa do tabuleiro
+	safe - TRUE se a casa é segura, FALSE se nao
+*/
+static inline void casaSetSafe(casa *cell, state safe)
+{
+	*cell = safe ? *cell | CASA_SAFE : *cell & ~CASA_SAFE;
+}
+
+
+/**
+	Nomeia cada linha quando uma casa e desenhada
+	o topo da casa é o HEADER, e o fundo da casa desenhada é o TAIL
+*/
+typedef enum {HEADER = 0, OCCUPANCY_1 = 1, SAFE_HOUSE = 2, OCCUPANCY_2 = 3, TAIL = 4} line_rendering;
+
+/**
+	Destino do texto do tabuleiro: um ficheiro ou um buffer do chamador.
+	No buffer o texto e cortado e terminado como em snprintf, e 'written'
+	conta o texto todo (o buffer precisa de written + 1 bytes)
+*/
+typedef struct {
+	FILE *file;	/* ficheiro onde o texto é escrito, NULL para escrever no buffer */
+	char *buffer;	/* buffer que recebe o texto (pode ser NULL se size for 0) */
+	size_t size;	/* tamanho do buffer */
+	size_t written;	/* numero de caracteres do texto */
+} boardWriter;
+
+/**
+	Escreve texto formatado (como printf) no destino
 	
-	/* Numero de nodes ou numero de casas do tabuleiro */
-	int length;
-} list;
+	out - destino do texto
+	format - formato do texto
+*/
+void boardWriterPrintf(boardWriter *out, const char *format, ...);
+
+/**
+	Escreve um caracter no destino
+	
+	out - destino do texto
+	c - caracter a escrever
+*/
+void boardWriterPutc(boardWriter *out, char c);
+
+/**
+	Imprime uma linha de uma casa, usada por boardPrintLayout
+	
+	out - destino onde a linha é escrita
+	line - linha da casa a imprimir
+	pos - Numero de posicao da casa a imprimir
+	data - dados a apresentar nas casas
+	width - Numero de digitos dos numeros das casas (cada casa tem width + 6 caracteres)
+*/
+typedef void (*casaLinePrinter)(boardWriter *out, line_rendering line, int pos, const void *data, int width);
 
+/**
+	Imprime as casas com a disposicao do tabuleiro, sendo o conteudo
+	de cada casa impresso pela funcao dada
+	
+	out - destino onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	printCasa - funcao que imprime cada linha de uma casa
+	data - dados passados a printCasa
+*/
+void boardPrintLayout(boardWriter *out, const unsigned int rows, const unsigned int cols, casaLinePrinter printCasa, const void *data);
 
 /**
-	Simula o dado do jogo
+	Imprime as casas com a disposicao do tabuleiro, com a largura dada
 	
-	numberOfDices - Numero de dados a jogar
+	out - destino onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	width - Largura das casas (cada casa tem width + 6 caracteres), no minimo a dos numeros das casas
+	printCasa - funcao que imprime cada linha de uma casa
+	data - dados passados a printCasa
 */
-int rolldice(int numberOfDices);
+void boardPrintLayoutWidth(boardWriter *out, const unsigned int rows, const unsigned int cols, const int width, casaLinePrinter printCasa, const void *data);
 
 /**
 	Imprime o tabuleiro no ecrã
@@ -97,4 +238,29 @@ int rolldice(int numberOfDices);
 */
 void boardPrint(const unsigned int rows, const unsigned int cols, list theBoard, const int modo);
 
+/**
+	Escreve o tabuleiro num ficheiro (boardPrint escreve no ecrã)
+	
+	out - ficheiro onde o tabuleiro é escrito
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - modo de apresentação do tabuleiro
+*/
+void boardPrintTo(FILE *out, const unsigned int rows, const unsigned int cols, list theBoard, const int modo);
+
+/**
+	Escreve o tabuleiro num buffer, cortado e terminado como em snprintf
+	
+	buffer - buffer que recebe o texto (pode ser NULL se size for 0)
+	size - tamanho do buffer
+	rows - Numero de linhas do tabuleiro
+	cols - Numero de colunas do tabuleiro
+	theBoard - Lista que contem as casas do tabuleiro
+	modo - modo de apresentação do tabuleiro
+	
+	Devolve o numero de caracteres do tabuleiro (o buffer precisa de mais 1)
+*/
+size_t boardPrintToBuffer(char *buffer, size_t size, const unsigned int rows, const unsigned int cols, list theBoard, const int modo);
+
 #endif
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "book.h"
+#include "board.h"
+
+/*
+    Book file layout (host byte order, the file is mapped as is):
+        0..3    magic "NTCB"
+        4..7    format version
+        8..11   number of board cells
+        12..15  number of index bits 'b'
+        16..19  number of pawns of each player
+        20..23  number of dices
+        24..31  hash of the safe cells
+        32..39  number of entries 'n'
+        40..    bucket index: 2^b + 1 entry offsets (uint32), never decreasing, the last one is 'n'
+        then    'n' entries (16 bytes each), sorted by key, starting at an 8 byte boundary
+
+    Keys are hashes, so the top 'b' bits spread the entries evenly over the
+    buckets: a probe reads the bucket offsets and compares about one entry.
+*/
+
+/**
+ * Book file header.
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t totalCells;
+    uint32_t indexBits;
+    uint32_t pawns;
+    uint32_t dices;
+    uint64_t safeHash;
+    uint64_t totalEntries;
+} bookHeader;
+
+
+/**
+ * @brief Mixes a 64 bit value (splitmix64 finaliser).
+ * @param value The value
+ * @return Returns the mixed value
+ */
+static uint64_t mix64(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Hashes the safe cells of a board, so a book is only used with the board it was built for.
+ * @param boardCells Board with all cells
+ * @return Returns the hash
+ */
+static uint64_t safeCellsHash(const list *boardCells) {
+    uint64_t hash = 0xCBF29CE484222325ULL;  // FNV-1a
+
+    for (int cellIndex = 0; cellIndex < boardCells->length; cellIndex++) {
+        hash = (hash ^ casaIsSafe(boardCells->cells[cellIndex])) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Gets the bucket of a key.
+ * @param key The key
+ * @param indexBits Number of index bits
+ * @return Returns the bucket
+ */
+static uint64_t bookBucket(uint64_t key, int indexBits) {
+    return indexBits == 0 ? 0 : key >> (64 - indexBits);
+}
+
+/**
+ * @brief Gets the offset of the first entry in the book file.
+ * @param indexBits Number of index bits
+ * @return Returns the offset in bytes
+ */
+static size_t entriesOffset(int indexBits) {
+    size_t offset = sizeof(bookHeader) + sizeof(uint32_t) * (((size_t) 1 << indexBits) + 1);
+
+    return (offset + 7) & ~(size_t) 7;
+}
+
+/**
+ * @brief Compares two book entries by key (for 'qsort').
+ * @param first The first entry
+ * @param second The second entry
+ * @return Returns -1, 0 or 1
+ */
+static int compareEntries(const void *first, const void *second) {
+    uint64_t firstKey = ((const bookEntry *) first)->key;
+    uint64_t secondKey = ((const bookEntry *) second)->key;
+
+    return (firstKey > secondKey) - (firstKey < secondKey);
+}
+
+/**
+ * @brief Gets the key of a position: pawn cells and WIN pawns, player to move and dices value.
+ * Keys of boards with a different number of pawns are unrelated (a book is only opened with its rules).
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1 to move
+ * @param dicesValue The dices value (0 for the position alone)
+ * @return Returns the key
+ */
+uint64_t bookKey(const list *boardCells, bool player1, int dicesValue) {
+    uint64_t key = mix64((uint64_t) (player1 ? 1 : 2) << 8 | (uint64_t) dicesValue);
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIdx = 0; pawnIdx < boardCells->pawns; pawnIdx++) {
+            int cellIndex = boardCells->pawnCells[player][pawnIdx];
+            uint64_t pawnValue = (uint64_t) cellIndex << 1 | (casaPawnState(boardCells->cells[cellIndex], player, pawnIdx) == WIN);
+
+            key = mix64(key ^ pawnValue);
+        }
+    }
+
+    return key;
+}
+
+/**
+ * @brief Writes a book file. The entries are sorted by key and indexed by bucket.
+ * @param fileName The name of the book file
+ * @param boardCells Board the book was built for (cells, safe cells, pawns and dices)
+ * @param entries The entries, sorted in place (keys must be unique)
+ * @param totalEntries Number of entries
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int bookWrite(const char *fileName, const list *boardCells, bookEntry *entries, long totalEntries) {
+    static const char zeros[8];
+    bookHeader header = {{'N', 'T', 'C', 'B'}, BOOK_VERSION, 0, 0, 0, 0, 0, 0};
+    uint32_t *index;
+    size_t indexSize;
+    size_t padding;  // Bytes between the index and the entries
+    bool failed;
+    long entry = 0;
+    FILE *file;
+
+    if (totalEntries < 0 || totalEntries > UINT32_MAX) {
+        return 1;
+    }
+
+    // About one entry per bucket
+    while (header.indexBits < BOOK_MAX_INDEX_BITS && ((long) 1 << header.indexBits) < totalEntries) {
+        header.indexBits++;
+    }
+    header.totalCells = boardCells->length;
+    header.pawns = boardCells->pawns;
+    header.dices = boardCells->dices;
+    header.safeHash = safeCellsHash(boardCells);
+    header.totalEntries = totalEntries;
+
+    qsort(entries, totalEntries, sizeof(bookEntry), compareEntries);
+
+    indexSize = ((size_t) 1 << header.indexBits) + 1;
+    index = malloc(sizeof(uint32_t) * indexSize);
+    if (index == NULL) {
+        return 1;
+    }
+
+    for (size_t bucket = 0; bucket < indexSize; bucket++) {
+        while (entry < totalEntries && bookBucket(entries[entry].key, header.indexBits) < bucket) {
+            entry++;
+        }
+        index[bucket] = (uint32_t) entry;
+    }
+    index[indexSize - 1] = (uint32_t) totalEntries;
+
+    file = fopen(fileName, "wb");
+    if (file == NULL) {
+        free(index);
+        return 1;
+    }
+
+    padding = entriesOffset(header.indexBits) - sizeof(header) - sizeof(uint32_t) * indexSize;
+    failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+             fwrite(index, sizeof(uint32_t) * indexSize, 1, file) != 1 ||
+             (padding > 0 && fwrite(zeros, padding, 1, file) != 1) ||
+             (totalEntries > 0 && fwrite(entries, sizeof(bookEntry) * totalEntries, 1, file) != 1);
+
+    free(index);
+    if (fclose(file) != 0 || failed) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Maps a book file in memory and checks it was built for the given board.
+ * @param fileName The name of the book file
+ * @param boardCells Board the book will be used with
+ * @param book Receives the mapped book
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (missing, invalid or built for another board or rules)
+ */
+int bookOpen(const char *fileName, const list *boardCells, openingBook *book) {
+    const bookHeader *header;
+    size_t totalBuckets;
+    struct stat fileInfo;
+    int fileDescriptor;
+    void *mapping;
+
+    book->mapping = NULL;
+
+    fileDescriptor = open(fileName, O_RDONLY);
+    if (fileDescriptor < 0) {
+        return 1;
+    }
+
+    if (fstat(fileDescriptor, &fileInfo) != 0 || (size_t) fileInfo.st_size < sizeof(bookHeader)) {
+        close(fileDescriptor);
+        return 1;
+    }
+
+    mapping = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        return 1;
+    }
+
+    // Validates the header and the file size before using the index
+    header = mapping;
+    if (memcmp(header->magic, "NTCB", 4) != 0 || header->version != BOOK_VERSION ||
+        header->totalCells != (uint32_t) boardCells->length || header->safeHash != safeCellsHash(boardCells) ||
+        header->pawns != (uint32_t) boardCells->pawns || header->dices != (uint32_t) boardCells->dices ||
+        header->indexBits > BOOK_MAX_INDEX_BITS ||
+        (size_t) fileInfo.st_size != entriesOffset(header->indexBits) + sizeof(bookEntry) * header->totalEntries) {
+        munmap(mapping, fileInfo.st_size);
+        return 1;
+    }
+
+    // The bucket offsets must never decrease and stay within the entries, 'bookProbe' relies on it
+    book->index = (const uint32_t *) ((const char *) mapping + sizeof(bookHeader));
+    totalBuckets = (size_t) 1 << header->indexBits;
+    for (size_t bucket = 0; bucket <= totalBuckets; bucket++) {
+        if (book->index[bucket] > header->totalEntries || (bucket > 0 && book->index[bucket] < book->index[bucket - 1]) ||
+            (bucket == totalBuckets && book->index[bucket] != header->totalEntries)) {
+            munmap(mapping, fileInfo.st_size);
+            return 1;
+        }
+    }
+
+    book->mapping = mapping;
+    book->size = fileInfo.st_size;
+    book->indexBits = header->indexBits;
+    book->entries = (const bookEntry *) ((const char *) mapping + entriesOffset(header->indexBits));
+
+    return 0;
+}
+
+/**
+ * @brief Looks up a position in the book.
+ * @param book The book (may have no book open)
+ * @param key The position key (see 'bookKey')
+ * @return Returns the book entry, NULL if the position is not in the book
+ */
+const bookEntry *bookProbe(const openingBook *book, uint64_t key) {
+    uint64_t bucket;
+
+    if (book == NULL || book->mapping == NULL) {
+        return NULL;
+    }
+
+    bucket = bookBucket(key, book->indexBits);
+    for (uint32_t entry = book->index[bucket]; entry < book->index[bucket + 1]; entry++) {
+        if (book->entries[entry].key == key) {
+            return &book->entries[entry];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Unmaps a book.
+ * @param book The book
+ */
+void bookClose(openingBook *book) {
+    if (book->mapping != NULL) {
+        munmap(book->mapping, book->size);
+    }
+    book->mapping = NULL;
+}
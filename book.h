@@ -0,0 +1,39 @@
+#ifndef __book_h__
+#define __book_h__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+
+#define BOOK_VERSION 2  // Book file format version
+#define BOOK_MAX_INDEX_BITS 24  // Max number of bits of the book bucket index
+
+/**
+ * Book entry: best pawn for a position and dices value.
+ */
+typedef struct {
+    uint64_t key;  // Position key (see 'bookKey')
+    uint16_t score;  // Win rate of the chosen pawn, scaled to 0..65535
+    char pawn;  // Pawn to play
+    uint8_t reserved[5];
+} bookEntry;
+
+/**
+ * Opening book mapped in memory (read only).
+ */
+typedef struct {
+    void *mapping;  // The whole book file, NULL if no book is open
+    size_t size;  // Size of the mapping in bytes
+    const uint32_t *index;  // First entry of each bucket, plus the number of entries
+    const bookEntry *entries;  // Entries sorted by key
+    int indexBits;  // The bucket of a key is its top 'indexBits' bits
+} openingBook;
+
+uint64_t bookKey(const list *boardCells, bool player1, int dicesValue);
+int bookWrite(const char *fileName, const list *boardCells, bookEntry *entries, long totalEntries);
+int bookOpen(const char *fileName, const list *boardCells, openingBook *book);
+const bookEntry *bookProbe(const openingBook *book, uint64_t key);
+void bookClose(openingBook *book);
+
+#endif
@@ -0,0 +1,99 @@
+#include "capture.h"
+#include "board.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief Finds the cells with capturable pawns, one cell at a time.
+ * A cell is capturable when it holds any of the pawns in 'pawnsMask' and is not a safe cell.
+ * @param cells The board cells
+ * @param first Index of the first cell to check
+ * @param count Number of cells to check
+ * @param pawnsMask Pawns that can be captured (the adversary 'CASA_PLAYER_PAWNS' bits)
+ * @param found Array with at least 'count' positions that receives the capturable cells, in order
+ * @return Returns the number of capturable cells found
+ */
+int captureScanScalar(const casa *cells, int first, int count, casa pawnsMask, int *found) {
+    int totalFound = 0;
+
+    for (int cellIndex = first; cellIndex < first + count; cellIndex++) {
+        if ((cells[cellIndex] & pawnsMask) != 0 && (cells[cellIndex] & CASA_SAFE) == 0) {
+            found[totalFound++] = cellIndex;
+        }
+    }
+
+    return totalFound;
+}
+
+/**
+ * @brief Finds the cells with capturable pawns, checking a whole block of cells
+ * with vector compares (AVX2 or SSE2, scalar fallback otherwise). Gives the same
+ * result as 'captureScanScalar'. The cells array must have 'CAPTURE_SCAN_PADDING'
+ * cells after the last cell.
+ * @param cells The board cells
+ * @param first Index of the first cell to check
+ * @param count Number of cells to check
+ * @param pawnsMask Pawns that can be captured (the adversary 'CASA_PLAYER_PAWNS' bits)
+ * @param found Array with at least 'count' positions that receives the capturable cells, in order
+ * @return Returns the number of capturable cells found
+ */
+int captureScan(const casa *cells, int first, int count, casa pawnsMask, int *found) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi32((int) pawnsMask);
+    const __m256i safe = _mm256_set1_epi32((int) CASA_SAFE);
+    int totalFound = 0;
+
+    for (int offset = 0; offset < count; offset += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *) (cells + first + offset));
+        __m256i pawns = _mm256_cmpeq_epi32(_mm256_and_si256(block, mask), zero);
+        __m256i safeCells = _mm256_cmpeq_epi32(_mm256_and_si256(block, safe), zero);
+
+        // Cells with pawns and without the safe flag
+        unsigned int bits = (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(pawns, safeCells)));
+
+        // Ignores the cells after the scanned range
+        if (count - offset < 8) {
+            bits &= (1u << (count - offset)) - 1;
+        }
+
+        while (bits != 0) {
+            found[totalFound++] = first + offset + __builtin_ctz(bits);
+            bits &= bits - 1;
+        }
+    }
+
+    return totalFound;
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi32((int) pawnsMask);
+    const __m128i safe = _mm_set1_epi32((int) CASA_SAFE);
+    int totalFound = 0;
+
+    for (int offset = 0; offset < count; offset += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i *) (cells + first + offset));
+        __m128i pawns = _mm_cmpeq_epi32(_mm_and_si128(block, mask), zero);
+        __m128i safeCells = _mm_cmpeq_epi32(_mm_and_si128(block, safe), zero);
+
+        // Cells with pawns and without the safe flag
+        unsigned int bits = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(pawns, safeCells)));
+
+        // Ignores the cells after the scanned range
+        if (count - offset < 4) {
+            bits &= (1u << (count - offset)) - 1;
+        }
+
+        while (bits != 0) {
+            found[totalFound++] = first + offset + __builtin_ctz(bits);
+            bits &= bits - 1;
+        }
+    }
+
+    return totalFound;
+#else
+    return captureScanScalar(cells, first, count, pawnsMask, found);
+#endif
+}
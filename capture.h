@@ -0,0 +1,15 @@
+#ifndef __capture_h__
+#define __capture_h__
+
+#include "board.h"
+
+/*
+    Extra cells the board cells array must have after the last cell,
+    the vector kernels read whole blocks of this size
+*/
+#define CAPTURE_SCAN_PADDING 8
+
+int captureScan(const casa *cells, int first, int count, casa pawnsMask, int *found);
+int captureScanScalar(const casa *cells, int first, int count, casa pawnsMask, int *found);
+
+#endif
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include "cold.h"
+#include "capture.h"
+#include "rng.h"
+
+/*
+    Embeddable game (libcold.a): the game flow of 'main' behind a context
+    object. A game is one block with its state followed by the board cells,
+    so creating a game is a single allocation and freeing it a single free.
+    The library has no globals (the dices come from the game generator) and
+    does no I/O: the caller reads the commands, prints the rendered board and
+    stores the snapshots wherever it wants.
+*/
+
+struct coldGame {
+    unsigned int rows, cols;
+    list board;  // Board whose cells are 'cells'
+    bool player1;  // Whether it is player 1 to move
+    int dicesValue;  // Dices value rolled for the current play (0 if not rolled yet)
+    int winner;  // 0 while the game goes on, 1 - P1 won, 2 - P2 won
+    rngState rng;  // Dices generator
+    casa cells[];  // Board cells, padded for the capture scan
+};
+
+
+/**
+ * @brief Sets the settings of the standard game: 3x7 board, 4 pawns, 2 dices,
+ * no safe cells besides the homes, seed 1 and no memory accounting.
+ * @param config The settings
+ */
+void coldConfigInit(coldConfig *config) {
+    config->rows = 3;
+    config->cols = 7;
+    config->pawns = STANDARD_PAWNS;
+    config->dices = STANDARD_DICES;
+    config->safeCells = NULL;
+    config->seed = 1;
+    config->memory = NULL;
+}
+
+/**
+ * @brief Creates a game with every pawn in its home cell and player 1 to move.
+ * @param config The settings of the game
+ * @return Returns the game, NULL if the settings are not valid or there is no memory. It must be freed with 'coldFree'
+ */
+coldGame *coldNew(const coldConfig *config) {
+    safeCellSet noSafeCells = {NULL, 0, NULL};
+    int totalCells;
+    coldGame *game;
+
+    // Same rules as the command line arguments of the game
+    if (!validBoardSize(config->rows, config->cols) || !validGameRules(config->pawns, config->dices)) {
+        return NULL;
+    }
+
+    totalCells = config->rows * 2 + (config->cols - 2) * 2;
+
+    game = memCalloc(config->memory, MEM_BOARD, 1, sizeof(coldGame) + sizeof(casa) * (totalCells + CAPTURE_SCAN_PADDING));
+    if (game == NULL) {
+        return NULL;
+    }
+
+    game->rows = config->rows;
+    game->cols = config->cols;
+    initializeCellsList(&game->board);
+    game->board.pawns = config->pawns;
+    game->board.dices = config->dices;
+    game->board.memory = config->memory;
+    boardSetupCells(&game->board, game->cells, config->safeCells != NULL ? config->safeCells : &noSafeCells, totalCells);
+    coldReset(game, config->seed);
+
+    return game;
+}
+
+/**
+ * @brief Creates a game from a snapshot written by 'coldSave' (or by 'snapshotEncode').
+ * @param snapshot Buffer with 'SNAPSHOT_SIZE' bytes
+ * @param memory Tracker the game is accounted to (NULL if not accounted)
+ * @return Returns the game, NULL if the snapshot is not valid or there is no memory. It must be freed with 'coldFree'
+ */
+coldGame *coldNewFromSnapshot(const unsigned char *snapshot, memTracker *memory) {
+    gameInfo info;
+    coldConfig config;
+    coldGame *game;
+
+    if (snapshotDecodeInfo(snapshot, &info) == 1) {
+        return NULL;
+    }
+
+    coldConfigInit(&config);
+    config.rows = info.rows;
+    config.cols = info.cols;
+    config.pawns = info.pawns;
+    config.dices = info.dices;
+    config.memory = memory;
+
+    game = coldNew(&config);
+    if (game == NULL) {
+        return NULL;
+    }
+
+    if (snapshotApply(snapshot, &game->board) == 1) {
+        coldFree(game);
+        return NULL;
+    }
+    game->player1 = info.player1;
+    game->dicesValue = (int) info.dicesValue;
+    game->rng = info.rng;
+    game->winner = checkGameWin(&game->board, game->board.length);
+
+    return game;
+}
+
+/**
+ * @brief Frees a game.
+ * @param game The game (can be NULL)
+ */
+void coldFree(coldGame *game) {
+    if (game != NULL) {
+        memFree(game->board.memory, game);
+    }
+}
+
+/**
+ * @brief Starts the game again: every pawn back in its home cell, player 1 to
+ * move and the dices generator seeded again. The safe cells are kept.
+ * @param game The game
+ * @param seed Seed of the dices generator
+ */
+void coldReset(coldGame *game, uint64_t seed) {
+    boardReset(&game->board);
+    game->player1 = true;
+    game->dicesValue = 0;
+    game->winner = 0;
+    rngSeed(&game->rng, seed);
+}
+
+/**
+ * @brief Rolls the dices for the player to move. The value stays until a play
+ * is made, so rolling again before playing returns the same value.
+ * @param game The game
+ * @return Returns the dices value, 0 if the game is over
+ */
+int coldRoll(coldGame *game) {
+    if (game->winner != 0) {
+        return 0;
+    }
+
+    if (game->dicesValue == 0) {
+        game->dicesValue = rngRollDice(&game->rng, game->board.dices);
+    }
+
+    return game->dicesValue;
+}
+
+/**
+ * @brief Plays a pawn of the player to move with the rolled dices value and
+ * passes the turn to the other player.
+ * @param game The game
+ * @param pawn The pawn to play
+ * @return Returns the number of adversary pawns captured, 'COLD_ILLEGAL' if the
+ * game is over, the dices were not rolled or the pawn can not be played (nothing changes)
+ */
+int coldPlay(coldGame *game, char pawn) {
+    int captures;
+
+    if (game->winner != 0 || game->dicesValue == 0 || !isLegalPawn(&game->board, pawn, game->player1)) {
+        return COLD_ILLEGAL;
+    }
+
+    captures = makePlay(&game->board, pawn, game->dicesValue);
+    game->player1 = !game->player1;
+    game->dicesValue = 0;
+    game->winner = checkGameWin(&game->board, game->board.length);
+
+    return captures;
+}
+
+/**
+ * @brief Returns whether the game is over.
+ * @param game The game
+ * @return Returns 0 while the game goes on, 1 if P1 won and 2 if P2 won
+ */
+int coldIsOver(const coldGame *game) {
+    return game->winner;
+}
+
+/**
+ * @brief Returns whether it is player 1 to move.
+ * @param game The game
+ * @return Returns true for player 1 and false for player 2
+ */
+bool coldPlayer1(const coldGame *game) {
+    return game->player1;
+}
+
+/**
+ * @brief Gets the number of board lines.
+ * @param game The game
+ * @return Returns the number of lines
+ */
+unsigned int coldRows(const coldGame *game) {
+    return game->rows;
+}
+
+/**
+ * @brief Gets the number of board columns.
+ * @param game The game
+ * @return Returns the number of columns
+ */
+unsigned int coldCols(const coldGame *game) {
+    return game->cols;
+}
+
+/**
+ * @brief Gets the board of the game, for the code that reads positions (policies,
+ * viewers, memory reports). Changing it directly bypasses the game state.
+ * @param game The game
+ * @return Returns the board
+ */
+list *coldBoard(coldGame *game) {
+    return &game->board;
+}
+
+/**
+ * @brief Writes the full game state (with the rolled dices value) to a snapshot.
+ * @param game The game
+ * @param snapshot Buffer with at least 'SNAPSHOT_SIZE' bytes that receives the snapshot
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (board too large for a snapshot)
+ */
+int coldSave(const coldGame *game, unsigned char *snapshot) {
+    gameInfo info;
+
+    info.rows = game->rows;
+    info.cols = game->cols;
+    info.pawns = game->board.pawns;
+    info.dices = game->board.dices;
+    info.player1 = game->player1;
+    info.dicesValue = (unsigned int) game->dicesValue;
+    info.rng = game->rng;
+
+    return snapshotEncode(&game->board, &info, snapshot);
+}
+
+/**
+ * @brief Renders the board as the game prints it. Like 'snprintf', the text is
+ * cut to fit the buffer and is always terminated.
+ * @param game The game
+ * @param mode Board presentation mode (0 - full board, 1 - simplified board)
+ * @param buffer Buffer that receives the text (can be NULL if 'size' is 0)
+ * @param size Bytes of the buffer
+ * @return Returns the length of the whole text, a buffer of at least this length
+ * plus 1 holds it
+ */
+size_t coldRenderToBuffer(const coldGame *game, int mode, char *buffer, size_t size) {
+    return boardPrintToBuffer(buffer, size, game->rows, game->cols, game->board, mode);
+}
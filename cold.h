@@ -0,0 +1,48 @@
+#ifndef __cold_h__
+#define __cold_h__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+#include "engine.h"
+#include "memtrack.h"
+#include "snapshot.h"
+
+#define COLD_ILLEGAL (-1)  // Returned by 'coldPlay' when the play is not allowed
+
+/**
+ * A game: board, player to move, pending dices and dices generator, all in a
+ * single allocation. Games share nothing, so each one can be driven by any thread.
+ */
+typedef struct coldGame coldGame;
+
+/**
+ * Settings of a new game.
+ */
+typedef struct {
+    unsigned int rows;  // Number of board lines (odd, at least 'MIN_ROWS')
+    unsigned int cols;  // Number of board columns (more than 'MIN_COLS')
+    int pawns;  // Pawns of each player (1 to 'MAX_PAWNS')
+    int dices;  // Dices rolled in each play (1 to 'MAX_DICES')
+    const safeCellSet *safeCells;  // Safe cells (NULL for only the home cells)
+    uint64_t seed;  // Seed of the dices generator
+    memTracker *memory;  // Tracker the game is accounted to (NULL if not accounted)
+} coldConfig;
+
+void coldConfigInit(coldConfig *config);
+coldGame *coldNew(const coldConfig *config);
+coldGame *coldNewFromSnapshot(const unsigned char *snapshot, memTracker *memory);
+void coldFree(coldGame *game);
+void coldReset(coldGame *game, uint64_t seed);
+int coldRoll(coldGame *game);
+int coldPlay(coldGame *game, char pawn);
+int coldIsOver(const coldGame *game);
+bool coldPlayer1(const coldGame *game);
+unsigned int coldRows(const coldGame *game);
+unsigned int coldCols(const coldGame *game);
+list *coldBoard(coldGame *game);
+int coldSave(const coldGame *game, unsigned char *snapshot);
+size_t coldRenderToBuffer(const coldGame *game, int mode, char *buffer, size_t size);
+
+#endif
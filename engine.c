@@ -2,104 +2,171 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <assert.h>
 #include "engine.h"
 #include "board.h"
+#include "capture.h"
+#include "memtrack.h"
 
+// Forces inlining of the engine bodies shared by the generic and the specialised kernels
+#define ENGINE_INLINE static inline __attribute__((always_inline))
+
+static playKernel selectPlayKernel(int totalCells, int pawns);
+
+/*
+    Pawn letters, the same as 'SYMBOLS_J1' and 'SYMBOLS_J2': 1 + the pawn index
+    for the P1 pawns, -(1 + the pawn index) for the P2 pawns, 0 for any other character
+*/
+static const signed char PAWN_CODES[128] = {
+    ['a'] = 1, ['b'] = 2, ['c'] = 3, ['d'] = 4, ['e'] = 5, ['f'] = 6, ['i'] = 7,
+    ['w'] = -1, ['x'] = -2, ['y'] = -3, ['z'] = -4, ['v'] = -5, ['u'] = -6, ['t'] = -7
+};
+
+/**
+ * @brief Gets the code of a pawn letter (see 'PAWN_CODES').
+ * @param pawn The given pawn
+ * @return Returns the code, 0 if the character is not a pawn
+ */
+ENGINE_INLINE int pawnCode(char pawn) {
+    return (unsigned char) pawn < sizeof(PAWN_CODES) ? PAWN_CODES[(unsigned char) pawn] : 0;
+}
+
+/**
+ * @brief Gets the player who owns a pawn.
+ * @param pawn The given pawn (a valid pawn)
+ * @return Returns '0' for P1 and '1' for P2
+ */
+ENGINE_INLINE int pawnPlayer(char pawn) {
+    return pawnCode(pawn) > 0 ? 0 : 1;
+}
 
 /**
  * @brief Initializes the board cells' list
- * @param boardCells Linked list with board cells
+ * @param boardCells Board with all cells
  */
 void initializeCellsList(list *boardCells) {
-    boardCells->head = NULL;
-    boardCells->tail = NULL;
+    boardCells->cells = NULL;
     boardCells->length = 0;
+    boardCells->pawns = STANDARD_PAWNS;
+    boardCells->dices = STANDARD_DICES;
+    boardCells->play = NULL;
+    boardCells->memory = NULL;
 }
 
 /**
- * @brief Inserts a new board cell into the board cells' linked list.
- * @param boardCells Linked list with board cells
- * @param cell The cell to be inserted
+ * @brief Performs board setup. Initializes all board cells 
+ * and places home cells as well as safe cells.
+ * @param boardCells Board with all cells, with its number of pawns and dices already set
+ * @param safeCells Safe cells read from the config file
+ * @param totalCells The number of total cells
  * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
  */
-int insertBoardCell(list *boardCells, node *cell) {
-    if (boardCells->head == NULL) {  // List is empty
-        boardCells->head = cell;
-        boardCells->tail = cell;
-        boardCells->length = 1;
-    } else {  // List has more than 1 item
-        boardCells->tail->next = cell;
-        boardCells->tail = cell;
-        boardCells->length++;
+int boardSetup(list *boardCells, const safeCellSet *safeCells, int totalCells) {
+    casa *cells;
+
+    if (!validGameRules(boardCells->pawns, boardCells->dices)) {
+        return 1;
     }
 
+    // Allocates all cells in a single block, padded for the capture scan
+    cells = memCalloc(boardCells->memory, MEM_BOARD, totalCells + CAPTURE_SCAN_PADDING, sizeof(casa));
+
+    // Checks if an ERROR ocurred while allocating memory (i.e. out of memory)
+    if (cells == NULL) {
+        return 1;
+    }
+
+    boardSetupCells(boardCells, cells, safeCells, totalCells);
     return 0;
 }
 
 /**
- * @brief Performs board setup. Initializes all board cells 
- * and places home cells as well as safe cells.
- * @param boardCells Linked list with board cells
- * @param safeCells Int array with safe cells position
+ * @brief Performs board setup on cells allocated by the caller (e.g. inside a
+ * larger block), which keeps owning them: the board must not be freed with 'freeBoardCells'.
+ * @param boardCells Board with all cells, with valid numbers of pawns and dices already set
+ * @param cells Zeroed cells, 'totalCells + CAPTURE_SCAN_PADDING' of them
+ * @param safeCells Safe cells read from the config file
  * @param totalCells The number of total cells
- * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
  */
-int boardSetup(list *boardCells, int *safeCells, int totalCells) {
-    // Adds cells to board (Board Setup)
-    for (int cellIndex = 0; cellIndex < totalCells; cellIndex++) {
-        int letterIdx;
-        node *cell = (node*) malloc(sizeof(node));  // Creates a new 'node'
-
-        // Checks if an ERROR ocurred while allocating memory (i.e. out of memory)
-        if (cell == NULL) {
-            return 1;
-        }
-
-        // Adds data to new place
-        if (cellIndex == 0) {  // Initializes home cell for player 1
-            for (letterIdx = 0; letterIdx <= 3; letterIdx++) {
-                cell->item.jogador_peao[0][letterIdx] = TRUE;
-                cell->item.jogador_peao[1][letterIdx] = FALSE;
-            }
+void boardSetupCells(list *boardCells, casa *cells, const safeCellSet *safeCells, int totalCells) {
+    assert(validGameRules(boardCells->pawns, boardCells->dices));
 
-            // Sets home cells as safe cells
-            cell->item.casaSegura = 1;
+    boardCells->cells = cells;
+    boardCells->length = totalCells;
+    boardCells->play = selectPlayKernel(totalCells, boardCells->pawns);
 
-        } else if (cellIndex == (totalCells / 2)) {  // Initializes home cell for player 2
-            for (letterIdx = 0; letterIdx <= 3; letterIdx++) {
-                cell->item.jogador_peao[1][letterIdx] = TRUE;
-                cell->item.jogador_peao[0][letterIdx] = FALSE;
-            }
+    // Initializes safe cells given in the config file (cells beyond the board are ignored)
+    for (int cellIndex = 0; cellIndex < totalCells && cellIndex < safeCells->length; cellIndex++) {
+        if (safeCells->isSafe[cellIndex]) {
+            casaSetSafe(&boardCells->cells[cellIndex], TRUE);
+        }
+    }
 
-            // Sets home cells as safe cells
-            cell->item.casaSegura = TRUE;
-        } else {
-            // Initializes safe cells given in the config file
-            if (safeCells[cellIndex] == TRUE) {
-                cell->item.casaSegura = TRUE;
-            } else {
-                cell->item.casaSegura = FALSE;
-            }
+    // Initializes home cells for player 1 and player 2, home cells are also safe cells
+    boardCells->cells[0] = CASA_SAFE;
+    boardCells->cells[totalCells / 2] = CASA_SAFE;
 
-            // Cleans all the other player cells
-            for (letterIdx = 0; letterIdx <= 3; letterIdx++) {
-                cell->item.jogador_peao[0][letterIdx] = FALSE;
-                cell->item.jogador_peao[1][letterIdx] = FALSE;
-            }
+    // Unused pawn slots also point to the home cells
+    for (int pawnIndex = 0; pawnIndex < MAX_PAWNS; pawnIndex++) {
+        if (pawnIndex < boardCells->pawns) {
+            casaSetPawnState(&boardCells->cells[0], 0, pawnIndex, TRUE);
+            casaSetPawnState(&boardCells->cells[totalCells / 2], 1, pawnIndex, TRUE);
         }
+        boardCells->pawnCells[0][pawnIndex] = 0;
+        boardCells->pawnCells[1][pawnIndex] = totalCells / 2;
+    }
+}
 
-        // Adds data to new cell
-        cell->next = NULL;
-        
-        // Insert new cell onto the board
-        if (insertBoardCell(boardCells, cell) == 1) {
-            return 1;
+/**
+ * @brief Puts every pawn back in its home cell, keeping the safe cells.
+ * Uses the pawn position index, so it does not depend on the board size.
+ * @param boardCells Board with all cells
+ */
+void boardReset(list *boardCells) {
+    int homes[2] = {0, boardCells->length / 2};
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIndex = 0; pawnIndex < boardCells->pawns; pawnIndex++) {
+            casaSetPawnState(&boardCells->cells[boardCells->pawnCells[player][pawnIndex]], player, pawnIndex, FALSE);
+            casaSetPawnState(&boardCells->cells[homes[player]], player, pawnIndex, TRUE);
+            boardCells->pawnCells[player][pawnIndex] = homes[player];
         }
     }
+}
+
+/**
+ * @brief Allocates a new board with the same cells, pawns, rules, play kernel and memory tracker as the given board.
+ * @param destination Receives the new board
+ * @param source The board to clone
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int boardClone(list *destination, const list *source) {
+    *destination = *source;
+    destination->cells = memAlloc(source->memory, MEM_BOARD_CLONES, sizeof(casa) * (source->length + CAPTURE_SCAN_PADDING));
+
+    // Checks if an ERROR ocurred while allocating memory (i.e. out of memory)
+    if (destination->cells == NULL) {
+        initializeCellsList(destination);
+        return 1;
+    }
 
+    memcpy(destination->cells, source->cells, sizeof(casa) * (source->length + CAPTURE_SCAN_PADDING));
     return 0;
 }
 
+/**
+ * @brief Copies the cells and pawns of a board into another board of the same size,
+ * without allocating (e.g. to restore a position between simulated games).
+ * @param destination Board that receives the position
+ * @param source The board to copy
+ */
+void boardCopy(list *destination, const list *source) {
+    assert(destination->length == source->length && destination->pawns == source->pawns);
+
+    memcpy(destination->cells, source->cells, sizeof(casa) * source->length);
+    memcpy(destination->pawnCells, source->pawnCells, sizeof(source->pawnCells));
+}
+
 /**
  * @brief Returns whether the given pawn is a valid pawn or not based on the player of the current play. 
  * @param pawn The given pawn
@@ -107,51 +174,28 @@ int boardSetup(list *boardCells, int *safeCells, int totalCells) {
  * @return Returns whether the given pawn is valid or not
  */
 bool validPawn(char pawn, bool player1) {
-    for (int i = 1; i < 5; i++) {
-        if (player1 == true && SYMBOLS_J1[i] == pawn) {
-            return true;
-        }
+    int code = pawnCode(pawn);
 
-        if (player1 == false && SYMBOLS_J2[i] == pawn) {
-            return true;
-        }
-    }
-    return false;
+    return player1 ? code > 0 : code < 0;
 }
 
 /**
  * @brief Checks if any of the two player has already won the game.
- * @param boardCells Linked list with board cells
+ * @param boardCells Board with all cells
  * @param totalCells The number of total cells
  * @return Returns 1 if 'Player 1 WON the game', 2 if 'Player 2 WON the game' and 0 if the 'Game still in progress'
  */
 int checkGameWin(list *boardCells, int totalCells) {
     int homeP1 = 0;  // Player 1 home
     int homeP2 = totalCells / 2;  // Player 2 home
-    bool p1Won = true;  // Player 1 win case
-    bool p2Won = true;  // Player 2 win case
 
-    node currentNode = *boardCells->head;  // Holds current node being checked
-
-    for (int home = homeP1; home <= homeP2; home++) {
-        for (int pawnIdx = 0; pawnIdx < 4; pawnIdx++) {
-            if (home == homeP1 && currentNode.item.jogador_peao[0][pawnIdx] != WIN) {
-                p1Won = false;
-            }
-
-            if (home == homeP2 && currentNode.item.jogador_peao[1][pawnIdx] != WIN) {
-                p2Won = false;
-            }
-        }
-        
-        // Gets next node
-        currentNode = *currentNode.next;
-    }
+    casa winsP1 = CASA_PLAYER_WINS(0, boardCells->pawns);
+    casa winsP2 = CASA_PLAYER_WINS(1, boardCells->pawns);
 
-    // Checks which player won, if any
-    if (p1Won) {
+    // A player wins when all of his pawns are WIN in his home cell
+    if ((boardCells->cells[homeP1] & winsP1) == winsP1) {
         return 1;
-    } else if (p2Won) {
+    } else if ((boardCells->cells[homeP2] & winsP2) == winsP2) {
         return 2;
     } else {
         return 0;
@@ -164,79 +208,58 @@ int checkGameWin(list *boardCells, int totalCells) {
  * @return Returns the index of the given pawn. If the pawn is not valid returns -1.
  */
 int getPawnIndex(char pawn) {
-    int index;
-    if (pawn == 'a' || pawn == 'w') {
-        index = 0;
-    } else if (pawn == 'b' || pawn == 'x') {
-        index = 1;
-    } else if (pawn == 'c' || pawn == 'y') {
-        index = 2;
-    } else if (pawn == 'd' || pawn == 'z') {
-        index = 3;
-    } else {
-        index = -1;
+    int code = pawnCode(pawn);
+
+    if (code == 0) {
+        return -1;
     }
 
-    return index;
+    return (code > 0 ? code : -code) - 1;
+}
+
+/**
+ * @brief Gets the player who owns the given pawn.
+ * @param pawn The given pawn (a valid pawn)
+ * @return Returns '0' for P1 and '1' for P2
+ */
+int getPawnPlayer(char pawn) {
+    return pawnPlayer(pawn);
 }
 
 /**
  * @brief Get the Node Index for the given pawn.
- * @param boardCells Linked list with board cells
+ * @param boardCells Board with all cells
  * @param pawn The given pawn
- * @return Returns the node index for the given pawn
+ * @return Returns the node index for the given pawn, -1 if the pawn is WIN
  */
 int getPawnNodeIndex(list *boardCells, char pawn) {
     int playerPos;  // Gets the player position to which the pawn belongs (0 - P1, 1 - P2)
-    int pawnPos;  // Gets the pawn position
-    int nodeIndex;  // Holds the current node index being checked
-    node currentNode = *boardCells->head; // Holds the current node being checked 
+    int pawnIndex = getPawnIndex(pawn);  // Gets the index of the pawn in the cell
+    int nodeIndex;
     
     // Sets 'playerPos' based on the given 'pawn'
-    if (pawn >= 97 && pawn <= 100) {
-        playerPos = 0;
-    } else {
-        playerPos = 1;
-    }
+    playerPos = pawnPlayer(pawn);
 
-    // Sets 'pawnPos' based on the given 'pawn'
-    pawnPos = getPawnIndex(pawn);
-    
-    // Iterates over the board cells until it finds the pawn position
-    for (nodeIndex = 0; nodeIndex < boardCells->length; nodeIndex++) {
-        if ((char) currentNode.item.jogador_peao[playerPos][pawnPos] == TRUE) {
-            return nodeIndex;
-        }
-        currentNode = *currentNode.next;
-    }
+    // Looks the pawn up in the position index
+    nodeIndex = boardCells->pawnCells[playerPos][pawnIndex];
+    assert(casaPawnState(boardCells->cells[nodeIndex], playerPos, pawnIndex) != FALSE);
 
-    return -1;
+    return casaPawnState(boardCells->cells[nodeIndex], playerPos, pawnIndex) == TRUE ? nodeIndex : -1;
 }
 
 /**
- * @brief Moves a pawn from a given source to a given destination.
- * @param boardCells Linked list with board cells
- * @param pawn The given pawn
- * @param pawnIndex The index in 'jogador_peao' array inside 'node' for the current pawn
+ * @brief Gets the cell where a pawn ends a play.
+ * @param playerIndex The player who owns the pawn ('0' - P1, '1' - P2)
  * @param srcIndex The index for the node where the pawn currently resides
- * @param destIndex The index for the node to which the pawn should reside from now on
+ * @param destIndex The source index plus the amount of cells the pawn advances
+ * @param totalCells The number of total cells (a constant in the specialised kernels)
+ * @param completesLap Receives whether the pawn completes its lap (and becomes WIN)
+ * @return Returns the destination node index, the player home if the pawn completes its lap
  */
-void movePawn(list *boardCells, char pawn, int pawnIndex, int srcIndex, int destIndex) {
-    int playerIndex;
-    int currentIndex;
-    node *currentNode = boardCells->head;
+ENGINE_INLINE int playDestination(int playerIndex, int srcIndex, int destIndex, int totalCells, bool *completesLap) {
     int homeP1 = 0;
-    int homeP2 = boardCells->length / 2;
-    int totalCells = boardCells->length;
+    int homeP2 = totalCells / 2;
     int finalDestIndex = destIndex;
-    bool completesLap;
-
-    // Gets player index to access based on the given pawn
-    if (pawn == 'a' || pawn == 'b' || pawn == 'c' || pawn == 'd') {
-        playerIndex = 0;
-    } else {
-        playerIndex = 1;
-    }
 
     // Calculates destination index for P2
     if (playerIndex == 1) {
@@ -248,120 +271,133 @@ void movePawn(list *boardCells, char pawn, int pawnIndex, int srcIndex, int dest
     }
 
     // Checks if pawn completes lap in current play
-    completesLap = pawnCompletesLapInCurrentPlay(playerIndex, boardCells->length, srcIndex, destIndex, finalDestIndex);
+    *completesLap = pawnCompletesLapInCurrentPlay(playerIndex, totalCells, srcIndex, destIndex, finalDestIndex);
 
-    for (currentIndex = 0; currentIndex < boardCells->length; currentIndex++) {
-        if (currentIndex == srcIndex) {
-            // Removes the pawn from its current position in the board
-            currentNode->item.jogador_peao[playerIndex][pawnIndex] = FALSE;
-        }
+    return *completesLap ? (playerIndex == 0 ? homeP1 : homeP2) : finalDestIndex;
+}
 
-        /* 
-            Checks if pawn has gone around the whole board, if that's the case, 
-            the pawn must be moved to its home cell and converted to uppercase
-        */
-        // Win case for P1
-        if (completesLap && playerIndex == 0 && currentIndex == homeP1) {
-            currentNode->item.jogador_peao[playerIndex][pawnIndex] = WIN;
-        }
-        
-        // Win case for P2
-        if (completesLap && playerIndex == 1 && currentIndex == homeP2) {
-            currentNode->item.jogador_peao[playerIndex][pawnIndex] = WIN;
-        }
-        
-        if (!completesLap && currentIndex == finalDestIndex) {  // Places the pawn in its new destination
-            currentNode->item.jogador_peao[playerIndex][pawnIndex] = TRUE;
-        }
+/**
+ * @brief Moves a pawn from a given source to a given destination.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param pawnIndex The index of the pawn in the cell (0 to 'MAX_PAWNS' - 1)
+ * @param srcIndex The index for the node where the pawn currently resides
+ * @param destIndex The index for the node to which the pawn should reside from now on
+ * @param totalCells The number of total cells (a constant in the specialised kernels)
+ */
+ENGINE_INLINE void movePawnCells(list *boardCells, char pawn, int pawnIndex, int srcIndex, int destIndex, int totalCells) {
+    int playerIndex;
+    int finalDestIndex;
+    bool completesLap;
 
-        // Gets next node
-        currentNode = currentNode->next;
-    }
+    // Gets player index to access based on the given pawn
+    playerIndex = pawnPlayer(pawn);
+
+    finalDestIndex = playDestination(playerIndex, srcIndex, destIndex, totalCells, &completesLap);
+
+    // Removes the pawn from its current position in the board
+    casaSetPawnState(&boardCells->cells[srcIndex], playerIndex, pawnIndex, FALSE);
+
+    /* 
+        Checks if pawn has gone around the whole board, if that's the case, 
+        the pawn must be moved to its home cell and converted to uppercase
+    */
+    casaSetPawnState(&boardCells->cells[finalDestIndex], playerIndex, pawnIndex, completesLap ? WIN : TRUE);
+    boardCells->pawnCells[playerIndex][pawnIndex] = finalDestIndex;
+}
+
+/**
+ * @brief Moves a pawn from a given source to a given destination.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param pawnIndex The index of the pawn in the cell (0 to 'MAX_PAWNS' - 1)
+ * @param srcIndex The index for the node where the pawn currently resides
+ * @param destIndex The index for the node to which the pawn should reside from now on
+ */
+void movePawn(list *boardCells, char pawn, int pawnIndex, int srcIndex, int destIndex) {
+    movePawnCells(boardCells, pawn, pawnIndex, srcIndex, destIndex, boardCells->length);
 }
 
 /**
  * @brief Resets the adversary pawn by removing it from its current place
  * and moving it back to its home cell.
- * @param boardCells Linked list with board cells
+ * @param boardCells Board with all cells
  * @param pawn The given pawn
  * @param player The player who owns the pawn ('0' - P1, '1' - P2)
  * @param pawnSrcIndex The current node index in which the pawn currently is
  */
 void resetAdversaryPawn(list *boardCells, char pawn, int player, int pawnSrcIndex) {
-    int playerHome;  // Stores player home node index
-    int totalCells = boardCells->length;  // Total amount of board cells
-    char playerSymbols[10];  // Stores the symbols for the current player
-    int pawnIndex;  // Stores the index of the pawn in 'playerSymbols'
-    node *currentNode;  // Store the current node being checked
-
-    if (player == 0) {
-        playerHome = 0;
-        strcpy(playerSymbols, SYMBOLS_J1);
-    } else {
-        playerHome = totalCells / 2;
-        strcpy(playerSymbols, SYMBOLS_J2);
+    int playerHome = player == 0 ? 0 : boardCells->length / 2;  // Stores player home node index
+    int pawnIndex = getPawnIndex(pawn);  // Stores the index of the pawn in the cell
+
+    // Removes pawn from its current place and adds it to its home cell
+    casaSetPawnState(&boardCells->cells[pawnSrcIndex], player, pawnIndex, FALSE);
+    casaSetPawnState(&boardCells->cells[playerHome], player, pawnIndex, TRUE);
+    boardCells->pawnCells[player][pawnIndex] = playerHome;
+}
+
+/**
+ * @brief Captures every pawn of a player present in the given cells, moving
+ * them all back to their home cell at once.
+ * @param boardCells Board with all cells
+ * @param player The player who owns the pawns ('0' - P1, '1' - P2)
+ * @param cells The cells where the pawns are captured (none of them is the player home)
+ * @param totalCaptureCells The number of cells in 'cells'
+ * @return Returns the number of captured pawns
+ */
+int resetAdversaryPawns(list *boardCells, int player, const int *cells, int totalCaptureCells) {
+    int playerHome = player == 0 ? 0 : boardCells->length / 2;  // Stores player home node index
+    casa capturedPawns = 0;  // Stores the bits of all captured pawns
+
+    // Removes pawns from their current place
+    for (int i = 0; i < totalCaptureCells; i++) {
+        capturedPawns |= boardCells->cells[cells[i]] & CASA_PLAYER_PAWNS(player);
+        boardCells->cells[cells[i]] &= ~CASA_PLAYER_PAWNS(player);
     }
 
-    // Gets pawn index
-    pawnIndex = getPawnIndex(pawn);
+    // Adds pawns to their home cell, one bit of 'capturedPawns' per pawn
+    boardCells->cells[playerHome] |= capturedPawns;
+    for (casa pawnBits = capturedPawns >> (player * MAX_PAWNS); pawnBits != 0; pawnBits &= pawnBits - 1) {
+        boardCells->pawnCells[player][__builtin_ctz(pawnBits)] = playerHome;
+    }
 
-    currentNode = boardCells->head;
+    return __builtin_popcount(capturedPawns);
+}
 
-    for (int nodeIndex = 0; nodeIndex < totalCells; nodeIndex++) {
-        // Removes pawn from its current place
-        if (nodeIndex == pawnSrcIndex) {
-            currentNode->item.jogador_peao[player][pawnIndex] = FALSE;
-        }
+#ifndef NDEBUG
+/**
+ * @brief Checks that the capture scan found the same cells as the scalar scan.
+ * @param boardCells Board with all cells
+ * @param player The player who owns the pawns that can be captured
+ * @param first Index of the first cell of the first scanned range
+ * @param firstCount Number of cells of the first scanned range
+ * @param secondCount Number of cells of the second scanned range (starts at cell 0)
+ * @param cells The cells found by the capture scan
+ * @param totalCaptureCells The number of cells in 'cells'
+ * @return Returns whether both scans found the same cells
+ */
+static bool sameAsScalarScan(list *boardCells, int player, int first, int firstCount, int secondCount, const int *cells, int totalCaptureCells) {
+    int scalarCells[MAX_PLAY_AMOUNT];
+    int totalScalarCells = captureScanScalar(boardCells->cells, first, firstCount, CASA_PLAYER_PAWNS(player), scalarCells);
 
-        // Adds pawn to its home cell
-        if (nodeIndex == playerHome) {
-            currentNode->item.jogador_peao[player][pawnIndex] = TRUE;
-        }
+    totalScalarCells += captureScanScalar(boardCells->cells, 0, secondCount, CASA_PLAYER_PAWNS(player), scalarCells + totalScalarCells);
 
-        // Gets next node
-        currentNode = currentNode->next;
-    }
+    return totalScalarCells == totalCaptureCells && memcmp(scalarCells, cells, sizeof(int) * totalCaptureCells) == 0;
 }
+#endif
 
 /**
- * @brief Makes the play based on the given pawn and the amount of cells it should advance.
- * @param boardCells Linked list with board cells
- * @param pawn The given pawn
+ * @brief Gets the cells a pawn goes through in a play, as two ranges: the cells after
+ * its current position up to the end of the board and (P2 only) the cells from the start of the board.
+ * @param playerIndex The player who owns the pawn ('0' - P1, '1' - P2)
+ * @param pawnCurrentPos The current pawn node index
  * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @param totalCells The number of total cells
+ * @param firstScanCells Receives the number of cells of the first range (starts at 'pawnCurrentPos' + 1)
+ * @param secondScanCells Receives the number of cells of the second range (starts at cell 0)
  */
-void makePlay(list *boardCells, char pawn, int amount) {
-    int playerIndex;
-    int adversaryPlayerIndex;
-    node *currentNode;  // Stores the pointer of the current node being checked
-    int currentIndex;  // Stores current node index
-    int pawnIndex;  // Stores the index of the pawn in the cell
-    char playerSymbols[10];  // Stores string with player symbols
-    char adversarySymbols[10];  // Stores string with adversary symbols
+ENGINE_INLINE void playScanRanges(int playerIndex, int pawnCurrentPos, int amount, int totalCells, int *firstScanCells, int *secondScanCells) {
     int placesMoved;  // Stores the number of places the current pawn will be moved
-    int totalCells = boardCells->length;  // Stores the number of total board cells
-
-    // Gets current pawn node index
-    int pawnCurrentPos = getPawnNodeIndex(boardCells, pawn);
-
-    // Gets player index based on pawn, sets 'playerSymbols' based on it
-    if (pawn == 'a' || pawn == 'b' || pawn == 'c' || pawn == 'd') {
-        playerIndex = 0;
-        strcpy(playerSymbols, SYMBOLS_J1);
-        strcpy(adversarySymbols, SYMBOLS_J2);
-    } else {
-        playerIndex = 1;
-        strcpy(playerSymbols, SYMBOLS_J2);
-        strcpy(adversarySymbols, SYMBOLS_J1);
-    }
-
-    // Sets 'adversaryPlayerIndex'
-    adversaryPlayerIndex = playerIndex == 0 ? 1 : 0;
-
-    // Gets pawn index in the cell
-    pawnIndex = getPawnIndex(pawn);
-
-    // Moves the chosen 'pawn' to its destination based on 'amount' (dices value)
-    movePawn(boardCells, pawn, pawnIndex, pawnCurrentPos, pawnCurrentPos + amount);
 
     // Sets number of placed the pawn moved
     if (playerIndex == 0) {  // P1
@@ -396,51 +432,253 @@ void makePlay(list *boardCells, char pawn, int amount) {
         }
     }
 
+    // Cells after the current position, up to the end of the board
+    *firstScanCells = placesMoved < totalCells - 1 - pawnCurrentPos ? placesMoved : totalCells - 1 - pawnCurrentPos;
+    placesMoved -= *firstScanCells;
+
+    // P2 goes on from the start of the board
+    *secondScanCells = 0;
+    if (placesMoved > 0 && playerIndex == 1) {
+        *secondScanCells = placesMoved < totalCells / 2 + 1 ? placesMoved : totalCells / 2 + 1;
+    }
+}
+
+/**
+ * @brief Makes the play based on the given pawn and the amount of cells it should advance.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @param totalCells The number of total cells (a constant in the specialised kernels)
+ * @return Returns the number of adversary pawns captured in the play
+ */
+ENGINE_INLINE int makePlayCells(list *boardCells, char pawn, int amount, int totalCells) {
+    int playerIndex;
+    int adversaryPlayerIndex;
+    int pawnIndex;  // Stores the index of the pawn in the cell
+    int captures;  // Stores the number of adversary pawns captured
+    int captureCells[MAX_PLAY_AMOUNT];  // Stores the cells with adversary pawns to be captured (at most one per cell moved)
+    int totalCaptureCells;  // Stores the number of cells in 'captureCells'
+    int firstScanCells;  // Number of cells checked from the current position to the end of the board
+    int secondScanCells;  // Number of cells checked from the start of the board (P2 only)
+    int pawnCurrentPos;  // Stores the current pawn node index
+
+    // Gets player index based on pawn
+    playerIndex = pawnPlayer(pawn);
+
+    // Sets 'adversaryPlayerIndex'
+    adversaryPlayerIndex = playerIndex == 0 ? 1 : 0;
+
+    // Gets pawn index in the cell
+    pawnIndex = getPawnIndex(pawn);
+
+    // Gets current pawn node index from the position index
+    pawnCurrentPos = boardCells->pawnCells[playerIndex][pawnIndex];
+    assert(amount <= MAX_PLAY_AMOUNT && casaPawnState(boardCells->cells[pawnCurrentPos], playerIndex, pawnIndex) == TRUE);
+
+    // Moves the chosen 'pawn' to its destination based on 'amount' (dices value)
+    movePawnCells(boardCells, pawn, pawnIndex, pawnCurrentPos, pawnCurrentPos + amount, totalCells);
+
     /* 
         Checks every board cell that the current pawn will go through.
         If the cell is not a safe cell, moves all the other player
-        cells to his home cell.
+        pawns to their home cell.
     */
 
-   // Sets 'currentNode' to the first node of the board
+    playScanRanges(playerIndex, pawnCurrentPos, amount, totalCells, &firstScanCells, &secondScanCells);
 
-   currentNode = boardCells->head;
-   
-    for (currentIndex = 0; currentIndex < totalCells && placesMoved > 0; currentIndex++) {
-        if (currentIndex > pawnCurrentPos) {
-            // Checks if the current node has any of the opponnent players pawns
-            for (int symbol = 0; symbol < 4; symbol++) {
-                if (currentNode->item.jogador_peao[adversaryPlayerIndex][symbol] == TRUE) {
-                    resetAdversaryPawn(boardCells, adversarySymbols[symbol+1], adversaryPlayerIndex, currentIndex);
-                }
-            }
-            
-            placesMoved--;
-        }
-        
-        // Gets next node
-        currentNode = currentNode->next;
+    // Cells after the current position, up to the end of the board
+    totalCaptureCells = captureScan(boardCells->cells, pawnCurrentPos + 1, firstScanCells,
+                                    CASA_PLAYER_PAWNS(adversaryPlayerIndex), captureCells);
+
+    // If its P2 and there's still cells to 'clear' we need to scan starting at index 0 again
+    if (secondScanCells > 0) {
+        totalCaptureCells += captureScan(boardCells->cells, 0, secondScanCells,
+                                         CASA_PLAYER_PAWNS(adversaryPlayerIndex), captureCells + totalCaptureCells);
     }
 
-    // Sets the node to the beginnig of the linked list again
-    currentNode = boardCells->head;
+    // Debug builds check the vector kernel against the scalar one on every play
+    assert(sameAsScalarScan(boardCells, adversaryPlayerIndex, pawnCurrentPos + 1, firstScanCells,
+                            secondScanCells, captureCells, totalCaptureCells));
 
-    // If its P2 and there's still cells to 'clear' we need to iterate starting at index 0 again
-    if (placesMoved > 0 && playerIndex == 1) {
-        for (currentIndex = 0; currentIndex <= totalCells / 2 && placesMoved > 0; currentIndex++) {
-            // Checks if the current node has any of the opponnent players pawns
-            for (int symbol = 0; symbol < 4; symbol++) {
-                if (currentNode->item.jogador_peao[adversaryPlayerIndex][symbol] == TRUE) {
-                    resetAdversaryPawn(boardCells, adversarySymbols[symbol+1], adversaryPlayerIndex, currentIndex);
-                }
+    captures = resetAdversaryPawns(boardCells, adversaryPlayerIndex, captureCells, totalCaptureCells);
+
+    return captures;
+}
+
+/*
+    Play kernels: the 'makePlay' body specialised for the most used board sizes
+    of the standard game, so the number of cells, the home cells and the lap
+    bounds are compile-time constants. Other sizes and games with other numbers
+    of pawns use the generic kernel. 16 cells is the default 3x7 board.
+*/
+#define KERNEL_BOARD_SIZES(KERNEL) KERNEL(12) KERNEL(16) KERNEL(20) KERNEL(24) KERNEL(28) KERNEL(32)
+
+#define DEFINE_PLAY_KERNEL(CELLS) \
+    static int makePlay##CELLS(list *boardCells, char pawn, int amount) { \
+        return makePlayCells(boardCells, pawn, amount, CELLS); \
+    }
+
+KERNEL_BOARD_SIZES(DEFINE_PLAY_KERNEL)
+
+/**
+ * @brief Generic play kernel, for any number of cells and pawns.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @return Returns the number of adversary pawns captured in the play
+ */
+static int makePlayGeneric(list *boardCells, char pawn, int amount) {
+    return makePlayCells(boardCells, pawn, amount, boardCells->length);
+}
+
+/**
+ * @brief Selects the play kernel for a board size.
+ * @param totalCells The number of total cells
+ * @param pawns The number of pawns of each player
+ * @return Returns the specialised kernel for 'totalCells' or the generic kernel
+ */
+static playKernel selectPlayKernel(int totalCells, int pawns) {
+#define PLAY_KERNEL_CASE(CELLS) case CELLS: return makePlay##CELLS;
+    if (pawns != STANDARD_PAWNS) {
+        return makePlayGeneric;
+    }
+
+    switch (totalCells) {
+        KERNEL_BOARD_SIZES(PLAY_KERNEL_CASE)
+        default:
+            return makePlayGeneric;
+    }
+#undef PLAY_KERNEL_CASE
+}
+
+/**
+ * @brief Makes the play based on the given pawn and the amount of cells it should advance,
+ * using the kernel selected for the board size in 'boardSetup'.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @return Returns the number of adversary pawns captured in the play
+ */
+int makePlay(list *boardCells, char pawn, int amount) {
+    return boardCells->play(boardCells, pawn, amount);
+}
+
+/**
+ * @brief Gets the cells a pawn goes through in a play (the cells 'makePlay' checks
+ * for captures), in the order they are walked. Must be called before the play.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @param pathCells Array with at least 'MAX_PLAY_AMOUNT' positions that receives the cells
+ * @return Returns the number of cells in 'pathCells'
+ */
+int getPlayPath(list *boardCells, char pawn, int amount, int *pathCells) {
+    int playerIndex = pawnPlayer(pawn);
+    int pawnCurrentPos = boardCells->pawnCells[playerIndex][getPawnIndex(pawn)];
+    int firstScanCells, secondScanCells;
+    int totalPathCells = 0;
+
+    playScanRanges(playerIndex, pawnCurrentPos, amount, boardCells->length, &firstScanCells, &secondScanCells);
+
+    for (int i = 0; i < firstScanCells; i++) {
+        pathCells[totalPathCells++] = pawnCurrentPos + 1 + i;
+    }
+
+    for (int i = 0; i < secondScanCells; i++) {
+        pathCells[totalPathCells++] = i;
+    }
+
+    return totalPathCells;
+}
+
+/**
+ * @brief Lists every legal move of a player, without changing the board: each
+ * movable pawn with each dices value, the cell where it ends and the adversary
+ * pawns it captures (the same result 'makePlay' would give).
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1 to move
+ * @param dicesValue The dices value (the number of dices to 'DICE_FACES' times the number of dices), 0 for every dices value
+ * @param moves Array with at least 'MAX_MOVES' positions that receives the moves, by pawn then dices value
+ * @return Returns the number of moves in 'moves'
+ */
+int generateMoves(list *boardCells, bool player1, int dicesValue, gameMove *moves) {
+    const char *symbols = player1 ? SYMBOLS_J1 : SYMBOLS_J2;
+    int playerIndex = player1 ? 0 : 1;
+    casa adversaryPawns = CASA_PLAYER_PAWNS(1 - playerIndex);
+    int firstValue = dicesValue == 0 ? boardCells->dices : dicesValue;
+    int lastValue = dicesValue == 0 ? boardCells->dices * DICE_FACES : dicesValue;
+    int totalMoves = 0;
+
+    for (int pawnIndex = 0; pawnIndex < boardCells->pawns; pawnIndex++) {
+        int srcIndex = boardCells->pawnCells[playerIndex][pawnIndex];
+
+        if (!isPawnMovable(symbols[pawnIndex + 1], boardCells, player1)) {
+            continue;
+        }
+
+        for (int amount = firstValue; amount <= lastValue; amount++) {
+            gameMove *move = &moves[totalMoves++];
+            int captureCells[MAX_PLAY_AMOUNT];
+            int totalCaptureCells;
+            int firstScanCells, secondScanCells;
+
+            move->pawn = symbols[pawnIndex + 1];
+            move->dicesValue = amount;
+            move->destination = playDestination(playerIndex, srcIndex, srcIndex + amount, boardCells->length, &move->win);
+
+            // Same cells 'makePlay' checks for captures
+            playScanRanges(playerIndex, srcIndex, amount, boardCells->length, &firstScanCells, &secondScanCells);
+            totalCaptureCells = captureScan(boardCells->cells, srcIndex + 1, firstScanCells, adversaryPawns, captureCells);
+            if (secondScanCells > 0) {
+                totalCaptureCells += captureScan(boardCells->cells, 0, secondScanCells, adversaryPawns, captureCells + totalCaptureCells);
+            }
+
+            move->captures = 0;
+            for (int i = 0; i < totalCaptureCells; i++) {
+                move->captures += __builtin_popcount(boardCells->cells[captureCells[i]] & adversaryPawns);
             }
-            
-            placesMoved--;
-            
-            // Gets next node
-            currentNode = currentNode->next;
         }
     }
+
+    return totalMoves;
+}
+
+/**
+ * @brief Checks if a pawn given by a player can be played: it is one of the
+ * player pawns in this game and it has not completed its lap.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param player1 Whether it is player 1 to move
+ * @return Returns whether the pawn can be played
+ */
+bool isLegalPawn(list *boardCells, char pawn, bool player1) {
+    return validPawn(pawn, player1) && getPawnIndex(pawn) < boardCells->pawns && isPawnMovable(pawn, boardCells, player1);
+}
+
+/**
+ * @brief Checks the number of pawns and dices of a game.
+ * @param pawns The number of pawns of each player
+ * @param dices The number of dices rolled in each play
+ * @return Returns whether a game can be played with them
+ */
+bool validGameRules(int pawns, int dices) {
+    return pawns >= 1 && pawns <= MAX_PAWNS && dices >= 1 && dices <= MAX_DICES;
+}
+
+/**
+ * @brief Checks the size of a board: an odd number of lines, at least 'MIN_ROWS',
+ * more than 'MIN_COLS' columns and at most 'MAX_CELLS' cells. Both values are
+ * bounded before the cells are counted, so the count can not wrap.
+ * @param rows The number of board lines
+ * @param cols The number of board columns
+ * @return Returns whether a board of that size can be played
+ */
+bool validBoardSize(unsigned long rows, unsigned long cols) {
+    if (rows < MIN_ROWS || rows % 2 == 0 || cols <= MIN_COLS || rows > MAX_CELLS || cols > MAX_CELLS) {
+        return false;
+    }
+
+    return rows * 2 + (cols - 2) * 2 <= MAX_CELLS;
 }
 
 /**
@@ -482,7 +720,7 @@ bool pawnCompletesLapInCurrentPlay(int player, int totalCells, int srcIndex, int
 /**
  * @brief Returns whether a pawn is moveable or not.
  * @param pawn The given pawn
- * @param boardCells Linked list with board cells
+ * @param boardCells Board with all cells
  * @param player The current player (P1 - 'true', P2 - 'false')
  * @return Returns whether pawn is moveable
  */
@@ -490,22 +728,121 @@ bool isPawnMovable(char pawn, list *boardCells, bool player1) {
     int pawnIndex = getPawnIndex(pawn);
     int homeP1 = 0;
     int homeP2 = boardCells->length / 2;
-    node currentNode = *boardCells->head;
 
+    // If the pawn is not uppercase then its moveable
     if (player1) {
-        if (currentNode.item.jogador_peao[0][pawnIndex] != WIN) {
-            return true;
-        }
+        return casaPawnState(boardCells->cells[homeP1], 0, pawnIndex) != WIN;
     } else {
-        for (int pos = homeP1; pos <= homeP2; pos++) {
-            // If the pawn is not uppercase then its moveable
-            if (pos == homeP2 && currentNode.item.jogador_peao[1][pawnIndex] != WIN) {
-                return true;
-            }
+        return casaPawnState(boardCells->cells[homeP2], 1, pawnIndex) != WIN;
+    }
+}
+
+/**
+ * @brief Initializes an empty safe cells set.
+ * @param safeCells The safe cells set
+ */
+void initializeSafeCells(safeCellSet *safeCells) {
+    safeCells->isSafe = NULL;
+    safeCells->length = 0;
+    safeCells->memory = NULL;
+}
 
-            // Gets next node
-            currentNode = *currentNode.next;
+/**
+ * @brief Marks a cell as safe, growing the set if the cell is beyond its current length.
+ * @param safeCells The safe cells set
+ * @param cellIndex The cell to mark (0 to 'MAX_CELLS' - 1)
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int addSafeCell(safeCellSet *safeCells, int cellIndex) {
+    if (cellIndex >= safeCells->length) {
+        // Doubles the set so reading 'n' cells takes a logarithmic number of reallocations
+        int newLength = safeCells->length > 0 ? safeCells->length : 128;
+        unsigned char *isSafe;
+
+        while (newLength <= cellIndex) {
+            newLength *= 2;
         }
+
+        isSafe = memRealloc(safeCells->memory, MEM_SAFE_CELLS, safeCells->isSafe, newLength);
+        if (isSafe == NULL) {
+            return 1;
+        }
+
+        memset(isSafe + safeCells->length, 0, newLength - safeCells->length);
+        safeCells->isSafe = isSafe;
+        safeCells->length = newLength;
     }
-    return false;
+
+    safeCells->isSafe[cellIndex] = 1;
+    return 0;
+}
+
+/**
+ * @brief Gets the board safe cells from the config file given as a program argument
+ * @param fileName The name of the config file
+ * @param safeCells The set that receives all the safe cells read from the config file
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+*/
+int getSafeCellsFromConfigFile(char *fileName, safeCellSet *safeCells) {
+    FILE *fp;
+    int numberRead;
+    int scanResult;  // Stores the result of each 'fscanf'
+
+    // Opens config file in 'read' mode
+    fp = fopen(fileName, "r");
+
+    // Checks for file read errors
+    if (fp == NULL) {
+        fputs(FILE_ERR1, stdout);
+        fputs(INVAL_PARAMS, stdout);
+        return 1;
+    }
+
+    // Reads all numbers from config file and stores them in 'safeCells'
+    while ((scanResult = fscanf(fp, "%d", &numberRead)) != EOF) {
+        if (scanResult == 0) {
+            // Prints ERROR message and breaks the loop in case the read value is not valid
+            printf("%s", FILE_ERR2);
+            puts(INVAL_PARAMS);
+            fclose(fp);
+            return 1;
+        }
+        
+        if (numberRead < 0 || numberRead >= MAX_CELLS || addSafeCell(safeCells, numberRead) == 1) {
+            // Prints ERROR message in case the number read is not a cell of the largest board
+            printf("%s", FILE_ERR2);
+            puts(INVAL_PARAMS);
+            fclose(fp);
+            return 1;
+        }
+    }
+
+    // Closes file stream
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief Frees the memory of a safe cells set. The set keeps its memory tracker.
+ * @param safeCells The safe cells set
+ */
+void freeSafeCells(safeCellSet *safeCells) {
+    memTracker *memory = safeCells->memory;
+
+    memFree(memory, safeCells->isSafe);
+    initializeSafeCells(safeCells);
+    safeCells->memory = memory;
+}
+
+/**
+ * @brief Frees all memory allocations related to the board cells. Can be called
+ * on an empty board and more than once. The board keeps its memory tracker.
+ * @param boardCells Board with all cells
+ */
+void freeBoardCells(list* boardCells) {
+    memTracker *memory = boardCells->memory;
+
+    memFree(memory, boardCells->cells);
+    initializeCellsList(boardCells);
+    boardCells->memory = memory;
 }
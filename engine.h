@@ -1,21 +1,65 @@
 #ifndef __engine_h__
 #define __engine_h__
 
+#include <stdbool.h>
+
 #include "board.h"
+#include "memtrack.h"
+#include "rng.h"
+
+#define MAX_CELLS 65536  // Defines the max number of cells that can exist in the board
+#define MAX_DICES_VALUE (STANDARD_DICES * DICE_FACES)  // Defines the max value of the dices in a single play of the standard game
+#define MAX_PLAY_AMOUNT (MAX_DICES * DICE_FACES)  // Defines the max value of the dices in a single play with any number of dices
+#define MAX_MOVES (MAX_PAWNS * (MAX_PLAY_AMOUNT - MAX_DICES + 1))  // Defines the max number of moves of a player (every pawn with every dices value)
+
+/**
+ * Safe cells read from a config file, sized to the highest cell index read.
+ */
+typedef struct {
+    unsigned char *isSafe;  // 'isSafe[n]' is 1 if cell 'n' is a safe cell
+    int length;  // Number of entries in 'isSafe'
+    memTracker *memory;  // Tracker of 'isSafe' (NULL if not accounted)
+} safeCellSet;
+
+/**
+ * Legal move: a pawn played with a dices value and its result.
+ */
+typedef struct {
+    char pawn;
+    int dicesValue;
+    int destination;  // Cell where the pawn ends (its home if it completes the lap)
+    bool win;  // Whether the pawn completes its lap
+    int captures;  // Number of adversary pawns captured
+} gameMove;
 
-#define MAX_CELLS 128  // Defines the max number of cells that can exist in the board
+// Play function specialised for a board size and number of pawns (see 'makePlay')
+typedef int (*playKernel)(list *boardCells, char pawn, int amount);
 
 void initializeCellsList(list *boardCells);
-int insertBoardCell(list *boardCells, node *cell);
-int boardSetup(list *boardCells, int *safeCells, int totalCells);
+int boardSetup(list *boardCells, const safeCellSet *safeCells, int totalCells);
+void boardSetupCells(list *boardCells, casa *cells, const safeCellSet *safeCells, int totalCells);
+void boardReset(list *boardCells);
+int boardClone(list *destination, const list *source);
+void boardCopy(list *destination, const list *source);
 bool validPawn(char pawn, bool player1);
 int checkGameWin(list *boardCells, int totalCells);
 int getPawnIndex(char pawn);
+int getPawnPlayer(char pawn);
 int getPawnNodeIndex(list *boardCells, char pawn);
 void movePawn(list *boardCells, char pawn, int pawnIndex, int srcIndex, int destIndex);
 void resetAdversaryPawn(list *boardCells, char pawn, int player, int pawnSrcIndex);
-void makePlay(list *boardCells, char pawn, int amount);
+int resetAdversaryPawns(list *boardCells, int player, const int *cells, int totalCaptureCells);
+int makePlay(list *boardCells, char pawn, int amount);
+int getPlayPath(list *boardCells, char pawn, int amount, int *pathCells);
 bool pawnCompletesLapInCurrentPlay(int player, int totalCells, int srcIndex, int destIndex, int finalDestIndex);
 bool isPawnMovable(char pawn, list *boardCells, bool player);
+int generateMoves(list *boardCells, bool player1, int dicesValue, gameMove *moves);
+bool isLegalPawn(list *boardCells, char pawn, bool player1);
+bool validGameRules(int pawns, int dices);
+bool validBoardSize(unsigned long rows, unsigned long cols);
+void initializeSafeCells(safeCellSet *safeCells);
+int getSafeCellsFromConfigFile(char *fileName, safeCellSet *safeCells);
+void freeSafeCells(safeCellSet *safeCells);
+void freeBoardCells(list* boardCells);
 
 #endif
\ No newline at end of file
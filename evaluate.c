@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include "evaluate.h"
+#include "engine.h"
+
+/*
+    Heuristic evaluation of a position: a weighted sum of a few features read
+    straight from the packed cells and the pawn cells, with no allocation and
+    no board walk, so it can be called millions of times per second.
+*/
+
+// 'REACH_COUNT[n][d]' is the number of rolls of 'n' dices with a sum of at least 'd', out of 'REACH_COUNT[n][0]'
+static const int REACH_COUNT[MAX_DICES + 1][MAX_PLAY_AMOUNT + 1] = {
+    {0},
+    {6, 6, 5, 4, 3, 2, 1},
+    {36, 36, 36, 35, 33, 30, 26, 21, 15, 10, 6, 3, 1},
+    {216, 216, 216, 216, 215, 212, 206, 196, 181, 160, 135, 108, 81, 56, 35, 20, 10, 4, 1},
+    {1296, 1296, 1296, 1296, 1296, 1295, 1291, 1281, 1261, 1226, 1170, 1090, 986, 861, 721, 575, 435, 310, 206, 126, 70, 35, 15, 5, 1}
+};
+
+static const double DEFAULT_WEIGHTS[EVAL_FEATURES] = {1.0, 0.1, -0.3, 0.5};
+
+
+/**
+ * @brief Sets the default weights.
+ * @param weights Receives the weights
+ */
+void evalDefaultWeights(evalWeights *weights) {
+    for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+        weights->weights[feature] = DEFAULT_WEIGHTS[feature];
+    }
+}
+
+/**
+ * @brief Reads the weights from a file with one number per line, in the order of 'evalFeature'.
+ * @param fileName The name of the weights file
+ * @param weights Receives the weights
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (the file can not be read or does not have 'EVAL_FEATURES' numbers)
+ */
+int evalLoadWeights(const char *fileName, evalWeights *weights) {
+    FILE *fp = fopen(fileName, "r");
+    double extra;
+    int result = 0;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    for (int feature = 0; feature < EVAL_FEATURES && result == 0; feature++) {
+        if (fscanf(fp, "%lf", &weights->weights[feature]) != 1) {
+            result = 1;
+        }
+    }
+
+    if (result == 0 && fscanf(fp, "%lf", &extra) != EOF) {
+        result = 1;
+    }
+
+    fclose(fp);
+    return result;
+}
+
+/**
+ * @brief Writes the weights to a file, one number per line.
+ * @param fileName The name of the weights file
+ * @param weights The weights
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int evalSaveWeights(const char *fileName, const evalWeights *weights) {
+    FILE *fp = fopen(fileName, "w");
+    int failed = fp == NULL;
+
+    for (int feature = 0; feature < EVAL_FEATURES && !failed; feature++) {
+        failed = fprintf(fp, "%.6f\n", weights->weights[feature]) < 0;
+    }
+
+    if (fp != NULL && fclose(fp) != 0) {
+        failed = 1;
+    }
+
+    return failed;
+}
+
+/**
+ * @brief Gets the features of a position, for any number of pawns and dices.
+ * @param boardCells Board with all cells
+ * @param player The player the features are computed for (0 - P1, 1 - P2)
+ * @param features Receives 'EVAL_FEATURES' values
+ */
+void evalFeatures(const list *boardCells, int player, double *features) {
+    int length = boardCells->length;
+    int pawns = boardCells->pawns;
+    int maxReach = boardCells->dices * DICE_FACES;
+    double rolls = REACH_COUNT[boardCells->dices][0];
+    int progress[2][MAX_PAWNS];
+    bool exposed[2][MAX_PAWNS];
+
+    for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+        features[feature] = 0;
+    }
+
+    for (int owner = 0; owner < 2; owner++) {
+        int home = owner == 0 ? 0 : length / 2;
+
+        for (int pawn = 0; pawn < pawns; pawn++) {
+            int cellIndex = boardCells->pawnCells[owner][pawn];
+            casa cell = boardCells->cells[cellIndex];
+            double sign = owner == player ? 1 : -1;
+
+            if (cell & CASA_PAWN_WIN(owner, pawn)) {
+                progress[owner][pawn] = length;
+                exposed[owner][pawn] = false;
+                features[EVAL_WIN] += sign;
+            } else {
+                progress[owner][pawn] = (cellIndex - home + length) % length;
+                exposed[owner][pawn] = !(cell & CASA_SAFE);
+                features[EVAL_SAFE] += cell & CASA_SAFE ? sign : 0;
+            }
+            features[EVAL_PROGRESS] += sign * progress[owner][pawn] / length;
+        }
+    }
+
+    // An adversary pawn reaches a pawn if the dices take it to or past the pawn before its lap ends
+    for (int owner = 0; owner < 2; owner++) {
+        int adversary = 1 - owner;
+        double sign = owner == player ? 1 : -1;
+
+        for (int pawn = 0; pawn < pawns; pawn++) {
+            if (!exposed[owner][pawn]) {
+                continue;
+            }
+
+            for (int adversaryPawn = 0; adversaryPawn < pawns; adversaryPawn++) {
+                int distance = boardCells->pawnCells[owner][pawn] - boardCells->pawnCells[adversary][adversaryPawn];
+
+                distance += distance < 0 ? length : 0;
+                if (distance >= 1 && distance <= maxReach && progress[adversary][adversaryPawn] + distance < length) {
+                    features[EVAL_EXPOSURE] += sign * (REACH_COUNT[boardCells->dices][distance] / rolls);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Evaluates a position for a player.
+ * @param boardCells Board with all cells
+ * @param player The player (0 - P1, 1 - P2)
+ * @param weights The feature weights
+ * @return Returns the weighted sum of the features, higher is better for the player
+ */
+double evaluatePosition(const list *boardCells, int player, const evalWeights *weights) {
+    double features[EVAL_FEATURES];
+    double value = 0;
+
+    evalFeatures(boardCells, player, features);
+    for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+        value += weights->weights[feature] * features[feature];
+    }
+
+    return value;
+}
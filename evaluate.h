@@ -0,0 +1,32 @@
+#ifndef __evaluate_h__
+#define __evaluate_h__
+
+#include "board.h"
+
+/**
+ * Features of a position, each one is the value of the player minus the value
+ * of the adversary, so the evaluation of one player is minus the other's.
+ */
+typedef enum {
+    EVAL_PROGRESS = 0,  // Laps walked by the pawns (a WIN pawn counts as a full lap)
+    EVAL_SAFE = 1,  // Pawns on safe cells
+    EVAL_EXPOSURE = 2,  // Expected adversary pawns that reach a pawn with the next dices (see 'pawnExposure')
+    EVAL_WIN = 3,  // Pawns already WIN
+    EVAL_FEATURES = 4  // Number of features
+} evalFeature;
+
+/**
+ * Weight of each feature. A weights file has one number per line, in the
+ * order of 'evalFeature'.
+ */
+typedef struct {
+    double weights[EVAL_FEATURES];
+} evalWeights;
+
+void evalDefaultWeights(evalWeights *weights);
+int evalLoadWeights(const char *fileName, evalWeights *weights);
+int evalSaveWeights(const char *fileName, const evalWeights *weights);
+void evalFeatures(const list *boardCells, int player, double *features);
+double evaluatePosition(const list *boardCells, int player, const evalWeights *weights);
+
+#endif
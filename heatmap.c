@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <assert.h>
+#include "heatmap.h"
+#include "engine.h"
+#include "memtrack.h"
+
+/*
+    Capture and traffic heatmap: per cell counters of the plays recorded with
+    'heatmapPlay', rendered over the board layout ('boardPrintLayout') or
+    written as CSV.
+*/
+
+#define HEATMAP_SHADES " .:-=+*#%@"  // Shades from the safest to the most dangerous cell
+#define HEATMAP_MAX_RATE 9999  // Max captures per 1000 plays shown in a cell
+
+/**
+ * Data given to the heatmap cell printer.
+ */
+typedef struct {
+    const heatmap *traffic;
+    const list *boardCells;
+    long maxCaptures;  // Captures of the most dangerous cell
+} heatmapView;
+
+
+/**
+ * @brief Initializes a heatmap with all counters at zero.
+ * @param traffic The heatmap
+ * @param totalCells The number of total cells
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int heatmapInit(heatmap *traffic, int totalCells) {
+    traffic->cells = memCalloc(NULL, MEM_HEATMAPS, totalCells, sizeof(cellTraffic));
+    traffic->length = traffic->cells != NULL ? totalCells : 0;
+    traffic->plays = 0;
+
+    return traffic->cells == NULL;
+}
+
+/**
+ * @brief Frees the memory of a heatmap.
+ * @param traffic The heatmap
+ */
+void heatmapFree(heatmap *traffic) {
+    memFree(NULL, traffic->cells);
+    traffic->cells = NULL;
+    traffic->length = 0;
+}
+
+/**
+ * @brief Makes a play (same as 'makePlay') and records it in the heatmap.
+ * @param traffic The heatmap
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @return Returns the number of adversary pawns captured in the play
+ */
+int heatmapPlay(heatmap *traffic, list *boardCells, char pawn, int amount) {
+    int player = getPawnPlayer(pawn);
+    int pathCells[MAX_PLAY_AMOUNT];
+    int totalPathCells = getPlayPath(boardCells, pawn, amount, pathCells);
+    int landing;
+    int captures;
+    int pathCaptures = 0;
+
+    // Adversary pawns on the path are captured, unless they are on a safe cell
+    for (int i = 0; i < totalPathCells; i++) {
+        casa cell = boardCells->cells[pathCells[i]];
+        int adversaryPawns = __builtin_popcount(cell & CASA_PLAYER_PAWNS(1 - player));
+
+        if (casaIsSafe(cell)) {
+            traffic->cells[pathCells[i]].safeSits += adversaryPawns;
+        } else {
+            traffic->cells[pathCells[i]].captures += adversaryPawns;
+            pathCaptures += adversaryPawns;
+        }
+    }
+
+    captures = makePlay(boardCells, pawn, amount);
+    assert(captures == pathCaptures);
+    (void) pathCaptures;
+
+    // The pawn lands on its destination or, after a full lap, on its home cell
+    landing = boardCells->pawnCells[player][getPawnIndex(pawn)];
+    traffic->cells[landing].lands++;
+    for (int i = 0; i < totalPathCells; i++) {
+        if (pathCells[i] != landing) {
+            traffic->cells[pathCells[i]].passes++;
+        }
+    }
+    traffic->plays++;
+
+    return captures;
+}
+
+/**
+ * @brief Adds the counters of a heatmap to another one of the same board.
+ * @param traffic The heatmap that receives the counters
+ * @param other The heatmap with the counters to add
+ */
+void heatmapMerge(heatmap *traffic, const heatmap *other) {
+    assert(traffic->length == other->length);
+
+    for (int cellIndex = 0; cellIndex < traffic->length; cellIndex++) {
+        traffic->cells[cellIndex].lands += other->cells[cellIndex].lands;
+        traffic->cells[cellIndex].passes += other->cells[cellIndex].passes;
+        traffic->cells[cellIndex].captures += other->cells[cellIndex].captures;
+        traffic->cells[cellIndex].safeSits += other->cells[cellIndex].safeSits;
+    }
+    traffic->plays += other->plays;
+}
+
+/**
+ * @brief Gets the captures on a cell per 1000 plays.
+ * @param traffic The heatmap
+ * @param cellIndex The cell
+ * @return Returns the capture rate of the cell
+ */
+static long captureRate(const heatmap *traffic, int cellIndex) {
+    return traffic->plays > 0 ? traffic->cells[cellIndex].captures * 1000 / traffic->plays : 0;
+}
+
+/**
+ * @brief Prints a line of a heatmap cell: the danger shade, the safe cell
+ * mark and the captures per 1000 plays.
+ * @param out Where the line is written
+ * @param line The line of the cell
+ * @param pos The cell
+ * @param data The heatmap view
+ * @param width Number of digits of the cell numbers
+ */
+static void printHeatmapCasaLine(boardWriter *out, line_rendering line, int pos, const void *data, int width) {
+    const heatmapView *view = data;
+    long captures = view->traffic->cells[pos].captures;
+    long rate = captureRate(view->traffic, pos);
+    char shade = HEATMAP_SHADES[view->maxCaptures > 0 ? captures * 9 / view->maxCaptures : 0];
+
+    switch (line) {
+        case HEADER:
+            boardWriterPrintf(out, "+--%*d--+", width, pos);
+            break;
+        case OCCUPANCY_1:
+            boardWriterPrintf(out, "| %c%c%c%c %*s|", shade, shade, shade, shade, width - 2, "");
+            break;
+        case SAFE_HOUSE:
+            boardWriterPrintf(out, "| %s %*s|", casaIsSafe(view->boardCells->cells[pos]) ? "****" : "    ", width - 2, "");
+            break;
+        case OCCUPANCY_2:
+            boardWriterPrintf(out, "| %4ld %*s|", rate < HEATMAP_MAX_RATE ? rate : HEATMAP_MAX_RATE, width - 2, "");
+            break;
+        case TAIL:
+            boardWriterPutc(out, '+');
+            for (int k = 0; k < width + 4; k++) {
+                boardWriterPutc(out, '-');
+            }
+            boardWriterPutc(out, '+');
+    }
+}
+
+/**
+ * @brief Prints the capture heatmap over the board layout.
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param traffic The heatmap
+ * @param boardCells Board with the safe cells of the heatmap games
+ */
+void heatmapPrint(const unsigned int rows, const unsigned int cols, const heatmap *traffic, const list *boardCells) {
+    heatmapView view = {traffic, boardCells, 0};
+    boardWriter out = {stdout, NULL, 0, 0};
+
+    for (int cellIndex = 0; cellIndex < traffic->length; cellIndex++) {
+        if (traffic->cells[cellIndex].captures > view.maxCaptures) {
+            view.maxCaptures = traffic->cells[cellIndex].captures;
+        }
+    }
+
+    boardPrintLayout(&out, rows, cols, printHeatmapCasaLine, &view);
+    printf("Shade: captures from '%c' (none) to '%c' (most), number: captures per 1000 plays, ****: safe cell\n",
+           HEATMAP_SHADES[0], HEATMAP_SHADES[9]);
+}
+
+/**
+ * @brief Writes the heatmap counters as CSV, one row per cell.
+ * @param output The CSV output stream
+ * @param traffic The heatmap
+ * @param boardCells Board with the safe cells of the heatmap games
+ */
+void heatmapWriteCsv(FILE *output, const heatmap *traffic, const list *boardCells) {
+    fputs("cell,safe,lands,passes,captures,safe_sits,captures_per_1000_plays\n", output);
+
+    for (int cellIndex = 0; cellIndex < traffic->length; cellIndex++) {
+        const cellTraffic *cell = &traffic->cells[cellIndex];
+
+        fprintf(output, "%d,%d,%ld,%ld,%ld,%ld,%ld\n", cellIndex, casaIsSafe(boardCells->cells[cellIndex]) == TRUE,
+                cell->lands, cell->passes, cell->captures, cell->safeSits, captureRate(traffic, cellIndex));
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef __heatmap_h__
+#define __heatmap_h__
+
+#include <stdio.h>
+#include "board.h"
+
+/**
+ * Traffic counters of a single cell.
+ */
+typedef struct {
+    long lands;  // Plays that ended on the cell
+    long passes;  // Plays that went through the cell without ending on it
+    long captures;  // Pawns captured on the cell
+    long safeSits;  // Pawns an adversary went through while they were on the cell, safe
+} cellTraffic;
+
+/**
+ * Traffic counters of every cell of a board. Each thread fills its own
+ * heatmap, they are merged when all games are finished.
+ */
+typedef struct {
+    cellTraffic *cells;
+    int length;  // Number of cells
+    long plays;  // Number of plays recorded
+} heatmap;
+
+int heatmapInit(heatmap *traffic, int totalCells);
+void heatmapFree(heatmap *traffic);
+int heatmapPlay(heatmap *traffic, list *boardCells, char pawn, int amount);
+void heatmapMerge(heatmap *traffic, const heatmap *other);
+void heatmapPrint(const unsigned int rows, const unsigned int cols, const heatmap *traffic, const list *boardCells);
+void heatmapWriteCsv(FILE *output, const heatmap *traffic, const list *boardCells);
+
+#endif
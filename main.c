@@ -5,15 +5,21 @@
 
 #include "board.h"
 #include "engine.h"
+#include "snapshot.h"
+#include "cold.h"
+#include "script.h"
+#include "spectator.h"
+#include "policy.h"
+#include "td.h"
+#include "memtrack.h"
 
 
-#define MAX_CELLS 128  // Defines the max number of cells that can exist in the board
-
 /* Program Functions' Declaration */
 
-void showMenu();
-int getSafeCellsFromConfigFile(char *fileName, int *safeCells);
-void freeBoardCells(list* boardCells);
+void showMenu(int pawns, bool memoryReport);
+int restoreGame(const char *fileName, coldGame **game, memTracker *memory);
+void printGame(const coldGame *game, int mode, char **frame, size_t *frameSize);
+void finishMemory(const memTracker *memory, bool report);
 
 
 int main(int argc, char const *argv[])
@@ -23,61 +29,153 @@ int main(int argc, char const *argv[])
     unsigned int boardPresentationMode = 0, linesNum = 3, columnsNum = 7;
     unsigned long int argConversionResult;  // Variable used to get convert cli args to int
     char *tempArg;  // Variable used to get convert cli args to int
-    int safeCells[MAX_CELLS] = {0};  // Stores the safe cells read from the config file
+    safeCellSet safeCells;  // Stores the safe cells read from the config file
     unsigned int totalCells;  // Number of total cells
-    list boardCells;  // List struct to store all board cells data
+    coldConfig config;  // Board and rules of the game
+    coldGame *game;  // Board, player to move, dices and dices generator of the game
     char inputOption;  // Stores user input option
     bool player1;  // Holds the player for the current play
     unsigned int dicesValue;  // Holds dices value for each move
     int gameOver;  // Holds the return of the 'checkGameWin' function
-    bool rollDices = true;  // Whether dices should be rolled again or not
     bool printBoard = true;  // Whether board should be printed or not
+    unsigned char snapshot[SNAPSHOT_SIZE];  // Serialised game state
+    const char *args[5] = {argv[0]};  // Positional program args (without the script options)
+    int totalArgs = 1;  // Number of positional program args
+    const char *scriptFile = NULL;  // Script file given with '--script' (NULL in interactive mode)
+    bool finalBoardOnly = false;  // Whether only the final board should be printed (script mode)
+    script commands = {NULL, 0, 0};  // Commands read from the script file
+    const char *spectatorSocket = NULL;  // Socket given with '--spectate' (NULL if nobody watches)
+    spectatorServer spectators;  // Viewers watching the game
+    char caption[SPECTATOR_CAPTION_SIZE];  // Text shown to the viewers above the board
+    const char *opponentFile = NULL;  // Learned weights given with '--opponent' (NULL if P2 is a person)
+    tdWeights opponentWeights;  // Weights of the learned policy that plays P2
+    policyContext opponent;  // Random choices and scratch board of the learned policy
+    memTracker memory;  // Memory accounting of the game (board and safe cells)
+    char *frame = NULL;  // Board rendered by the game, printed on the screen
+    size_t frameSize = 0;  // Size of 'frame'
+    bool memoryReport = false;  // Whether the memory report is printed on exit and with 'm' ('--memory')
+    long pawns = STANDARD_PAWNS;  // Pawns of each player ('--pawns')
+    long dices = STANDARD_DICES;  // Dices rolled in each play ('--dices')
+
+    // Separates the script, spectator, opponent, memory and rules options from the positional args
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            scriptFile = argv[++i];
+        } else if (strcmp(argv[i], "--final-board") == 0) {
+            finalBoardOnly = true;
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectatorSocket = argv[++i];
+        } else if (strcmp(argv[i], "--opponent") == 0 && i + 1 < argc) {
+            opponentFile = argv[++i];
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            memoryReport = true;
+        } else if (strcmp(argv[i], "--pawns") == 0 && i + 1 < argc) {
+            pawns = strtol(argv[++i], &tempArg, 10);
+            if (tempArg == argv[i] || *tempArg != '\0') {
+                puts(INVAL_PARAMS);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--dices") == 0 && i + 1 < argc) {
+            dices = strtol(argv[++i], &tempArg, 10);
+            if (tempArg == argv[i] || *tempArg != '\0') {
+                puts(INVAL_PARAMS);
+                return 0;
+            }
+        } else if (totalArgs < 5) {
+            args[totalArgs++] = argv[i];
+        }
+    }
 
-    // Initializes random seed
-    srand(1);
+    // Only prints the final board when running a script
+    if (finalBoardOnly && scriptFile == NULL) {
+        puts(INVAL_PARAMS);
+        return 0;
+    }
+
+    // The learned P2 only knows the standard game
+    if (!validGameRules(pawns, dices) || (opponentFile != NULL && (pawns != STANDARD_PAWNS || dices != STANDARD_DICES))) {
+        puts(INVAL_PARAMS);
+        return 0;
+    }
+
+    // Reads all script commands at once and writes the output through a single large buffer
+    if (scriptFile != NULL) {
+        if (loadScript(scriptFile, &commands) == 1) {
+            fputs(FILE_ERR1, stdout);
+            puts(INVAL_PARAMS);
+            return 0;
+        }
+        setvbuf(stdout, NULL, _IOFBF, SCRIPT_OUTPUT_BUFFER);
+    }
+
+    // Reads the weights of the learned P2
+    if (opponentFile != NULL && tdLoadWeights(opponentFile, &opponentWeights) == 1) {
+        fputs(FILE_ERR1, stdout);
+        puts(INVAL_PARAMS);
+        freeScript(&commands);
+        return 0;
+    }
+
+    // Nobody watches until the spectator socket is open
+    spectatorInit(&spectators);
+
+    // Initializes the safe cells set (empty until a config file is read), accounted to the game
+    memTrackerInit(&memory);
+    initializeSafeCells(&safeCells);
+    safeCells.memory = &memory;
 
     // Gets program args and checks if they're valid
-    for (int i = 1; i < argc; i++) {
+    for (int i = 1; i < totalArgs; i++) {
         // Checks if 'Board Presentation Mode' argument is set and valid
         if (i == 1) {
-            argConversionResult = argv[i][0] == '0' || argv[i][0] == '1' ? argv[i][0] - '0' : -1;
+            argConversionResult = args[i][0] == '0' || args[i][0] == '1' ? args[i][0] - '0' : -1;
             if (argConversionResult == 0 || argConversionResult == 1) {
                 boardPresentationMode = argConversionResult;
             } else {
                 puts(INVAL_PARAMS);
+                freeScript(&commands);
                 return 0;
             }
         }
 
         // Checks if the 'Number of lines' is set and valid
         if (i == 2) {
-            argConversionResult = strtoul(argv[i], &tempArg, 10);
-            if (argConversionResult >= MIN_ROWS && argConversionResult % 2 != 0) {
+            argConversionResult = strtoul(args[i], &tempArg, 10);
+            if (argConversionResult >= MIN_ROWS && argConversionResult % 2 != 0 && argConversionResult <= MAX_CELLS) {
                 linesNum = argConversionResult;
             } else {
                 puts(INVAL_PARAMS);
+                freeScript(&commands);
                 return 0;
             }
         }
 
         // Checks if the 'Number of Columns' is set and valid
         if (i == 3) {
-            argConversionResult = strtoul(argv[i], &tempArg, 10);
-            if (argConversionResult > MIN_COLS) {
+            argConversionResult = strtoul(args[i], &tempArg, 10);
+            if (argConversionResult > MIN_COLS && argConversionResult <= MAX_CELLS) {
                 columnsNum = argConversionResult;
             } else {
                 puts(INVAL_PARAMS);
+                freeScript(&commands);
                 return 0;
             }
         }
 
         // Checks if the 'Configuration File' is present and reads its content
         if (i == 4) {
+            int getSafeCells;
+
+            // Prints message before opening the file to be read (the tools keep stdout for their results)
+            printf("fich %s\n", args[i]);
+
             // Reads safe cells from config file and stores them in an array
-            int getSafeCells = getSafeCellsFromConfigFile((char*)argv[i], safeCells);
+            getSafeCells = getSafeCellsFromConfigFile((char*)args[i], &safeCells);
 
             // Exits program if it fails to get safe cells from the config file
             if (getSafeCells == 1) {
+                freeSafeCells(&safeCells);
+                freeScript(&commands);
                 return 0;
             }
         }
@@ -86,16 +184,55 @@ int main(int argc, char const *argv[])
     // Updates the number of total cells based on given arguments
     totalCells = linesNum * 2 + (columnsNum - 2) * 2;
 
-    // Initializes the board cells list
-    initializeCellsList(&boardCells);
+    // Checks if the board fits in the max number of cells
+    if (totalCells > MAX_CELLS) {
+        puts(INVAL_PARAMS);
+        freeSafeCells(&safeCells);
+        freeScript(&commands);
+        return 0;
+    }
+
+    // Creates the game (Board Setup) with the given rules and random seed, accounted to the game
+    coldConfigInit(&config);
+    config.rows = linesNum;
+    config.cols = columnsNum;
+    config.pawns = pawns;
+    config.dices = dices;
+    config.safeCells = &safeCells;
+    config.memory = &memory;
+    game = coldNew(&config);
+    if (game == NULL) {
+        puts(INVAL_PARAMS);
+        freeSafeCells(&safeCells);
+        freeScript(&commands);
+        return 0;
+    }
+
+    // The learned P2 tries its plays on a board of the same size
+    initializeCellsList(&opponent.scratch);
+    if (opponentFile != NULL && policyContextInit(&opponent, coldBoard(game), 1) == 1) {
+        coldFree(game);
+        freeSafeCells(&safeCells);
+        freeScript(&commands);
+        return 0;
+    }
 
-    // Adds cells to board (Board Setup)
-    boardSetup(&boardCells, safeCells, totalCells);
+    // Opens the socket the viewers connect to
+    if (spectatorSocket != NULL && spectatorOpen(spectatorSocket, &spectators) == 1) {
+        puts(INVAL_PARAMS);
+        policyContextFree(&opponent);
+        coldFree(game);
+        freeSafeCells(&safeCells);
+        freeScript(&commands);
+        return 0;
+    }
     
     // Prints game info for the first time
-    boardPrint(linesNum, columnsNum, boardCells, boardPresentationMode);  // Prints board
-    showMenu();  // Prints menu
-    player1 = true;  // Sets player 1 as the starting player
+    if (!finalBoardOnly) {
+        printGame(game, boardPresentationMode, &frame, &frameSize);  // Prints board
+        showMenu(coldBoard(game)->pawns, memoryReport);  // Prints menu
+    }
+    spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), "");
 
     // Game Loop
     do {
@@ -103,12 +240,23 @@ int main(int argc, char const *argv[])
             Checks if game is over (i.e. if a player won)
             It it is, prints the winner and exits program
         */
-        gameOver = checkGameWin(&boardCells, totalCells);
+        gameOver = coldIsOver(game);
 
         // Checks if P1 won
         if (gameOver == 1) {
+            if (finalBoardOnly) {
+                printGame(game, boardPresentationMode, &frame, &frameSize);
+            }
+            spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), PL1_WINS "\n" EXIT_MSG "\n");
+
             // Frees all mem allocs related to board
-            freeBoardCells(&boardCells);
+            spectatorClose(&spectators);
+            policyContextFree(&opponent);
+            coldFree(game);
+            freeSafeCells(&safeCells);
+            freeScript(&commands);
+            free(frame);
+            finishMemory(&memory, memoryReport);
             puts(PL1_WINS);
             puts(EXIT_MSG);
             return 0;
@@ -116,58 +264,136 @@ int main(int argc, char const *argv[])
 
         // Checks if P2 won
         if (gameOver == 2) {
+            if (finalBoardOnly) {
+                printGame(game, boardPresentationMode, &frame, &frameSize);
+            }
+            spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), PL2_WINS "\n" EXIT_MSG "\n");
+
             // Frees all mem allocs related to board
-            freeBoardCells(&boardCells);
+            spectatorClose(&spectators);
+            policyContextFree(&opponent);
+            coldFree(game);
+            freeSafeCells(&safeCells);
+            freeScript(&commands);
+            free(frame);
+            finishMemory(&memory, memoryReport);
             puts(PL2_WINS);
             puts(EXIT_MSG);
             return 0;
         }
 
-        // Prints current player move
-        if (player1) {
-            puts(PL1_MOVE);
-        } else {
-            puts(PL2_MOVE);
+        // Rolls dices for current player move (the dices are kept until a pawn is played)
+        player1 = coldPlayer1(game);
+        dicesValue = coldRoll(game);
+
+        // Prints current player move and the dices value
+        if (!finalBoardOnly) {
+            if (player1) {
+                puts(PL1_MOVE);
+            } else {
+                puts(PL2_MOVE);
+            }
+            printf("%s %d\n", PL_DICE, dicesValue);
+            printf(">");  // Input cursor
         }
 
-        // Rolls dices for current player move and prints the value
-        if (rollDices) {
-            dicesValue = rolldice(2);
-            rollDices = true;
+        // Reads the next command from the learned P2, the script or the user input
+        if (opponentFile != NULL && !player1) {
+            inputOption = tdPolicy(coldBoard(game), player1, dicesValue, &opponent, &opponentWeights);
+            if (!finalBoardOnly) {
+                printf("%c\n", inputOption);
+            }
+        } else if (scriptFile != NULL) {
+            inputOption = nextScriptCommand(&commands);
+        } else {
+            fflush(stdout);
+            scanf(" %c", &inputOption);
         }
-        printf("%s %d\n", PL_DICE, dicesValue);
-        
-        printf(">");  // Input cursor
-        scanf(" %c", &inputOption);  // Reads user input
 
         switch (inputOption) {
             case 'h':
-                showMenu();
-                rollDices = false;
+                showMenu(coldBoard(game)->pawns, memoryReport);
                 printBoard = false;
                 break;
 
             case 's':
+                if (finalBoardOnly) {
+                    printGame(game, boardPresentationMode, &frame, &frameSize);
+                }
+
                 // Prints end game message and exits
                 puts(EXIT_MSG);
+                spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), EXIT_MSG "\n");
                 // Do not print board before exiting game
                 printBoard = false;
                 // Frees all mem allocs related to board
-                freeBoardCells(&boardCells);
+                spectatorClose(&spectators);
+                policyContextFree(&opponent);
+                coldFree(game);
+                freeSafeCells(&safeCells);
+                freeScript(&commands);
+                free(frame);
                 // Skips to the end
                 break;
+
+            case 'g':
+                // Saves the current game state, the pending dices are kept for this play
+                if (coldSave(game, snapshot) == 0 && saveSnapshotFile(SAVE_FILE, snapshot) == 0) {
+                    puts(SAVE_OK);
+                } else {
+                    puts(SAVE_ERR);
+                }
+                printBoard = false;
+                break;
+
+            case 'r':
+                // Restores the saved game state, with the dices that were pending when it was saved
+                if (restoreGame(SAVE_FILE, &game, &memory) == 0) {
+                    linesNum = coldRows(game);
+                    columnsNum = coldCols(game);
+
+                    // The learned P2 only knows the standard game, a person plays it from now on
+                    if (coldBoard(game)->pawns != STANDARD_PAWNS || coldBoard(game)->dices != STANDARD_DICES) {
+                        opponentFile = NULL;
+                    }
+
+                    // The restored board can have another size
+                    if (opponentFile != NULL && opponent.scratch.length != coldBoard(game)->length) {
+                        policyContextFree(&opponent);
+                        if (policyContextInit(&opponent, coldBoard(game), 1) == 1) {
+                            opponentFile = NULL;  // Out of memory, P2 is played by a person from now on
+                        }
+                    }
+                    puts(LOAD_OK);
+                    spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), LOAD_OK "\n");
+                } else {
+                    puts(LOAD_ERR);
+                    printBoard = false;
+                }
+                break;
+
+            case 'm':
+                // Prints the memory report on demand, on the same stream as the report on exit
+                if (memoryReport) {
+                    memReport(&memory, stderr);
+                    printBoard = false;
+                    break;
+                }
+                // Without '--memory' it is not a command
+                // fall through
             
             default:
                 // Checks if the inserted pawn is valid
-                if (validPawn(inputOption, player1) && isPawnMovable(inputOption, &boardCells, player1)) {
-                    makePlay(&boardCells, inputOption, dicesValue);
+                if (coldPlay(game, inputOption) != COLD_ILLEGAL) {
 
-                    // Changes player move after previous play is finished
-                    player1 = !player1;
+                    // Shows the play to the viewers
+                    snprintf(caption, sizeof(caption), "%s\n%s %d\n", player1 ? PL1_MOVE : PL2_MOVE, PL_DICE, dicesValue);
+                    spectatorBroadcastBoard(&spectators, linesNum, columnsNum, coldBoard(game), caption);
                 } else {
                     // Invalid option ERROR message
-                    puts(INVAL_MOVE);
-                    rollDices = false;
+                    if (!finalBoardOnly) {
+                        puts(INVAL_MOVE);
+                    }
                     printBoard = false;
                 }
             
@@ -175,13 +401,14 @@ int main(int argc, char const *argv[])
         }
 
         // Prints the board again after the play or not
-        if (printBoard) {
-            boardPrint(linesNum, columnsNum, boardCells, boardPresentationMode);  // Prints board
+        if (printBoard && !finalBoardOnly) {
+            printGame(game, boardPresentationMode, &frame, &frameSize);  // Prints board
         }
         printBoard = true;
 
     } while (inputOption != 's');
-    
+
+    finishMemory(&memory, memoryReport);
     return 0;
 }
 
@@ -190,80 +417,89 @@ int main(int argc, char const *argv[])
 
 /**
  * @brief Prints the game menu.
- *  
+ * @param pawns Pawns of each player, listed in the pawn id hint
+ * @param memoryReport Whether the memory report command is listed ('--memory')
  */
-void showMenu() {
+void showMenu(int pawns, bool memoryReport) {
+    char pawnIds[sizeof("<id do peao> (, )") + sizeof(SYMBOLS_J1) + sizeof(SYMBOLS_J2)];  // Fits every pawn symbol of both players
+
+    snprintf(pawnIds, sizeof(pawnIds), "<id do peao> (%.*s, %.*s)", pawns, SYMBOLS_J1 + 1, pawns, SYMBOLS_J2 + 1);
+
     puts("+------------------------------------+");
     puts("|         Nao Te Constipes           |");
     puts("+------------------------------------+");
-    puts("| <id do peao> (abcd, xyzw)          |");
+    printf("| %-34s |\n", pawnIds);
     puts("| s - sair                           |");
     puts("| h - imprimir menu                  |");
+    puts("| g - gravar jogo                    |");
+    puts("| r - restaurar jogo gravado         |");
+    if (memoryReport) {
+        puts("| m - relatorio de memoria           |");
+    }
     puts("+------------------------------------+");
 }
 
 /**
- * @brief Gets the board safe cells from the config file given as a program argument
- * @param fileName The name of the config file
- * @param safeCells An array which stores all the safe cells read from the config file
- * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
-*/
-int getSafeCellsFromConfigFile(char *fileName, int *safeCells) {
-    FILE *fp;
-    int numberRead;
-
-    // Prints message before opening the file to be read
-    printf("fich %s\n", fileName);
-
-    // Opens config file in 'read' mode
-    fp = fopen(fileName, "r");
-
-    // Checks for file read errors
-    if (fp == NULL) {
-        fputs(FILE_ERR1, stdout);
-        fputs(INVAL_PARAMS, stdout);
+ * @brief Restores a saved game. The saved game is read and validated into a new
+ * game, which only then replaces the current one.
+ * @param fileName The name of the file with the saved game
+ * @param game The current game, replaced by the saved game
+ * @param memory Memory accounting of the game
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (the current game is kept)
+ */
+int restoreGame(const char *fileName, coldGame **game, memTracker *memory) {
+    unsigned char snapshot[SNAPSHOT_SIZE];  // Serialised game state
+    coldGame *savedGame;  // Game built from the snapshot
+
+    if (loadSnapshotFile(fileName, snapshot) == 1) {
         return 1;
     }
 
-    // Reads all numbers from config file and stores them in 'safeCells'
-    while (!feof(fp)) {
-        if (fscanf(fp, "%d", &numberRead) == 0) {
-            // Prints ERROR message and breaks the loop in case the read value is not valid
-            printf("%s", FILE_ERR2);
-            puts(INVAL_PARAMS);
-            return 1;
-        }
-        
-        if (numberRead < MAX_CELLS) {
-            safeCells[numberRead] = 1;
-        } else {
-            // Prints ERROR message in case the number read is greater the the max number of cells
-            printf("%s", FILE_ERR2);
-            puts(INVAL_PARAMS);
-            return 1;
-        }
+    savedGame = coldNewFromSnapshot(snapshot, memory);
+    if (savedGame == NULL) {
+        return 1;
     }
 
-    // Closes file stream
-    fclose(fp);
+    coldFree(*game);
+    *game = savedGame;
     return 0;
 }
 
 /**
- * @brief Frees all memory allocations related to the board nodes.
- * @param boardCells Linked list with board cells
+ * @brief Prints the board of the game on the screen, rendered by the game into a
+ * buffer that grows to the size of the board.
+ * @param game The game
+ * @param mode Board presentation mode
+ * @param frame Buffer the board is rendered into (can be NULL)
+ * @param frameSize Size of the buffer
  */
-void freeBoardCells(list* boardCells) {
-    node *currentNode = boardCells->head;  // Stores current node
-    node *nextNode = currentNode->next;  // Stores next node
-    
-    for (int cell = 0; cell < boardCells->length; cell++) {
-        free(currentNode);
+void printGame(const coldGame *game, int mode, char **frame, size_t *frameSize) {
+    size_t length = coldRenderToBuffer(game, mode, *frame, *frameSize);
+
+    // Renders again into a buffer large enough for the whole board
+    if (length >= *frameSize) {
+        char *largerFrame = realloc(*frame, length + 1);
 
-        if (cell != boardCells->length - 1) {
-            // Updates 'currentNode' and 'nextNode'
-            currentNode = nextNode;
-            nextNode = currentNode->next;
+        if (largerFrame == NULL) {
+            return;
         }
+        *frame = largerFrame;
+        *frameSize = length + 1;
+        coldRenderToBuffer(game, mode, *frame, *frameSize);
+    }
+
+    fwrite(*frame, 1, length, stdout);
+}
+
+/**
+ * @brief Ends the memory accounting of the game: prints the report if asked and,
+ * in debug builds, the memory that was not freed.
+ * @param memory Memory accounting of the game
+ * @param report Whether the report is printed
+ */
+void finishMemory(const memTracker *memory, bool report) {
+    if (report) {
+        memReport(memory, stderr);
     }
-}
\ No newline at end of file
+    memCheckLeaks(memory, stderr);
+}
@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "memtrack.h"
+
+/*
+    Memory accounting: every block has a header before it with its size,
+    subsystem and tracker, so frees are accounted without a lookup. Debug
+    builds also list the live blocks of each tracker: a block is looked up
+    there before its header is read, so a block freed twice (or not
+    allocated with that tracker) is reported and the program aborts without
+    touching freed memory. 'memCheckLeaks' lists the subsystems with blocks
+    still allocated. Untracked blocks (NULL tracker) are not checked.
+*/
+
+static const char *const SUBSYSTEM_NAMES[MEM_SUBSYSTEMS] = {"board", "board clones", "safe cells", "heatmaps"};
+
+/**
+ * Header of a block, padded so the block keeps the 'malloc' alignment.
+ */
+typedef union {
+    struct {
+        memTracker *tracker;  // Tracker the block is accounted to (can be NULL)
+        size_t size;  // Bytes requested
+        uint32_t subsystem;
+    } info;
+    max_align_t alignment;
+} memHeader;
+
+
+/**
+ * @brief Initializes a tracker with all counters at 0.
+ * @param tracker The tracker
+ */
+void memTrackerInit(memTracker *tracker) {
+    memCounters *counters[MEM_SUBSYSTEMS + 1];
+
+    for (int subsystem = 0; subsystem < MEM_SUBSYSTEMS; subsystem++) {
+        counters[subsystem] = &tracker->subsystems[subsystem];
+    }
+    counters[MEM_SUBSYSTEMS] = &tracker->total;
+
+    for (int i = 0; i <= MEM_SUBSYSTEMS; i++) {
+        atomic_init(&counters[i]->liveBytes, 0);
+        atomic_init(&counters[i]->peakBytes, 0);
+        atomic_init(&counters[i]->allocations, 0);
+        atomic_init(&counters[i]->frees, 0);
+    }
+
+    for (int slot = 0; slot < MEM_LIVE_SLOTS; slot++) {
+        atomic_init(&tracker->liveBlocks[slot], NULL);
+    }
+    atomic_init(&tracker->unlistedBlocks, 0);
+}
+
+/**
+ * @brief Adds a block to the live blocks of its tracker (debug builds).
+ * @param tracker The tracker
+ * @param block The block
+ */
+static void listBlock(memTracker *tracker, void *block) {
+#ifndef NDEBUG
+    for (int slot = 0; slot < MEM_LIVE_SLOTS; slot++) {
+        void *expected = NULL;
+
+        if (atomic_compare_exchange_strong(&tracker->liveBlocks[slot], &expected, block)) {
+            return;
+        }
+    }
+    atomic_fetch_add(&tracker->unlistedBlocks, 1);
+#else
+    (void) tracker;
+    (void) block;
+#endif
+}
+
+/**
+ * @brief Takes a block out of the live blocks of its tracker, aborting (debug
+ * builds) if the tracker does not have it: it was freed already or it was not
+ * allocated with that tracker. Must be called before the header is read.
+ * @param tracker The tracker
+ * @param block The block
+ */
+static void unlistBlock(memTracker *tracker, void *block) {
+#ifndef NDEBUG
+    long unlisted;
+
+    for (int slot = 0; slot < MEM_LIVE_SLOTS; slot++) {
+        void *expected = block;
+
+        if (atomic_compare_exchange_strong(&tracker->liveBlocks[slot], &expected, NULL)) {
+            return;
+        }
+    }
+
+    // A block that is not listed can only be one of the blocks that did not fit
+    unlisted = atomic_load(&tracker->unlistedBlocks);
+    while (unlisted > 0 && !atomic_compare_exchange_weak(&tracker->unlistedBlocks, &unlisted, unlisted - 1)) {
+    }
+    if (unlisted == 0) {
+        fprintf(stderr, "memory: double free of block %p (or free of a block not allocated with this tracker)\n", block);
+        abort();
+    }
+#else
+    (void) tracker;
+    (void) block;
+#endif
+}
+
+/**
+ * @brief Accounts an allocation.
+ * @param counters The counters
+ * @param size Bytes allocated
+ */
+static void countAllocation(memCounters *counters, size_t size) {
+    long live = atomic_fetch_add(&counters->liveBytes, (long) size) + (long) size;
+    long peak = atomic_load(&counters->peakBytes);
+
+    atomic_fetch_add(&counters->allocations, 1);
+    // A failed exchange reloads 'peak'
+    while (live > peak && !atomic_compare_exchange_weak(&counters->peakBytes, &peak, live)) {
+    }
+}
+
+/**
+ * @brief Accounts a free.
+ * @param counters The counters
+ * @param size Bytes freed
+ */
+static void countFree(memCounters *counters, size_t size) {
+    atomic_fetch_sub(&counters->liveBytes, (long) size);
+    atomic_fetch_add(&counters->frees, 1);
+}
+
+/**
+ * @brief Fills the header of a new block and accounts it.
+ * @param header The header
+ * @param tracker The tracker (can be NULL)
+ * @param subsystem The subsystem
+ * @param size Bytes requested
+ * @return Returns the block after the header
+ */
+static void *startBlock(memHeader *header, memTracker *tracker, memSubsystem subsystem, size_t size) {
+    header->info.tracker = tracker;
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+
+    if (tracker != NULL) {
+        countAllocation(&tracker->subsystems[subsystem], size);
+        countAllocation(&tracker->total, size);
+        listBlock(tracker, header + 1);
+    }
+
+    return header + 1;
+}
+
+/**
+ * @brief Takes a block out of the accounting, checking (debug builds) that
+ * its tracker has it before reading its header.
+ * @param tracker The tracker of the block (NULL if not accounted)
+ * @param block The block
+ * @return Returns the header of the block
+ */
+static memHeader *endBlock(memTracker *tracker, void *block) {
+    memHeader *header;
+
+    if (tracker != NULL) {
+        unlistBlock(tracker, block);
+    }
+
+    header = (memHeader *) block - 1;
+#ifndef NDEBUG
+    if (header->info.tracker != tracker) {
+        fprintf(stderr, "memory: block %p freed with another tracker\n", block);
+        abort();
+    }
+#endif
+
+    if (tracker != NULL) {
+        countFree(&tracker->subsystems[header->info.subsystem], header->info.size);
+        countFree(&tracker->total, header->info.size);
+    }
+
+    return header;
+}
+
+/**
+ * @brief Allocates an accounted block (like 'malloc').
+ * @param tracker The tracker (can be NULL, the block is not accounted)
+ * @param subsystem The subsystem the block is accounted to
+ * @param size Bytes to allocate
+ * @return Returns the block, NULL if there is no memory. It must be freed with 'memFree'
+ */
+void *memAlloc(memTracker *tracker, memSubsystem subsystem, size_t size) {
+    memHeader *header;
+
+    if (size > SIZE_MAX - sizeof(memHeader)) {
+        return NULL;
+    }
+
+    header = malloc(sizeof(memHeader) + size);
+    return header == NULL ? NULL : startBlock(header, tracker, subsystem, size);
+}
+
+/**
+ * @brief Allocates an accounted block filled with zeros (like 'calloc').
+ * @param tracker The tracker (can be NULL, the block is not accounted)
+ * @param subsystem The subsystem the block is accounted to
+ * @param count Number of elements
+ * @param size Bytes of each element
+ * @return Returns the block, NULL if there is no memory. It must be freed with 'memFree'
+ */
+void *memCalloc(memTracker *tracker, memSubsystem subsystem, size_t count, size_t size) {
+    void *block;
+
+    if (size != 0 && count > (SIZE_MAX - sizeof(memHeader)) / size) {
+        return NULL;
+    }
+
+    block = memAlloc(tracker, subsystem, count * size);
+    if (block != NULL) {
+        memset(block, 0, count * size);
+    }
+
+    return block;
+}
+
+/**
+ * @brief Resizes an accounted block (like 'realloc'). The block keeps its tracker and subsystem.
+ * @param tracker The tracker of the block (NULL if not accounted)
+ * @param subsystem The subsystem of a new block (when 'block' is NULL)
+ * @param block The block (can be NULL)
+ * @param size New size in bytes
+ * @return Returns the resized block, NULL if there is no memory (the block is kept)
+ */
+void *memRealloc(memTracker *tracker, memSubsystem subsystem, void *block, size_t size) {
+    memHeader *header, *resized;
+
+    if (block == NULL) {
+        return memAlloc(tracker, subsystem, size);
+    }
+
+    if (size > SIZE_MAX - sizeof(memHeader)) {
+        return NULL;
+    }
+
+    header = endBlock(tracker, block);
+    subsystem = header->info.subsystem;
+
+    resized = realloc(header, sizeof(memHeader) + size);
+    if (resized == NULL) {
+        // The block is kept, so it is accounted again
+        startBlock(header, tracker, subsystem, header->info.size);
+        return NULL;
+    }
+
+    return startBlock(resized, tracker, subsystem, size);
+}
+
+/**
+ * @brief Frees an accounted block (like 'free').
+ * @param tracker The tracker the block was allocated with (NULL if not accounted)
+ * @param block The block (can be NULL)
+ */
+void memFree(memTracker *tracker, void *block) {
+    if (block == NULL) {
+        return;
+    }
+
+    free(endBlock(tracker, block));
+}
+
+/**
+ * @brief Prints the counters of every subsystem and the total.
+ * @param tracker The tracker
+ * @param out Stream the report is written to
+ */
+void memReport(const memTracker *tracker, FILE *out) {
+    fprintf(out, "%-14s %12s %12s %12s %12s\n", "memory", "live bytes", "peak bytes", "allocations", "frees");
+
+    for (int subsystem = 0; subsystem <= MEM_SUBSYSTEMS; subsystem++) {
+        const memCounters *counters = subsystem < MEM_SUBSYSTEMS ? &tracker->subsystems[subsystem] : &tracker->total;
+
+        fprintf(out, "%-14s %12ld %12ld %12ld %12ld\n", subsystem < MEM_SUBSYSTEMS ? SUBSYSTEM_NAMES[subsystem] : "total",
+                atomic_load(&counters->liveBytes), atomic_load(&counters->peakBytes),
+                atomic_load(&counters->allocations), atomic_load(&counters->frees));
+    }
+}
+
+/**
+ * @brief Checks for blocks still allocated. Debug builds print each subsystem
+ * with blocks left, release builds only count them.
+ * @param tracker The tracker
+ * @param out Stream the leaks are written to
+ * @return Returns the number of blocks still allocated
+ */
+long memCheckLeaks(const memTracker *tracker, FILE *out) {
+    long leaks = atomic_load(&tracker->total.allocations) - atomic_load(&tracker->total.frees);
+
+#ifndef NDEBUG
+    for (int subsystem = 0; subsystem < MEM_SUBSYSTEMS; subsystem++) {
+        const memCounters *counters = &tracker->subsystems[subsystem];
+        long blocks = atomic_load(&counters->allocations) - atomic_load(&counters->frees);
+
+        if (blocks != 0) {
+            fprintf(out, "memory: %ld blocks (%ld bytes) of %s not freed\n", blocks,
+                    atomic_load(&counters->liveBytes), SUBSYSTEM_NAMES[subsystem]);
+        }
+    }
+#else
+    (void) out;
+#endif
+
+    return leaks;
+}
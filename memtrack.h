@@ -0,0 +1,51 @@
+#ifndef __memtrack_h__
+#define __memtrack_h__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define MEM_LIVE_SLOTS 64  // Live blocks of a tracker that debug builds check on free
+
+/**
+ * Subsystems the allocations are accounted to.
+ */
+typedef enum {
+    MEM_BOARD = 0,  // Board cells built by 'boardSetup' and games built by 'coldNew'
+    MEM_BOARD_CLONES = 1,  // Boards copied by 'boardClone' (scratch boards of policies and tools)
+    MEM_SAFE_CELLS = 2,  // Safe cells read from the config file
+    MEM_HEATMAPS = 3,  // Per cell traffic counters of 'heatmapInit'
+    MEM_SUBSYSTEMS = 4  // Number of subsystems
+} memSubsystem;
+
+/**
+ * Allocation counters. Updated with atomics, so boards of one tracker can be
+ * allocated and freed by several threads.
+ */
+typedef struct {
+    _Atomic long liveBytes;  // Bytes allocated and not freed yet
+    _Atomic long peakBytes;  // Highest 'liveBytes'
+    _Atomic long allocations;  // Number of allocations (a reallocation counts as a new allocation)
+    _Atomic long frees;  // Number of frees
+} memCounters;
+
+/**
+ * Memory accounting of a game: counters per subsystem and in total. Debug
+ * builds also list the live blocks, so a block is checked before it is freed.
+ */
+typedef struct memTracker {
+    memCounters subsystems[MEM_SUBSYSTEMS];
+    memCounters total;
+    void *_Atomic liveBlocks[MEM_LIVE_SLOTS];  // Blocks allocated and not freed yet (debug builds), NULL if the slot is free
+    _Atomic long unlistedBlocks;  // Live blocks that did not fit in 'liveBlocks' (debug builds)
+} memTracker;
+
+void memTrackerInit(memTracker *tracker);
+void *memAlloc(memTracker *tracker, memSubsystem subsystem, size_t size);
+void *memCalloc(memTracker *tracker, memSubsystem subsystem, size_t count, size_t size);
+void *memRealloc(memTracker *tracker, memSubsystem subsystem, void *block, size_t size);
+void memFree(memTracker *tracker, void *block);
+void memReport(const memTracker *tracker, FILE *out);
+long memCheckLeaks(const memTracker *tracker, FILE *out);
+
+#endif
@@ -0,0 +1,723 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "nnue.h"
+#include "engine.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+    Efficiently updatable neural network evaluation. The first layer sees one
+    feature per pawn (player, pawn and cell, or the WIN slot after the last
+    cell), so a play only changes the features of the moved pawn and of the
+    captured pawns: 'nnuePlay' subtracts their old weight columns from the
+    accumulator and adds the new ones instead of summing every feature again.
+    The accumulator goes through a clipped ReLU into 'NNUE_HIDDEN1' int8
+    activations, a hidden layer of int8 weights ('NNUE_HIDDEN2' outputs, also
+    clipped) and an output of int8 weights, computed with int16 and int8
+    vector dot products (AVX2 or SSE2, scalar fallback otherwise). The output
+    is the logit of P1 winning, scaled by 'NNUE_OUTPUT_SCALE'.
+
+    The float model is trained with SGD on the logistic loss and quantised:
+    an activation of 1 is 127 and a hidden or output weight of 1 is 64, so
+    training keeps the weights inside the ranges the integers can hold.
+
+    Weights file (host byte order): the 'nnueFileHeader', then the feature
+    biases and weights (int16), the hidden weights (int8), the hidden biases
+    (int32), the output weights (int8) and the output bias (int32).
+*/
+
+#define NNUE_MAX_FEATURE_WEIGHT 28.0f  // Keeps the accumulator inside int16 (127 x 28 x 9 features < 32767)
+#define NNUE_MAX_LAYER_WEIGHT (127.0f / NNUE_WEIGHT_SCALE)  // Largest int8 hidden or output weight
+#define NNUE_MAX_BIAS 64.0f  // Largest hidden or output bias
+
+/**
+ * Header at the start of a weights file.
+ */
+typedef struct {
+    char magic[4];  // "NTCN"
+    uint32_t version;
+    uint32_t totalCells;
+    uint16_t hidden1, hidden2;  // Layer sizes, 'NNUE_HIDDEN1' and 'NNUE_HIDDEN2'
+} nnueFileHeader;
+
+/**
+ * Values of a forward pass of the float model, kept for the backward pass.
+ */
+typedef struct {
+    float hidden1[NNUE_HIDDEN1];  // First layer before the activation
+    float activations1[NNUE_HIDDEN1];
+    float hidden2[NNUE_HIDDEN2];  // Hidden layer before the activation
+    float activations2[NNUE_HIDDEN2];
+} modelPass;
+
+
+/**
+ * @brief Gets the feature of a pawn.
+ * @param totalCells Number of cells of the board
+ * @param player The player (0 - P1, 1 - P2)
+ * @param pawnIndex The pawn index
+ * @param slot The cell of the pawn, 'totalCells' if the pawn is WIN
+ * @return Returns the feature index
+ */
+static inline int featureIndex(int totalCells, int player, int pawnIndex, int slot) {
+    return (player * STANDARD_PAWNS + pawnIndex) * (totalCells + 1) + slot;
+}
+
+/**
+ * @brief Gets the slot of a pawn: its cell, or the number of cells if it is WIN.
+ * @param boardCells Board with all cells
+ * @param player The player (0 - P1, 1 - P2)
+ * @param pawnIndex The pawn index
+ * @return Returns the slot
+ */
+static inline int pawnSlot(const list *boardCells, int player, int pawnIndex) {
+    int cellIndex = boardCells->pawnCells[player][pawnIndex];
+
+    return boardCells->cells[cellIndex] & CASA_PAWN_WIN(player, pawnIndex) ? boardCells->length : cellIndex;
+}
+
+/**
+ * @brief Replaces a feature of the accumulator: subtracts the column of the old
+ * feature and adds the column of the new one.
+ * @param values The accumulator values
+ * @param removed Column of the old feature
+ * @param added Column of the new feature
+ */
+static inline void replaceColumn(int16_t *values, const int16_t *removed, const int16_t *added) {
+#if defined(__AVX2__)
+    for (int i = 0; i < NNUE_HIDDEN1; i += 16) {
+        __m256i value = _mm256_loadu_si256((const __m256i *) (values + i));
+
+        value = _mm256_sub_epi16(value, _mm256_loadu_si256((const __m256i *) (removed + i)));
+        value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i *) (added + i)));
+        _mm256_storeu_si256((__m256i *) (values + i), value);
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < NNUE_HIDDEN1; i += 8) {
+        __m128i value = _mm_loadu_si128((const __m128i *) (values + i));
+
+        value = _mm_sub_epi16(value, _mm_loadu_si128((const __m128i *) (removed + i)));
+        value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i *) (added + i)));
+        _mm_storeu_si128((__m128i *) (values + i), value);
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN1; i++) {
+        values[i] = (int16_t) (values[i] - removed[i] + added[i]);
+    }
+#endif
+}
+
+/**
+ * @brief Adds the column of a feature to the accumulator.
+ * @param values The accumulator values
+ * @param added Column of the feature
+ */
+static inline void addColumn(int16_t *values, const int16_t *added) {
+#if defined(__AVX2__)
+    for (int i = 0; i < NNUE_HIDDEN1; i += 16) {
+        __m256i value = _mm256_loadu_si256((const __m256i *) (values + i));
+
+        value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i *) (added + i)));
+        _mm256_storeu_si256((__m256i *) (values + i), value);
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < NNUE_HIDDEN1; i += 8) {
+        __m128i value = _mm_loadu_si128((const __m128i *) (values + i));
+
+        value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i *) (added + i)));
+        _mm_storeu_si128((__m128i *) (values + i), value);
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN1; i++) {
+        values[i] = (int16_t) (values[i] + added[i]);
+    }
+#endif
+}
+
+/**
+ * @brief Clipped ReLU of the accumulator: every value limited to 0..127.
+ * @param values The accumulator values
+ * @param activations Receives 'NNUE_HIDDEN1' activations
+ */
+static inline void clipAccumulator(const int16_t *values, int8_t *activations) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    // The pack saturates the values above 127
+    for (int i = 0; i < NNUE_HIDDEN1; i += 16) {
+        __m128i low = _mm_max_epi16(_mm_loadu_si128((const __m128i *) (values + i)), zero);
+        __m128i high = _mm_max_epi16(_mm_loadu_si128((const __m128i *) (values + i + 8)), zero);
+
+        _mm_storeu_si128((__m128i *) (activations + i), _mm_packs_epi16(low, high));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN1; i++) {
+        activations[i] = (int8_t) (values[i] < 0 ? 0 : values[i] > NNUE_ACTIVATION_SCALE ? NNUE_ACTIVATION_SCALE : values[i]);
+    }
+#endif
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Sums the four int32 values of a vector.
+ * @param vector The vector
+ * @return Returns the sum
+ */
+static inline int32_t sumInt32(__m128i vector) {
+    vector = _mm_add_epi32(vector, _mm_shuffle_epi32(vector, 0x4E));
+    vector = _mm_add_epi32(vector, _mm_shuffle_epi32(vector, 0xB1));
+    return _mm_cvtsi128_si32(vector);
+}
+#endif
+
+/**
+ * @brief Dot product of activations (0 to 127) and int8 weights.
+ * @param activations The activations
+ * @param weights The weights
+ * @param length Number of values, a multiple of 16
+ * @return Returns the dot product
+ */
+static inline int32_t dotInt8(const int8_t *activations, const int8_t *weights, int length) {
+    int32_t sum = 0;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // Unsigned activations times signed weights, pairs summed in int16 (at most 2 x 127 x 127) and then in int32
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i total = _mm256_setzero_si256();
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *) (activations + i)),
+                                                _mm256_loadu_si256((const __m256i *) (weights + i)));
+
+        total = _mm256_add_epi32(total, _mm256_madd_epi16(products, ones));
+    }
+    sum += sumInt32(_mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1)));
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i products = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *) (activations + i)),
+                                             _mm_loadu_si128((const __m128i *) (weights + i)));
+
+        sum += sumInt32(_mm_madd_epi16(products, _mm_set1_epi16(1)));
+    }
+#elif defined(__SSE2__)
+    // Activations zero extended and weights sign extended to int16, then multiplied and summed in pairs
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i activation = _mm_loadu_si128((const __m128i *) (activations + i));
+        __m128i weight = _mm_loadu_si128((const __m128i *) (weights + i));
+        __m128i weightLow = _mm_srai_epi16(_mm_unpacklo_epi8(weight, weight), 8);
+        __m128i weightHigh = _mm_srai_epi16(_mm_unpackhi_epi8(weight, weight), 8);
+
+        total = _mm_add_epi32(total, _mm_madd_epi16(_mm_unpacklo_epi8(activation, zero), weightLow));
+        total = _mm_add_epi32(total, _mm_madd_epi16(_mm_unpackhi_epi8(activation, zero), weightHigh));
+    }
+    sum += sumInt32(total);
+#endif
+
+    for (; i < length; i++) {
+        sum += activations[i] * weights[i];
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Allocates a network for a board with every weight at 0.
+ * @param network Receives the network
+ * @param totalCells Number of cells of the board
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int nnueNetworkInit(nnueNetwork *network, int totalCells) {
+    memset(network, 0, sizeof(nnueNetwork));
+    if (totalCells <= 0 || totalCells > MAX_CELLS) {
+        return 1;
+    }
+
+    network->totalCells = totalCells;
+    network->totalFeatures = 2 * STANDARD_PAWNS * (totalCells + 1);
+    network->featureWeights = calloc((size_t) network->totalFeatures * NNUE_HIDDEN1, sizeof(int16_t));
+
+    return network->featureWeights == NULL;
+}
+
+/**
+ * @brief Frees a network.
+ * @param network The network
+ */
+void nnueNetworkFree(nnueNetwork *network) {
+    free(network->featureWeights);
+    network->featureWeights = NULL;
+}
+
+/**
+ * @brief Checks that the integer arithmetic of a loaded network can not
+ * overflow: the accumulator of any position fits in int16 and the hidden and
+ * output biases are inside the range training gives them.
+ * @param network The network
+ * @return Returns whether the weights are in range
+ */
+static bool validWeights(const nnueNetwork *network) {
+    int32_t maxBias = (int32_t) (NNUE_MAX_BIAS * NNUE_OUTPUT_SCALE);
+
+    // Every accumulator value, its bias plus one column per active feature, must fit in int16
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        int32_t maxWeight = 0;
+
+        for (int feature = 0; feature < network->totalFeatures; feature++) {
+            int32_t weight = network->featureWeights[feature * NNUE_HIDDEN1 + unit];
+
+            maxWeight = abs(weight) > maxWeight ? abs(weight) : maxWeight;
+        }
+
+        if (abs(network->featureBias[unit]) + NNUE_MAX_ACTIVE * maxWeight > INT16_MAX) {
+            return false;
+        }
+    }
+
+    // The hidden and output sums stay far from the int32 limits
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        if (network->hiddenBias[unit] < -maxBias || network->hiddenBias[unit] > maxBias) {
+            return false;
+        }
+    }
+
+    return network->outputBias >= -maxBias && network->outputBias <= maxBias;
+}
+
+/**
+ * @brief Reads a network from a weights file.
+ * @param fileName The name of the weights file
+ * @param network Receives the network, it must be freed with 'nnueNetworkFree'
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (the file can not be read or is not a valid weights file)
+ */
+int nnueLoad(const char *fileName, nnueNetwork *network) {
+    FILE *fp = fopen(fileName, "rb");
+    nnueFileHeader header;
+    bool failed;
+
+    memset(network, 0, sizeof(nnueNetwork));
+    if (fp == NULL) {
+        return 1;
+    }
+
+    failed = fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, "NTCN", 4) != 0 ||
+             header.version != NNUE_VERSION || header.hidden1 != NNUE_HIDDEN1 || header.hidden2 != NNUE_HIDDEN2 ||
+             header.totalCells > MAX_CELLS || nnueNetworkInit(network, (int) header.totalCells) == 1;
+
+    failed = failed ||
+             fread(network->featureBias, sizeof(network->featureBias), 1, fp) != 1 ||
+             fread(network->featureWeights, sizeof(int16_t) * NNUE_HIDDEN1, network->totalFeatures, fp) != (size_t) network->totalFeatures ||
+             fread(network->hiddenWeights, sizeof(network->hiddenWeights), 1, fp) != 1 ||
+             fread(network->hiddenBias, sizeof(network->hiddenBias), 1, fp) != 1 ||
+             fread(network->outputWeights, sizeof(network->outputWeights), 1, fp) != 1 ||
+             fread(&network->outputBias, sizeof(network->outputBias), 1, fp) != 1 ||
+             fgetc(fp) != EOF || !validWeights(network);
+    fclose(fp);
+
+    if (failed) {
+        nnueNetworkFree(network);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes a network to a weights file, replacing it only once it is complete.
+ * @param fileName The name of the weights file
+ * @param network The network
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int nnueSave(const char *fileName, const nnueNetwork *network) {
+    nnueFileHeader header = {{'N', 'T', 'C', 'N'}, NNUE_VERSION, (uint32_t) network->totalCells, NNUE_HIDDEN1, NNUE_HIDDEN2};
+    char tempName[FILENAME_MAX];
+    FILE *fp;
+    bool failed;
+
+    if (snprintf(tempName, sizeof(tempName), "%s.tmp", fileName) >= (int) sizeof(tempName)) {
+        return 1;
+    }
+
+    fp = fopen(tempName, "wb");
+    if (fp == NULL) {
+        return 1;
+    }
+
+    failed = fwrite(&header, sizeof(header), 1, fp) != 1 ||
+             fwrite(network->featureBias, sizeof(network->featureBias), 1, fp) != 1 ||
+             fwrite(network->featureWeights, sizeof(int16_t) * NNUE_HIDDEN1, network->totalFeatures, fp) != (size_t) network->totalFeatures ||
+             fwrite(network->hiddenWeights, sizeof(network->hiddenWeights), 1, fp) != 1 ||
+             fwrite(network->hiddenBias, sizeof(network->hiddenBias), 1, fp) != 1 ||
+             fwrite(network->outputWeights, sizeof(network->outputWeights), 1, fp) != 1 ||
+             fwrite(&network->outputBias, sizeof(network->outputBias), 1, fp) != 1;
+
+    if (fclose(fp) != 0) {
+        failed = true;
+    }
+
+    if (failed || rename(tempName, fileName) != 0) {
+        remove(tempName);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Gets the active features of a position, one per pawn.
+ * @param boardCells Board with all cells (standard game)
+ * @param features Receives 'NNUE_MAX_ACTIVE' feature indexes
+ * @return Returns the number of active features
+ */
+int nnueFeatures(const list *boardCells, int *features) {
+    int totalActive = 0;
+
+    assert(boardCells->pawns == STANDARD_PAWNS);
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIndex = 0; pawnIndex < STANDARD_PAWNS; pawnIndex++) {
+            features[totalActive++] = featureIndex(boardCells->length, player, pawnIndex, pawnSlot(boardCells, player, pawnIndex));
+        }
+    }
+
+    return totalActive;
+}
+
+/**
+ * @brief Computes the accumulator of a position from all its features.
+ * @param network The network (of a board with the same cells)
+ * @param boardCells Board with all cells
+ * @param accumulator Receives the accumulator
+ */
+void nnueRefresh(const nnueNetwork *network, const list *boardCells, nnueAccumulator *accumulator) {
+    int features[NNUE_MAX_ACTIVE];
+    int totalActive = nnueFeatures(boardCells, features);
+
+    assert(network->totalCells == boardCells->length);
+
+    memcpy(accumulator->values, network->featureBias, sizeof(accumulator->values));
+    for (int i = 0; i < totalActive; i++) {
+        addColumn(accumulator->values, network->featureWeights + (size_t) features[i] * NNUE_HIDDEN1);
+    }
+}
+
+/**
+ * @brief Makes a play (see 'makePlay') and updates the accumulator with the
+ * features that changed. Only the moved pawn and the captured adversary pawns
+ * change: the moved pawn is the only one that can become WIN, and a captured
+ * pawn was on a cell (a WIN pawn can not be captured).
+ * @param network The network (of a board with the same cells)
+ * @param accumulator Accumulator of the position before the play, updated to the position after it
+ * @param boardCells Board with all cells
+ * @param pawn The pawn to play
+ * @param amount The dices value
+ * @return Returns the number of adversary pawns captured
+ */
+int nnuePlay(const nnueNetwork *network, nnueAccumulator *accumulator, list *boardCells, char pawn, int amount) {
+    int player = getPawnPlayer(pawn);
+    int adversary = 1 - player;
+    int pawnIndex = getPawnIndex(pawn);
+    int adversaryCells[STANDARD_PAWNS];
+    int before, after, captures;
+
+    if (pawnIndex < 0) {
+        return makePlay(boardCells, pawn, amount);
+    }
+
+    before = pawnSlot(boardCells, player, pawnIndex);
+    memcpy(adversaryCells, boardCells->pawnCells[adversary], sizeof(adversaryCells));
+
+    captures = makePlay(boardCells, pawn, amount);
+
+    after = pawnSlot(boardCells, player, pawnIndex);
+    if (after != before) {
+        replaceColumn(accumulator->values,
+                      network->featureWeights + (size_t) featureIndex(network->totalCells, player, pawnIndex, before) * NNUE_HIDDEN1,
+                      network->featureWeights + (size_t) featureIndex(network->totalCells, player, pawnIndex, after) * NNUE_HIDDEN1);
+    }
+
+    for (int captured = 0; captures > 0 && captured < STANDARD_PAWNS; captured++) {
+        if (boardCells->pawnCells[adversary][captured] != adversaryCells[captured]) {
+            replaceColumn(accumulator->values,
+                          network->featureWeights + (size_t) featureIndex(network->totalCells, adversary, captured, adversaryCells[captured]) * NNUE_HIDDEN1,
+                          network->featureWeights + (size_t) featureIndex(network->totalCells, adversary, captured, boardCells->pawnCells[adversary][captured]) * NNUE_HIDDEN1);
+        }
+    }
+
+    return captures;
+}
+
+/**
+ * @brief Computes the output of the network from an accumulator.
+ * @param network The network
+ * @param accumulator The accumulator of the position
+ * @return Returns the logit of P1 winning times 'NNUE_OUTPUT_SCALE'
+ */
+int32_t nnueOutput(const nnueNetwork *network, const nnueAccumulator *accumulator) {
+    int8_t activations1[NNUE_HIDDEN1];
+    int8_t activations2[NNUE_HIDDEN2];
+
+    clipAccumulator(accumulator->values, activations1);
+
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        int32_t sum = network->hiddenBias[unit] + dotInt8(activations1, network->hiddenWeights[unit], NNUE_HIDDEN1);
+
+        // Back to the activation scale, clipped to 0..127
+        sum = sum <= 0 ? 0 : sum / NNUE_WEIGHT_SCALE;
+        activations2[unit] = (int8_t) (sum > NNUE_ACTIVATION_SCALE ? NNUE_ACTIVATION_SCALE : sum);
+    }
+
+    return network->outputBias + dotInt8(activations2, network->outputWeights, NNUE_HIDDEN2);
+}
+
+/**
+ * @brief Gets the probability of a player winning from an accumulator.
+ * @param network The network
+ * @param accumulator The accumulator of the position
+ * @param player The player (0 - P1, 1 - P2)
+ * @return Returns the probability
+ */
+double nnueValue(const nnueNetwork *network, const nnueAccumulator *accumulator, int player) {
+    double p1Wins = 1 / (1 + exp(-(double) nnueOutput(network, accumulator) / NNUE_OUTPUT_SCALE));
+
+    return player == 0 ? p1Wins : 1 - p1Wins;
+}
+
+/**
+ * @brief Loads a weight of the float model (Hogwild: no lock, the value can be slightly stale).
+ * @param weight The weight
+ * @return Returns the weight
+ */
+static inline float loadWeight(const _Atomic float *weight) {
+    return atomic_load_explicit((_Atomic float *) weight, memory_order_relaxed);
+}
+
+/**
+ * @brief Adds to a weight of the float model, keeping it inside a range
+ * (Hogwild: a concurrent update of the same weight can be lost).
+ * @param weight The weight
+ * @param delta The value added
+ * @param limit Largest absolute value of the weight
+ */
+static inline void addWeight(_Atomic float *weight, float delta, float limit) {
+    float value = loadWeight(weight) + delta;
+
+    atomic_store_explicit(weight, value > limit ? limit : value < -limit ? -limit : value, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets a uniform random value.
+ * @param rng The generator
+ * @param range Largest absolute value
+ * @return Returns a value between '-range' and 'range'
+ */
+static float uniform(rngState *rng, float range) {
+    return (float) ((rngNext(rng) / 4294967296.0 * 2 - 1) * range);
+}
+
+/**
+ * @brief Allocates a float model for a board with random weights. The biases
+ * start every activation near the middle of its range.
+ * @param model Receives the model
+ * @param totalCells Number of cells of the board
+ * @param rng Generator of the initial weights
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int nnueModelInit(nnueModel *model, int totalCells, rngState *rng) {
+    size_t totalWeights;
+
+    model->featureWeights = NULL;
+    if (totalCells <= 0 || totalCells > MAX_CELLS) {
+        return 1;
+    }
+
+    model->totalCells = totalCells;
+    model->totalFeatures = 2 * STANDARD_PAWNS * (totalCells + 1);
+    totalWeights = (size_t) model->totalFeatures * NNUE_HIDDEN1;
+    model->featureWeights = malloc(sizeof(_Atomic float) * totalWeights);
+    if (model->featureWeights == NULL) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < totalWeights; i++) {
+        atomic_init(&model->featureWeights[i], uniform(rng, 0.05f));
+    }
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        atomic_init(&model->featureBias[unit], 0.5f);
+    }
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        for (int input = 0; input < NNUE_HIDDEN1; input++) {
+            atomic_init(&model->hiddenWeights[unit][input], uniform(rng, 0.18f));
+        }
+        atomic_init(&model->hiddenBias[unit], 0.5f);
+        atomic_init(&model->outputWeights[unit], uniform(rng, 0.25f));
+    }
+    atomic_init(&model->outputBias, 0.0f);
+
+    return 0;
+}
+
+/**
+ * @brief Frees a float model.
+ * @param model The model
+ */
+void nnueModelFree(nnueModel *model) {
+    free(model->featureWeights);
+    model->featureWeights = NULL;
+}
+
+/**
+ * @brief Forward pass of the float model.
+ * @param model The model
+ * @param features The active features
+ * @param totalActive Number of active features
+ * @param pass Receives the values of the layers
+ * @return Returns the probability of P1 winning
+ */
+static double modelForward(const nnueModel *model, const int *features, int totalActive, modelPass *pass) {
+    double output = loadWeight(&model->outputBias);
+
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        pass->hidden1[unit] = loadWeight(&model->featureBias[unit]);
+    }
+    for (int i = 0; i < totalActive; i++) {
+        const _Atomic float *column = model->featureWeights + (size_t) features[i] * NNUE_HIDDEN1;
+
+        for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+            pass->hidden1[unit] += loadWeight(&column[unit]);
+        }
+    }
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        pass->activations1[unit] = pass->hidden1[unit] < 0 ? 0 : pass->hidden1[unit] > 1 ? 1 : pass->hidden1[unit];
+    }
+
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        float sum = loadWeight(&model->hiddenBias[unit]);
+
+        for (int input = 0; input < NNUE_HIDDEN1; input++) {
+            sum += loadWeight(&model->hiddenWeights[unit][input]) * pass->activations1[input];
+        }
+        pass->hidden2[unit] = sum;
+        pass->activations2[unit] = sum < 0 ? 0 : sum > 1 ? 1 : sum;
+        output += loadWeight(&model->outputWeights[unit]) * pass->activations2[unit];
+    }
+
+    return 1 / (1 + exp(-output));
+}
+
+/**
+ * @brief Gets the probability of P1 winning given by the float model.
+ * @param model The model
+ * @param features The active features (see 'nnueFeatures')
+ * @param totalActive Number of active features
+ * @return Returns the probability
+ */
+double nnueModelValue(const nnueModel *model, const int *features, int totalActive) {
+    modelPass pass;
+
+    return modelForward(model, features, totalActive, &pass);
+}
+
+/**
+ * @brief Trains the float model on a position: one SGD step on the logistic loss.
+ * @param model The model
+ * @param features The active features (see 'nnueFeatures')
+ * @param totalActive Number of active features
+ * @param target 1 if P1 won the game of the position, 0 if P2 won
+ * @param rate The learning rate
+ * @return Returns the probability of P1 winning before the step
+ */
+double nnueModelTrain(nnueModel *model, const int *features, int totalActive, double target, double rate) {
+    modelPass pass;
+    double p1Wins = modelForward(model, features, totalActive, &pass);
+    float outputGradient = (float) (p1Wins - target);
+    float step = (float) rate;
+    float hiddenGradient[NNUE_HIDDEN2];
+    float featureGradient[NNUE_HIDDEN1] = {0};
+
+    // Output layer, the clipped units pass no gradient back
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        bool active = pass.hidden2[unit] > 0 && pass.hidden2[unit] < 1;
+
+        hiddenGradient[unit] = active ? outputGradient * loadWeight(&model->outputWeights[unit]) : 0;
+        addWeight(&model->outputWeights[unit], -step * outputGradient * pass.activations2[unit], NNUE_MAX_LAYER_WEIGHT);
+    }
+    addWeight(&model->outputBias, -step * outputGradient, NNUE_MAX_BIAS);
+
+    // Hidden layer
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        if (hiddenGradient[unit] == 0) {
+            continue;
+        }
+
+        for (int input = 0; input < NNUE_HIDDEN1; input++) {
+            featureGradient[input] += hiddenGradient[unit] * loadWeight(&model->hiddenWeights[unit][input]);
+            addWeight(&model->hiddenWeights[unit][input], -step * hiddenGradient[unit] * pass.activations1[input], NNUE_MAX_LAYER_WEIGHT);
+        }
+        addWeight(&model->hiddenBias[unit], -step * hiddenGradient[unit], NNUE_MAX_BIAS);
+    }
+
+    // First layer: only the columns of the active features
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        if (pass.hidden1[unit] <= 0 || pass.hidden1[unit] >= 1) {
+            featureGradient[unit] = 0;
+        }
+        addWeight(&model->featureBias[unit], -step * featureGradient[unit], NNUE_MAX_FEATURE_WEIGHT);
+    }
+    for (int i = 0; i < totalActive; i++) {
+        _Atomic float *column = model->featureWeights + (size_t) features[i] * NNUE_HIDDEN1;
+
+        for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+            if (featureGradient[unit] != 0) {
+                addWeight(&column[unit], -step * featureGradient[unit], NNUE_MAX_FEATURE_WEIGHT);
+            }
+        }
+    }
+
+    return p1Wins;
+}
+
+/**
+ * @brief Rounds a float weight to an integer of a given scale.
+ * @param weight The weight
+ * @param scale Integer value of a weight of 1
+ * @param limit Largest absolute integer value
+ * @return Returns the integer weight
+ */
+static long quantise(float weight, long scale, long limit) {
+    long value = lroundf(weight * (float) scale);
+
+    return value > limit ? limit : value < -limit ? -limit : value;
+}
+
+/**
+ * @brief Quantises the float model into a network of the same board.
+ * @param model The model
+ * @param network The network, allocated by 'nnueNetworkInit' for the same cells
+ */
+void nnueQuantize(const nnueModel *model, nnueNetwork *network) {
+    assert(network->totalFeatures == model->totalFeatures);
+
+    for (size_t i = 0; i < (size_t) model->totalFeatures * NNUE_HIDDEN1; i++) {
+        network->featureWeights[i] = (int16_t) quantise(loadWeight(&model->featureWeights[i]), NNUE_ACTIVATION_SCALE, INT16_MAX);
+    }
+    for (int unit = 0; unit < NNUE_HIDDEN1; unit++) {
+        network->featureBias[unit] = (int16_t) quantise(loadWeight(&model->featureBias[unit]), NNUE_ACTIVATION_SCALE, INT16_MAX);
+    }
+    for (int unit = 0; unit < NNUE_HIDDEN2; unit++) {
+        for (int input = 0; input < NNUE_HIDDEN1; input++) {
+            network->hiddenWeights[unit][input] = (int8_t) quantise(loadWeight(&model->hiddenWeights[unit][input]), NNUE_WEIGHT_SCALE, INT8_MAX);
+        }
+        network->hiddenBias[unit] = (int32_t) quantise(loadWeight(&model->hiddenBias[unit]), NNUE_OUTPUT_SCALE, INT32_MAX);
+        network->outputWeights[unit] = (int8_t) quantise(loadWeight(&model->outputWeights[unit]), NNUE_WEIGHT_SCALE, INT8_MAX);
+    }
+    network->outputBias = (int32_t) quantise(loadWeight(&model->outputBias), NNUE_OUTPUT_SCALE, INT32_MAX);
+}
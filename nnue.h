@@ -0,0 +1,72 @@
+#ifndef __nnue_h__
+#define __nnue_h__
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "board.h"
+#include "rng.h"
+
+#define NNUE_VERSION 1  // Weights file format version
+#define NNUE_HIDDEN1 32  // Outputs of the feature transformer (the accumulator)
+#define NNUE_HIDDEN2 16  // Outputs of the hidden layer
+#define NNUE_ACTIVATION_SCALE 127  // Quantised value of an activation of 1
+#define NNUE_WEIGHT_SCALE 64  // Quantised value of a hidden or output weight of 1
+#define NNUE_OUTPUT_SCALE (NNUE_ACTIVATION_SCALE * NNUE_WEIGHT_SCALE)  // Quantised value of an output of 1
+#define NNUE_MAX_ACTIVE (2 * STANDARD_PAWNS)  // Active features of a position, one per pawn
+
+/**
+ * Quantised network. The input is one-hot per pawn: feature (player, pawn,
+ * cell), the cell being the number of cells for a WIN pawn. Its first layer
+ * is a column of 'NNUE_HIDDEN1' int16 weights per feature, summed into an
+ * accumulator; the hidden and output layers have int8 weights.
+ */
+typedef struct {
+    int totalCells;  // Cells of the board the network was trained on
+    int totalFeatures;  // 2 players x 'STANDARD_PAWNS' x (cells + 1)
+    int16_t *featureWeights;  // 'NNUE_HIDDEN1' weights per feature
+    int16_t featureBias[NNUE_HIDDEN1];
+    int8_t hiddenWeights[NNUE_HIDDEN2][NNUE_HIDDEN1];
+    int32_t hiddenBias[NNUE_HIDDEN2];
+    int8_t outputWeights[NNUE_HIDDEN2];
+    int32_t outputBias;
+} nnueNetwork;
+
+/**
+ * First layer of a position before the activation: the feature bias plus the
+ * columns of its active features. Kept up to date by 'nnuePlay'.
+ */
+typedef struct {
+    int16_t values[NNUE_HIDDEN1];
+} nnueAccumulator;
+
+/**
+ * Network with float weights, trained by 'nnueModelTrain'. Training threads
+ * read and update it without locks (Hogwild), like 'tdWeights'.
+ */
+typedef struct {
+    int totalCells;
+    int totalFeatures;
+    _Atomic float *featureWeights;  // 'NNUE_HIDDEN1' weights per feature
+    _Atomic float featureBias[NNUE_HIDDEN1];
+    _Atomic float hiddenWeights[NNUE_HIDDEN2][NNUE_HIDDEN1];
+    _Atomic float hiddenBias[NNUE_HIDDEN2];
+    _Atomic float outputWeights[NNUE_HIDDEN2];
+    _Atomic float outputBias;
+} nnueModel;
+
+int nnueNetworkInit(nnueNetwork *network, int totalCells);
+void nnueNetworkFree(nnueNetwork *network);
+int nnueLoad(const char *fileName, nnueNetwork *network);
+int nnueSave(const char *fileName, const nnueNetwork *network);
+int nnueFeatures(const list *boardCells, int *features);
+void nnueRefresh(const nnueNetwork *network, const list *boardCells, nnueAccumulator *accumulator);
+int nnuePlay(const nnueNetwork *network, nnueAccumulator *accumulator, list *boardCells, char pawn, int amount);
+int32_t nnueOutput(const nnueNetwork *network, const nnueAccumulator *accumulator);
+double nnueValue(const nnueNetwork *network, const nnueAccumulator *accumulator, int player);
+int nnueModelInit(nnueModel *model, int totalCells, rngState *rng);
+void nnueModelFree(nnueModel *model);
+double nnueModelValue(const nnueModel *model, const int *features, int totalActive);
+double nnueModelTrain(nnueModel *model, const int *features, int totalActive, double target, double rate);
+void nnueQuantize(const nnueModel *model, nnueNetwork *network);
+
+#endif
@@ -0,0 +1,323 @@
+#include <stdlib.h>
+#include <string.h>
+#include "policy.h"
+#include "search.h"
+#include "evaluate.h"
+#include "td.h"
+#include "nnue.h"
+#include "simulate.h"
+#include "engine.h"
+#include "board.h"
+
+/*
+    Pawn choice policies. Every policy only looks at the board, the player to
+    move and the dices value, and tries its candidate plays on the context
+    scratch board with the real 'makePlay', so they all follow the game rules.
+*/
+
+/**
+ * Policy registered by name.
+ */
+typedef struct {
+    const char *name;
+    policyFunction choose;
+} policyEntry;
+
+static const policyEntry POLICIES[] = {
+    {"random", randomPolicy},
+    {"forward", forwardPolicy},
+    {"capture", capturePolicy},
+    {"safest", safestPolicy},
+    {"search", searchPolicy},
+    {"eval", evalPolicy},
+    {"td", tdPolicy},
+    {"nnue", nnuePolicy},
+};
+
+
+/**
+ * @brief Initializes the per thread state of the policies.
+ * @param context The context
+ * @param boardCells Board the policies will play on (the scratch board has its size)
+ * @param seed Seed of the random choices
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int policyContextInit(policyContext *context, const list *boardCells, uint64_t seed) {
+    rngSeed(&context->rng, seed);
+    return boardClone(&context->scratch, boardCells);
+}
+
+/**
+ * @brief Frees the per thread state of the policies.
+ * @param context The context
+ */
+void policyContextFree(policyContext *context) {
+    freeBoardCells(&context->scratch);
+}
+
+/**
+ * @brief Finds a policy by name.
+ * @param name The policy name ("random", "forward", "capture", "safest", "search", "eval", "td" or "nnue")
+ * @return Returns the policy, NULL if there is no policy with the name
+ */
+policyFunction findPolicy(const char *name) {
+    for (size_t i = 0; i < sizeof(POLICIES) / sizeof(POLICIES[0]); i++) {
+        if (strcmp(POLICIES[i].name, name) == 0) {
+            return POLICIES[i].choose;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Gets the probability of a sum of two dices.
+ * @param sum The sum
+ * @return Returns the probability, 0 if the sum is not between 2 and 12
+ */
+double diceSumProbability(int sum) {
+    if (sum < 2 || sum > MAX_DICES_VALUE) {
+        return 0;
+    }
+
+    return (6 - abs(sum - 7)) / 36.0;
+}
+
+/**
+ * @brief Gets the number of cells a pawn has walked from its home cell.
+ * @param boardCells Board with all cells
+ * @param player The player (0 - P1, 1 - P2)
+ * @param pawnIndex The pawn index (0 to 3)
+ * @return Returns the progress, the number of cells of the board if the pawn is WIN
+ */
+int pawnProgress(const list *boardCells, int player, int pawnIndex) {
+    int cellIndex = boardCells->pawnCells[player][pawnIndex];
+    int home = player == 0 ? 0 : boardCells->length / 2;
+
+    if (casaPawnState(boardCells->cells[cellIndex], player, pawnIndex) == WIN) {
+        return boardCells->length;
+    }
+
+    return (cellIndex - home + boardCells->length) % boardCells->length;
+}
+
+/**
+ * @brief Gets how exposed a pawn is to the next adversary play: the sum, over
+ * the adversary pawns that can reach it, of the probability of a dices value
+ * that takes them to or past the pawn.
+ * @param boardCells Board with all cells
+ * @param player The player (0 - P1, 1 - P2)
+ * @param pawnIndex The pawn index (0 to 3)
+ * @return Returns the exposure, 0 if the pawn is WIN or on a safe cell
+ */
+double pawnExposure(const list *boardCells, int player, int pawnIndex) {
+    int cellIndex = boardCells->pawnCells[player][pawnIndex];
+    int adversary = 1 - player;
+    double exposure = 0;
+
+    if (casaIsSafe(boardCells->cells[cellIndex]) || pawnProgress(boardCells, player, pawnIndex) == boardCells->length) {
+        return 0;
+    }
+
+    for (int adversaryPawn = 0; adversaryPawn < boardCells->pawns; adversaryPawn++) {
+        int progress = pawnProgress(boardCells, adversary, adversaryPawn);
+        int distance = (cellIndex - boardCells->pawnCells[adversary][adversaryPawn] + boardCells->length) % boardCells->length;
+
+        // The adversary pawn walks through the cell with any dices value of at least 'distance'
+        if (distance >= 1 && distance <= MAX_DICES_VALUE && progress + distance < boardCells->length) {
+            for (int sum = distance; sum <= MAX_DICES_VALUE; sum++) {
+                exposure += diceSumProbability(sum);
+            }
+        }
+    }
+
+    return exposure;
+}
+
+/**
+ * @brief Gets the movable pawns of a player.
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1
+ * @param pawns Receives the movable pawns ('MAX_PAWNS' positions)
+ * @return Returns the number of movable pawns
+ */
+static int movablePawns(list *boardCells, bool player1, char *pawns) {
+    const char *symbols = player1 ? SYMBOLS_J1 : SYMBOLS_J2;
+    int totalMovable = 0;
+
+    for (int i = 1; i <= boardCells->pawns; i++) {
+        if (isPawnMovable(symbols[i], boardCells, player1)) {
+            pawns[totalMovable++] = symbols[i];
+        }
+    }
+
+    return totalMovable;
+}
+
+/**
+ * @brief Picks the pawn with the highest score, at random among the tied ones.
+ * @param pawns The candidate pawns
+ * @param scores The score of each candidate
+ * @param totalPawns Number of candidates
+ * @param rng Generator used to break ties
+ * @return Returns the chosen pawn or '\0' if there are no candidates
+ */
+static char pickBest(const char *pawns, const double *scores, int totalPawns, rngState *rng) {
+    double bestScore = 0;
+    char best = '\0';
+    int ties = 0;
+
+    for (int i = 0; i < totalPawns; i++) {
+        if (i == 0 || scores[i] > bestScore) {
+            bestScore = scores[i];
+        }
+    }
+
+    // Reservoir sampling over the tied candidates
+    for (int i = 0; i < totalPawns; i++) {
+        if (scores[i] == bestScore && rngRange(rng, ++ties) == 0) {
+            best = pawns[i];
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Random policy: any movable pawn.
+ */
+char randomPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    (void) dicesValue;
+    (void) settings;
+    return chooseRandomPawn(boardCells, player1, &context->rng);
+}
+
+/**
+ * @brief Furthest forward policy: the movable pawn that has walked the most cells.
+ */
+char forwardPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    char pawns[MAX_PAWNS];
+    double scores[MAX_PAWNS];
+    int totalPawns = movablePawns(boardCells, player1, pawns);
+
+    (void) dicesValue;
+    (void) settings;
+    for (int i = 0; i < totalPawns; i++) {
+        scores[i] = pawnProgress(boardCells, player1 ? 0 : 1, getPawnIndex(pawns[i]));
+    }
+
+    return pickBest(pawns, scores, totalPawns, &context->rng);
+}
+
+/**
+ * @brief Capture first policy: the pawn whose play captures the most adversary pawns.
+ */
+char capturePolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    char pawns[MAX_PAWNS];
+    double scores[MAX_PAWNS];
+    int totalPawns = movablePawns(boardCells, player1, pawns);
+
+    (void) settings;
+    for (int i = 0; i < totalPawns; i++) {
+        boardCopy(&context->scratch, boardCells);
+        scores[i] = makePlay(&context->scratch, pawns[i], dicesValue);
+    }
+
+    return pickBest(pawns, scores, totalPawns, &context->rng);
+}
+
+/**
+ * @brief Safest policy: the play that leaves the player pawns the least exposed (see 'pawnExposure').
+ */
+char safestPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    int player = player1 ? 0 : 1;
+    char pawns[MAX_PAWNS];
+    double scores[MAX_PAWNS];
+    int totalPawns = movablePawns(boardCells, player1, pawns);
+
+    (void) settings;
+    for (int i = 0; i < totalPawns; i++) {
+        boardCopy(&context->scratch, boardCells);
+        makePlay(&context->scratch, pawns[i], dicesValue);
+
+        scores[i] = 0;
+        for (int pawnIndex = 0; pawnIndex < boardCells->pawns; pawnIndex++) {
+            scores[i] -= pawnExposure(&context->scratch, player, pawnIndex);
+        }
+    }
+
+    return pickBest(pawns, scores, totalPawns, &context->rng);
+}
+
+/**
+ * @brief Search policy: the opening book pawn or the Monte Carlo search pawn
+ * (see 'chooseSearchPawn'). The settings are a 'searchSettings'.
+ */
+char searchPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    const searchSettings *search = settings;
+
+    return chooseSearchPawn(search->book, boardCells, player1, dicesValue, search->rollouts, &context->rng);
+}
+
+/**
+ * @brief Evaluation policy: the play that leads to the best position for the
+ * player (see 'evaluatePosition'). The settings are an 'evalWeights', the
+ * default weights are used if they are NULL.
+ */
+char evalPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    int player = player1 ? 0 : 1;
+    evalWeights defaultWeights;
+    const evalWeights *weights = settings;
+    char pawns[MAX_PAWNS];
+    double scores[MAX_PAWNS];
+    int totalPawns = movablePawns(boardCells, player1, pawns);
+
+    if (weights == NULL) {
+        evalDefaultWeights(&defaultWeights);
+        weights = &defaultWeights;
+    }
+
+    for (int i = 0; i < totalPawns; i++) {
+        boardCopy(&context->scratch, boardCells);
+        makePlay(&context->scratch, pawns[i], dicesValue);
+        scores[i] = evaluatePosition(&context->scratch, player, weights);
+    }
+
+    return pickBest(pawns, scores, totalPawns, &context->rng);
+}
+
+/**
+ * @brief Learned policy: the play that leads to the position with the highest
+ * learned value (see 'tdBestPawn'). The settings are a 'tdWeights'.
+ */
+char tdPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    return tdBestPawn(settings, boardCells, player1, dicesValue, &context->scratch, &context->rng);
+}
+
+/**
+ * @brief Network policy: the play that leads to the position with the highest
+ * network value. The accumulator of the position is computed once and each
+ * candidate play only updates a copy of it (see 'nnuePlay'). The settings are
+ * an 'nnueNetwork' of a board with the same cells.
+ */
+char nnuePolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings) {
+    const nnueNetwork *network = settings;
+    nnueAccumulator root, accumulator;
+    char pawns[MAX_PAWNS];
+    double scores[MAX_PAWNS];
+    int totalPawns = movablePawns(boardCells, player1, pawns);
+
+    if (totalPawns == 0) {
+        return '\0';
+    }
+
+    nnueRefresh(network, boardCells, &root);
+    for (int i = 0; i < totalPawns; i++) {
+        boardCopy(&context->scratch, boardCells);
+        accumulator = root;
+        nnuePlay(network, &accumulator, &context->scratch, pawns[i], dicesValue);
+        scores[i] = player1 ? nnueOutput(network, &accumulator) : -nnueOutput(network, &accumulator);
+    }
+
+    return pickBest(pawns, scores, totalPawns, &context->rng);
+}
@@ -0,0 +1,64 @@
+#ifndef __policy_h__
+#define __policy_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "book.h"
+#include "rng.h"
+
+#define POLICY_NAME_SIZE 32  // Max size of a policy name
+
+/**
+ * Per thread state of the policies: generator for random choices and a board
+ * of the same size where a policy can try plays before choosing.
+ */
+typedef struct {
+    rngState rng;
+    list scratch;
+} policyContext;
+
+/**
+ * Chooses the pawn to play.
+ * boardCells - Board with all cells (not changed)
+ * player1 - Whether it is player 1 to move
+ * dicesValue - The dices value
+ * context - Per thread state
+ * settings - Policy settings (can be NULL)
+ * Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+typedef char (*policyFunction)(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+
+/**
+ * A pawn choice strategy.
+ */
+typedef struct {
+    char name[POLICY_NAME_SIZE];
+    policyFunction choose;
+    const void *settings;
+} pawnPolicy;
+
+/**
+ * Settings of the search policy.
+ */
+typedef struct {
+    const openingBook *book;  // Opening book probed before searching (can be NULL)
+    int rollouts;  // Random games played for each movable pawn
+} searchSettings;
+
+int policyContextInit(policyContext *context, const list *boardCells, uint64_t seed);
+void policyContextFree(policyContext *context);
+policyFunction findPolicy(const char *name);
+double diceSumProbability(int sum);
+int pawnProgress(const list *boardCells, int player, int pawnIndex);
+double pawnExposure(const list *boardCells, int player, int pawnIndex);
+char randomPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char forwardPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char capturePolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char safestPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char searchPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char evalPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char tdPolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+char nnuePolicy(list *boardCells, bool player1, int dicesValue, policyContext *context, const void *settings);
+
+#endif
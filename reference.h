@@ -0,0 +1,52 @@
+#ifndef __reference_h__
+#define __reference_h__
+
+#include <stdbool.h>
+#include "board.h"
+#include "engine.h"
+
+/*
+    Reference engine: the original linked-list engine, kept frozen so the
+    optimised engine ('engine.c') can be checked against it. Only the game
+    rules fixed since then are applied here (captures skip safe cells), the
+    original captures are kept in 'refMakePlayOriginal'. Do not optimise
+    this file.
+*/
+
+/**
+ * Board cell of the reference engine.
+ */
+typedef struct {
+    state jogador_peao[2][4];  // State of each pawn of player 1 and 2 in the cell
+    state casaSegura;  // Whether the cell is a safe cell
+} refCasa;
+
+/**
+ * Node of the reference board list, holds a board cell.
+ */
+typedef struct _refNode {
+    refCasa item;
+    struct _refNode *next;
+} refNode;
+
+/**
+ * Reference board: linked list of cells.
+ */
+typedef struct {
+    refNode *head;
+    refNode *tail;
+    int length;
+} refList;
+
+void refInitializeCellsList(refList *boardCells);
+int refBoardSetup(refList *boardCells, const safeCellSet *safeCells, int totalCells);
+int refCheckGameWin(refList *boardCells, int totalCells);
+int refGetPawnNodeIndex(refList *boardCells, char pawn);
+void refMovePawn(refList *boardCells, char pawn, int pawnIndex, int srcIndex, int destIndex);
+void refResetAdversaryPawn(refList *boardCells, char pawn, int player, int pawnSrcIndex);
+int refMakePlay(refList *boardCells, char pawn, int amount);
+int refMakePlayOriginal(refList *boardCells, char pawn, int amount);
+bool refIsPawnMovable(char pawn, refList *boardCells, bool player1);
+void refFreeBoardCells(refList *boardCells);
+
+#endif
@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include "rng.h"
+
+
+/**
+ * @brief Seeds the generator. The seed is scrambled (splitmix64) so that
+ * close seeds (e.g. 1, 2, 3...) still produce unrelated sequences.
+ * @param rng The generator state
+ * @param seed The seed value
+ */
+void rngSeed(rngState *rng, uint64_t seed) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    // xorshift state can never be zero
+    rng->state = z != 0 ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * @brief Rolls the game dices.
+ * @param rng The generator state
+ * @param numberOfDices Number of dices to roll
+ * @return Returns the sum of all dices
+ */
+int rngRollDice(rngState *rng, int numberOfDices) {
+    int sum = 0;
+
+    for (int dice = 0; dice < numberOfDices; dice++) {
+        sum += rngRange(rng, DICE_FACES) + 1;
+    }
+
+    return sum;
+}
@@ -0,0 +1,46 @@
+#ifndef __rng_h__
+#define __rng_h__
+
+#include <stdint.h>
+
+#define DICE_FACES 6  // Number of faces of each dice
+
+/**
+ * Pseudo-random generator state. Kept in a plain struct (instead of the hidden
+ * 'rand()' state) so it can be saved, restored and owned by each game/thread.
+ */
+typedef struct {
+    uint64_t state;
+} rngState;
+
+void rngSeed(rngState *rng, uint64_t seed);
+int rngRollDice(rngState *rng, int numberOfDices);
+
+/**
+ * @brief Generates the next 32 bit pseudo-random value (xorshift64*).
+ * Inline so the simulation hot loops do not pay a call per value.
+ * @param rng The generator state
+ * @return Returns the generated value
+ */
+static inline uint32_t rngNext(rngState *rng) {
+    uint64_t x = rng->state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+
+    return (uint32_t) ((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Generates a pseudo-random value between 0 (inclusive) and 'range' (exclusive).
+ * @param rng The generator state
+ * @param range The number of possible values
+ * @return Returns the generated value
+ */
+static inline int rngRange(rngState *rng, int range) {
+    return (int) (((uint64_t) rngNext(rng) * (uint64_t) range) >> 32);
+}
+
+#endif
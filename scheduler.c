@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "scheduler.h"
+#include "rng.h"
+
+/**
+ * State shared by all the workers of a 'runWorkStealing' call.
+ */
+typedef struct {
+    workDeque *deques;  // One deque per worker
+    int workers;  // Number of workers
+    _Atomic long remaining;  // Number of tasks not finished yet
+    taskRunner runTask;  // Function that runs each task
+    void *arg;  // User argument given to 'runTask'
+} schedulerShared;
+
+/**
+ * State of a single worker thread.
+ */
+typedef struct {
+    schedulerShared *shared;
+    int index;  // Worker index, also the index of its own deque
+    pthread_t thread;
+} workerContext;
+
+
+/**
+ * @brief Initializes an empty deque.
+ * @param deque The deque
+ * @param capacity Max number of tasks the deque can hold
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int dequeInit(workDeque *deque, long capacity) {
+    deque->tasks = malloc(sizeof(*deque->tasks) * (capacity > 0 ? capacity : 1));
+    if (deque->tasks == NULL) {
+        return 1;
+    }
+
+    deque->capacity = capacity > 0 ? capacity : 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    return 0;
+}
+
+/**
+ * @brief Frees the deque buffer.
+ * @param deque The deque
+ */
+void dequeFree(workDeque *deque) {
+    free((void *) deque->tasks);
+    deque->tasks = NULL;
+}
+
+/**
+ * @brief Pushes a task at the bottom of the deque. Must only be called by the owner.
+ * @param deque The deque
+ * @param task The task id
+ * @return Returns 0 on 'SUCCESS' and 1 if the deque is full
+ */
+int dequePush(workDeque *deque, long task) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if (bottom - top >= deque->capacity) {
+        return 1;
+    }
+
+    atomic_store_explicit(&deque->tasks[bottom % deque->capacity], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * @brief Pops the newest task from the bottom of the deque. Must only be called by the owner.
+ * @param deque The deque
+ * @param task Receives the task id
+ * @return Returns 0 on 'SUCCESS' and 1 if the deque is empty (or the last task was stolen)
+ */
+int dequePop(workDeque *deque, long *task) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    long top;
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {  // Deque was already empty
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return 1;
+    }
+
+    *task = atomic_load_explicit(&deque->tasks[bottom % deque->capacity], memory_order_relaxed);
+    if (top == bottom) {  // Last task, races against thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return !won;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Steals the oldest task from the top of the deque. Can be called by any thread.
+ * @param deque The deque
+ * @param task Receives the task id
+ * @return Returns 0 on 'SUCCESS' and 1 if the deque is empty or another thread won the race
+ */
+int dequeSteal(workDeque *deque, long *task) {
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    long bottom;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return 1;
+    }
+
+    *task = atomic_load_explicit(&deque->tasks[top % deque->capacity], memory_order_relaxed);
+    return !atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed);
+}
+
+/**
+ * @brief Worker loop: runs tasks from its own deque and steals from the
+ * other workers once it runs out, until every task is finished.
+ * @param context The worker context
+ * @return Returns NULL
+ */
+static void *workerLoop(void *context) {
+    workerContext *worker = context;
+    schedulerShared *shared = worker->shared;
+    workDeque *ownDeque = &shared->deques[worker->index];
+    rngState rng;  // Used to pick the first victim to steal from
+    long task;
+
+    rngSeed(&rng, (uint64_t) worker->index);
+
+    while (atomic_load_explicit(&shared->remaining, memory_order_acquire) > 0) {
+        int gotTask = dequePop(ownDeque, &task) == 0;
+
+        // Tries every other worker, starting at a random one
+        if (!gotTask && shared->workers > 1) {
+            int firstVictim = rngRange(&rng, shared->workers);
+
+            for (int i = 0; i < shared->workers && !gotTask; i++) {
+                int victim = (firstVictim + i) % shared->workers;
+
+                if (victim != worker->index) {
+                    gotTask = dequeSteal(&shared->deques[victim], &task) == 0;
+                }
+            }
+        }
+
+        if (gotTask) {
+            shared->runTask(task, worker->index, shared->arg);
+            atomic_fetch_sub_explicit(&shared->remaining, 1, memory_order_release);
+        } else {
+            // Remaining tasks are being run by other workers
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Runs the tasks '0' to 'totalTasks - 1' over several worker threads.
+ * Tasks are split in contiguous blocks, one per worker, and idle workers steal
+ * tasks from the others so uneven task lengths do not leave cores idle.
+ * The calling thread is used as worker 0.
+ * @param workers Number of worker threads (between 1 and 'MAX_WORKERS')
+ * @param totalTasks Number of tasks to run
+ * @param runTask Function that runs each task
+ * @param arg User argument given to 'runTask'
+ * @return Returns 0 on 'SUCCESS' (every task was run, even if some threads could not be started)
+ * and 1 on 'FAILURE' (invalid number of workers or no memory, no task was run)
+ */
+int runWorkStealing(int workers, long totalTasks, taskRunner runTask, void *arg) {
+    schedulerShared shared;
+    workerContext *contexts;
+    int startedWorkers = 1;  // Worker 0 is the calling thread
+
+    if (workers < 1 || workers > MAX_WORKERS) {
+        return 1;
+    }
+
+    shared.deques = malloc(sizeof(workDeque) * workers);
+    contexts = malloc(sizeof(workerContext) * workers);
+    if (shared.deques == NULL || contexts == NULL) {
+        free(shared.deques);
+        free(contexts);
+        return 1;
+    }
+
+    shared.workers = workers;
+    shared.runTask = runTask;
+    shared.arg = arg;
+    atomic_init(&shared.remaining, totalTasks);
+
+    // Splits the tasks in contiguous blocks, one per worker
+    for (int w = 0; w < workers; w++) {
+        long firstTask = totalTasks * w / workers;
+        long lastTask = totalTasks * (w + 1) / workers;
+
+        if (dequeInit(&shared.deques[w], lastTask - firstTask) == 1) {
+            for (int i = 0; i < w; i++) {
+                dequeFree(&shared.deques[i]);
+            }
+            free(shared.deques);
+            free(contexts);
+            return 1;
+        }
+
+        // Pushed backwards so the owner pops its block in order
+        for (long task = lastTask - 1; task >= firstTask; task--) {
+            dequePush(&shared.deques[w], task);
+        }
+
+        contexts[w].shared = &shared;
+        contexts[w].index = w;
+    }
+
+    for (int w = 1; w < workers; w++) {
+        if (pthread_create(&contexts[w].thread, NULL, workerLoop, &contexts[w]) != 0) {
+            // The workers already started (and worker 0) steal the other blocks, so every task is still run
+            break;
+        }
+        startedWorkers++;
+    }
+
+    workerLoop(&contexts[0]);
+
+    for (int w = 1; w < startedWorkers; w++) {
+        pthread_join(contexts[w].thread, NULL);
+    }
+
+    for (int w = 0; w < workers; w++) {
+        dequeFree(&shared.deques[w]);
+    }
+    free(shared.deques);
+    free(contexts);
+
+    return 0;
+}
+
+/**
+ * @brief Gets the number of online processor cores.
+ * @return Returns the number of cores (at least 1, at most 'MAX_WORKERS')
+ */
+int availableCores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cores < 1) {
+        return 1;
+    }
+
+    return cores > MAX_WORKERS ? MAX_WORKERS : (int) cores;
+}
+
+/**
+ * @brief Gets the current time in seconds, used by the tools to time their runs.
+ * @return Returns the time of a monotonic clock
+ */
+double now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
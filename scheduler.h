@@ -0,0 +1,36 @@
+#ifndef __scheduler_h__
+#define __scheduler_h__
+
+#include <stdatomic.h>
+
+#define MAX_WORKERS 256  // Defines the max number of worker threads
+
+/**
+ * Work-stealing deque (Chase-Lev) of task ids with a fixed capacity.
+ * The owner thread pushes and pops at the bottom, other threads steal from the top.
+ */
+typedef struct {
+    _Atomic long top;  // Index of the oldest task, where thieves steal from
+    _Atomic long bottom;  // Index after the newest task, where the owner pushes/pops
+    long capacity;  // Max number of tasks the deque can hold
+    _Atomic long *tasks;  // Circular buffer with the task ids
+} workDeque;
+
+/**
+ * Function that runs a single task.
+ * task - The task id
+ * worker - Index of the worker thread running the task
+ * arg - User argument given to 'runWorkStealing'
+ */
+typedef void (*taskRunner)(long task, int worker, void *arg);
+
+int dequeInit(workDeque *deque, long capacity);
+void dequeFree(workDeque *deque);
+int dequePush(workDeque *deque, long task);
+int dequePop(workDeque *deque, long *task);
+int dequeSteal(workDeque *deque, long *task);
+int runWorkStealing(int workers, long totalTasks, taskRunner runTask, void *arg);
+int availableCores(void);
+double now(void);
+
+#endif
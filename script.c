@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "script.h"
+
+
+/**
+ * @brief Reads a whole script file into memory with a single read.
+ * @param fileName The name of the script file
+ * @param commands Receives the script commands
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int loadScript(const char *fileName, script *commands) {
+    FILE *fp = fopen(fileName, "rb");
+    long fileSize;
+
+    commands->data = NULL;
+    commands->length = 0;
+    commands->position = 0;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    // Gets the file size to read it all at once
+    if (fseek(fp, 0, SEEK_END) != 0 || (fileSize = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return 1;
+    }
+
+    commands->data = malloc(fileSize > 0 ? fileSize : 1);
+    if (commands->data == NULL) {
+        fclose(fp);
+        return 1;
+    }
+
+    commands->length = (long) fread(commands->data, 1, fileSize, fp);
+    fclose(fp);
+
+    if (commands->length != fileSize) {
+        freeScript(commands);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Gets the next command of a script, skipping white space
+ * (same as reading the command with 'scanf(" %c")').
+ * @param commands The script commands
+ * @return Returns the next command, 'SCRIPT_END' if there are no commands left
+ */
+char nextScriptCommand(script *commands) {
+    while (commands->position < commands->length) {
+        char command = commands->data[commands->position++];
+
+        if (!isspace((unsigned char) command)) {
+            return command;
+        }
+    }
+
+    return SCRIPT_END;
+}
+
+/**
+ * @brief Frees the memory of a script.
+ * @param commands The script commands
+ */
+void freeScript(script *commands) {
+    free(commands->data);
+    commands->data = NULL;
+    commands->length = 0;
+    commands->position = 0;
+}
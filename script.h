@@ -0,0 +1,20 @@
+#ifndef __script_h__
+#define __script_h__
+
+#define SCRIPT_OUTPUT_BUFFER (1 << 20)  // Size in bytes of the output buffer used in script mode
+#define SCRIPT_END 's'  // Command returned when the script has no commands left (ends the game)
+
+/**
+ * Commands of a script file, read into memory at once.
+ */
+typedef struct {
+    char *data;  // Contents of the script file
+    long length;  // Number of bytes in 'data'
+    long position;  // Index of the next byte to read
+} script;
+
+int loadScript(const char *fileName, script *commands);
+char nextScriptCommand(script *commands);
+void freeScript(script *commands);
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "search.h"
+#include "simulate.h"
+#include "engine.h"
+#include "board.h"
+
+/*
+    Monte Carlo pawn search: each movable pawn is played and the game is then
+    finished 'rollouts' times with random pawns, the pawn with the highest win
+    rate is chosen. Every candidate uses the same rollout seeds (common random
+    numbers), so the dices of the rollouts do not hide the difference between pawns.
+*/
+
+
+/**
+ * @brief Plays a pawn and finishes the game several times choosing pawns at random.
+ * @param root Board with the position to search
+ * @param scratch Board of the same size where the rollouts are played
+ * @param player1 Whether it is player 1 to move
+ * @param pawn The pawn to play
+ * @param dicesValue The dices value
+ * @param rollouts Number of games to play
+ * @param seed Seed of the first rollout, rollout 'n' is seeded with 'seed + n'
+ * @return Returns the win rate of the player to move (unfinished games count as half a win)
+ */
+static double rolloutWinRate(list *root, list *scratch, bool player1, char pawn, int dicesValue, int rollouts, uint64_t seed) {
+    double wins = 0;
+
+    for (int rollout = 0; rollout < rollouts; rollout++) {
+        bool toMove = !player1;
+        int winner = 0;
+        rngState rng;
+
+        boardCopy(scratch, root);
+        makePlay(scratch, pawn, dicesValue);
+        rngSeed(&rng, seed + rollout);
+
+        for (int plays = 0; plays < SIMULATION_MAX_PLAYS; plays++) {
+            int rolled;
+
+            winner = checkGameWin(scratch, scratch->length);
+            if (winner != 0) {
+                break;
+            }
+
+            rolled = rngRollDice(&rng, scratch->dices);
+            makePlay(scratch, chooseRandomPawn(scratch, toMove, &rng), rolled);
+            toMove = !toMove;
+        }
+
+        if (winner == (player1 ? 1 : 2)) {
+            wins += 1;
+        } else if (winner == 0) {
+            wins += 0.5;
+        }
+    }
+
+    return wins / rollouts;
+}
+
+/**
+ * @brief Searches the best pawn to play with Monte Carlo rollouts.
+ * @param boardCells Board with all cells (not changed)
+ * @param player1 Whether it is player 1 to move
+ * @param dicesValue The dices value
+ * @param rollouts Number of random games played for each movable pawn
+ * @param rng Generator used to seed the rollouts
+ * @param score Receives the win rate of the chosen pawn, -1 if there was nothing to search (can be NULL)
+ * @return Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+char searchBestPawn(list *boardCells, bool player1, int dicesValue, int rollouts, rngState *rng, double *score) {
+    const char *symbols = player1 ? SYMBOLS_J1 : SYMBOLS_J2;
+    char movablePawns[MAX_PAWNS];  // Stores the pawns that can be played
+    int totalMovable = 0;  // Number of pawns that can be played
+    char bestPawn;
+    double bestScore = -1;
+    uint64_t seed;
+    list scratch;
+
+    for (int i = 1; i <= boardCells->pawns; i++) {
+        if (isPawnMovable(symbols[i], boardCells, player1)) {
+            movablePawns[totalMovable++] = symbols[i];
+        }
+    }
+
+    // Nothing to search with less than two pawns
+    bestPawn = totalMovable > 0 ? movablePawns[0] : '\0';
+    if (totalMovable < 2 || rollouts <= 0 || boardClone(&scratch, boardCells) == 1) {
+        if (score != NULL) {
+            *score = -1;
+        }
+        return bestPawn;
+    }
+
+    seed = (uint64_t) rngNext(rng) << 32 | rngNext(rng);
+    for (int candidate = 0; candidate < totalMovable; candidate++) {
+        double winRate = rolloutWinRate(boardCells, &scratch, player1, movablePawns[candidate], dicesValue, rollouts, seed);
+
+        if (winRate > bestScore) {
+            bestScore = winRate;
+            bestPawn = movablePawns[candidate];
+        }
+    }
+
+    freeBoardCells(&scratch);
+    if (score != NULL) {
+        *score = bestScore;
+    }
+
+    return bestPawn;
+}
+
+/**
+ * @brief Chooses the pawn to play: the opening book pawn when the position is
+ * in the book and can be played, otherwise the pawn found by 'searchBestPawn'.
+ * @param book The opening book (can be NULL or have no book open)
+ * @param boardCells Board with all cells (not changed)
+ * @param player1 Whether it is player 1 to move
+ * @param dicesValue The dices value
+ * @param rollouts Number of random games played for each movable pawn when searching
+ * @param rng Generator used to seed the rollouts
+ * @return Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+char chooseSearchPawn(const openingBook *book, list *boardCells, bool player1, int dicesValue, int rollouts, rngState *rng) {
+    const bookEntry *entry = bookProbe(book, bookKey(boardCells, player1, dicesValue));
+
+    // A book pawn that cannot be played here (corrupt or foreign book) is ignored
+    if (entry != NULL && isLegalPawn(boardCells, entry->pawn, player1)) {
+        return entry->pawn;
+    }
+
+    return searchBestPawn(boardCells, player1, dicesValue, rollouts, rng, NULL);
+}
@@ -0,0 +1,14 @@
+#ifndef __search_h__
+#define __search_h__
+
+#include <stdbool.h>
+#include "board.h"
+#include "book.h"
+#include "rng.h"
+
+#define SEARCH_ROLLOUTS 64  // Default number of random games played for each candidate pawn
+
+char searchBestPawn(list *boardCells, bool player1, int dicesValue, int rollouts, rngState *rng, double *score);
+char chooseSearchPawn(const openingBook *book, list *boardCells, bool player1, int dicesValue, int rollouts, rngState *rng);
+
+#endif
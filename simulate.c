@@ -0,0 +1,161 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "simulate.h"
+#include "engine.h"
+#include "board.h"
+
+/*
+    The bodies below take the number of pawns and dices as arguments and are
+    always inlined: the standard game (4 pawns, 2 dices) gets its own copy
+    where they are compile-time constants, other games use the runtime values.
+*/
+#define SIMULATE_INLINE static inline __attribute__((always_inline))
+
+
+/**
+ * @brief Chooses one of the movable pawns of the given player at random.
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1 or not
+ * @param rng Generator used to pick the pawn
+ * @param pawns The number of pawns of each player
+ * @return Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+SIMULATE_INLINE char choosePawn(list *boardCells, bool player1, rngState *rng, int pawns) {
+    const char *symbols = player1 ? SYMBOLS_J1 : SYMBOLS_J2;
+    char movablePawns[MAX_PAWNS];  // Stores the pawns that can be played
+    int totalMovable = 0;  // Number of pawns that can be played
+
+    for (int i = 1; i <= pawns; i++) {
+        if (isPawnMovable(symbols[i], boardCells, player1)) {
+            movablePawns[totalMovable++] = symbols[i];
+        }
+    }
+
+    if (totalMovable == 0) {
+        return '\0';
+    }
+
+    return movablePawns[rngRange(rng, totalMovable)];
+}
+
+/**
+ * @brief Chooses one of the movable pawns of the given player at random.
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1 or not
+ * @param rng Generator used to pick the pawn
+ * @return Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+char chooseRandomPawn(list *boardCells, bool player1, rngState *rng) {
+    if (boardCells->pawns == STANDARD_PAWNS) {
+        return choosePawn(boardCells, player1, rng, STANDARD_PAWNS);
+    }
+
+    return choosePawn(boardCells, player1, rng, boardCells->pawns);
+}
+
+/**
+ * @brief Plays a full game (see 'simulateGame').
+ * @param boardCells Board with all cells
+ * @param rng Generator used for the dices and the pawn choices
+ * @param result Receives the game result
+ * @param traffic Heatmap where the plays are recorded (can be NULL)
+ * @param pawns The number of pawns of each player
+ * @param dices The number of dices rolled in each play
+ */
+SIMULATE_INLINE void playRandomGame(list *boardCells, rngState *rng, gameResult *result, heatmap *traffic, int pawns, int dices) {
+    bool player1 = true;  // Holds the player for the current play
+
+    result->winner = 0;
+    result->plays = 0;
+    result->captures = 0;
+
+    while (result->plays < SIMULATION_MAX_PLAYS) {
+        int dicesValue;
+        char pawn;
+
+        result->winner = checkGameWin(boardCells, boardCells->length);
+        if (result->winner != 0) {
+            return;
+        }
+
+        dicesValue = rngRollDice(rng, dices);
+        pawn = choosePawn(boardCells, player1, rng, pawns);
+        if (traffic != NULL) {
+            result->captures += heatmapPlay(traffic, boardCells, pawn, dicesValue);
+        } else {
+            result->captures += makePlay(boardCells, pawn, dicesValue);
+        }
+        result->plays++;
+
+        player1 = !player1;
+    }
+}
+
+/**
+ * @brief Plays a full game, choosing pawns at random, using the same
+ * rules as the interactive game loop. The board must be in its initial position.
+ * @param boardCells Board with all cells
+ * @param rng Generator used for the dices and the pawn choices
+ * @param result Receives the game result
+ * @param traffic Heatmap where the plays are recorded (can be NULL)
+ */
+void simulateGame(list *boardCells, rngState *rng, gameResult *result, heatmap *traffic) {
+    if (boardCells->pawns == STANDARD_PAWNS && boardCells->dices == STANDARD_DICES) {
+        playRandomGame(boardCells, rng, result, traffic, STANDARD_PAWNS, STANDARD_DICES);
+    } else {
+        playRandomGame(boardCells, rng, result, traffic, boardCells->pawns, boardCells->dices);
+    }
+}
+
+/**
+ * @brief Simulates several games on the same board configuration. The board is
+ * built once and its pawns are sent back home before each game.
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param safeCells Safe cells read from the config file
+ * @param pawns The number of pawns of each player
+ * @param dices The number of dices rolled in each play
+ * @param games Number of games to simulate
+ * @param seed Seed for the dices and pawn choices, game 'n' is seeded with 'seed + n'
+ * @param stats Receives the accumulated results (added to the values it already has)
+ * @param results Array that receives the result of each game (can be NULL)
+ * @param traffic Heatmap where the plays are recorded (can be NULL), must have the board number of cells
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int simulateGames(unsigned int rows, unsigned int cols, const safeCellSet *safeCells, int pawns, int dices, long games, uint64_t seed, simulationStats *stats, gameResult *results, heatmap *traffic) {
+    list boardCells;  // List struct to store all board cells data
+    gameResult result;  // Result of the current game
+    rngState rng;  // Dices and pawn choices generator
+
+    initializeCellsList(&boardCells);
+    boardCells.pawns = pawns;
+    boardCells.dices = dices;
+    if (boardSetup(&boardCells, safeCells, rows * 2 + (cols - 2) * 2) == 1) {
+        freeBoardCells(&boardCells);
+        return 1;
+    }
+
+    for (long game = 0; game < games; game++) {
+        if (game > 0) {
+            boardReset(&boardCells);
+        }
+
+        // Each game has its own seed, so any game can be replayed on its own
+        rngSeed(&rng, seed + game);
+        simulateGame(&boardCells, &rng, &result, traffic);
+
+        if (results != NULL) {
+            results[game] = result;
+        }
+
+        stats->games++;
+        stats->p1Wins += result.winner == 1;
+        stats->p2Wins += result.winner == 2;
+        stats->plays += result.plays;
+        stats->captures += result.captures;
+    }
+
+    freeBoardCells(&boardCells);
+    return 0;
+}
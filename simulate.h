@@ -0,0 +1,37 @@
+#ifndef __simulate_h__
+#define __simulate_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "engine.h"
+#include "rng.h"
+#include "heatmap.h"
+
+#define SIMULATION_MAX_PLAYS 100000  // Plays after which a simulated game is considered unfinished
+
+/**
+ * Result of a single simulated game.
+ */
+typedef struct {
+    int winner;  // 1 - P1 won, 2 - P2 won, 0 - game reached 'SIMULATION_MAX_PLAYS'
+    int plays;  // Number of plays made
+    int captures;  // Number of pawns captured by both players
+} gameResult;
+
+/**
+ * Accumulated results of several simulated games.
+ */
+typedef struct {
+    long games;  // Number of simulated games
+    long p1Wins;  // Number of games won by P1
+    long p2Wins;  // Number of games won by P2
+    long plays;  // Total number of plays
+    long captures;  // Total number of captured pawns
+} simulationStats;
+
+char chooseRandomPawn(list *boardCells, bool player1, rngState *rng);
+void simulateGame(list *boardCells, rngState *rng, gameResult *result, heatmap *traffic);
+int simulateGames(unsigned int rows, unsigned int cols, const safeCellSet *safeCells, int pawns, int dices, long games, uint64_t seed, simulationStats *stats, gameResult *results, heatmap *traffic);
+
+#endif
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "snapshot.h"
+#include "engine.h"
+#include "board.h"
+
+/*
+    Snapshot layout (SNAPSHOT_SIZE bytes, multi-byte values are little-endian):
+        0..2    magic "NTC"
+        3       format version
+        4       number of board lines
+        5       number of board columns
+        6       player to move (0 - P1, 1 - P2)
+        7       pending dices value (0 if none)
+        8..15   dices generator state
+        16      number of pawns of each player
+        17      number of dices rolled in each play
+        18..31  one byte per pawn slot ('MAX_PAWNS' for P1 then 'MAX_PAWNS' for P2, unused slots are 0):
+                bits 0-6 hold the cell index, bit 7 is set if the pawn is WIN
+        32..47  safe cells bitmap (bit 'n' set if cell 'n' is a safe cell)
+*/
+#define SNAPSHOT_RULES_OFFSET 16
+#define SNAPSHOT_PAWNS_OFFSET 18
+#define SNAPSHOT_SAFE_OFFSET 32
+#define SNAPSHOT_WIN_FLAG 0x80
+#define SNAPSHOT_CELL_MASK 0x7F
+
+
+/**
+ * @brief Serialises the full game state into a fixed-size snapshot.
+ * @param boardCells Board with all cells
+ * @param info Game state that is not stored in the board cells
+ * @param buffer Buffer with at least 'SNAPSHOT_SIZE' bytes that receives the snapshot
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (board too large for the snapshot)
+ */
+int snapshotEncode(const list *boardCells, const gameInfo *info, unsigned char *buffer) {
+    if (boardCells->length > SNAPSHOT_MAX_CELLS) {
+        return 1;
+    }
+
+    memset(buffer, 0, SNAPSHOT_SIZE);
+
+    // Header
+    buffer[0] = 'N';
+    buffer[1] = 'T';
+    buffer[2] = 'C';
+    buffer[3] = SNAPSHOT_VERSION;
+    buffer[4] = (unsigned char) info->rows;
+    buffer[5] = (unsigned char) info->cols;
+    buffer[6] = info->player1 ? 0 : 1;
+    buffer[7] = (unsigned char) info->dicesValue;
+
+    for (int byte = 0; byte < 8; byte++) {
+        buffer[8 + byte] = (unsigned char) (info->rng.state >> (8 * byte));
+    }
+
+    // Game rules
+    buffer[SNAPSHOT_RULES_OFFSET] = (unsigned char) boardCells->pawns;
+    buffer[SNAPSHOT_RULES_OFFSET + 1] = (unsigned char) boardCells->dices;
+
+    // Pawns, read from the position index
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIdx = 0; pawnIdx < boardCells->pawns; pawnIdx++) {
+            int cellIndex = boardCells->pawnCells[player][pawnIdx];
+            state pawnState = casaPawnState(boardCells->cells[cellIndex], player, pawnIdx);
+
+            buffer[SNAPSHOT_PAWNS_OFFSET + player * MAX_PAWNS + pawnIdx] =
+                (unsigned char) cellIndex | (pawnState == WIN ? SNAPSHOT_WIN_FLAG : 0);
+        }
+    }
+
+    // Safe cells
+    for (int cellIndex = 0; cellIndex < boardCells->length; cellIndex++) {
+        if (casaIsSafe(boardCells->cells[cellIndex])) {
+            buffer[SNAPSHOT_SAFE_OFFSET + cellIndex / 8] |= 1 << (cellIndex % 8);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads and validates the snapshot header (everything but the board cells).
+ * @param buffer Buffer with the snapshot
+ * @param info Receives the game state stored in the snapshot
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int snapshotDecodeInfo(const unsigned char *buffer, gameInfo *info) {
+    unsigned int totalCells;
+    int pawns = buffer[SNAPSHOT_RULES_OFFSET];
+    int dices = buffer[SNAPSHOT_RULES_OFFSET + 1];
+
+    if (buffer[0] != 'N' || buffer[1] != 'T' || buffer[2] != 'C' || buffer[3] != SNAPSHOT_VERSION) {
+        return 1;
+    }
+
+    // Board dimensions must follow the same rules as the CLI arguments
+    if (buffer[4] < MIN_ROWS || buffer[4] % 2 == 0 || buffer[5] <= MIN_COLS) {
+        return 1;
+    }
+
+    totalCells = buffer[4] * 2 + (buffer[5] - 2) * 2;
+    if (!validGameRules(pawns, dices)) {
+        return 1;
+    }
+
+    // The pending dices value must be one the dices can roll
+    if (totalCells > SNAPSHOT_MAX_CELLS || buffer[6] > 1 || (buffer[7] != 0 && (buffer[7] < dices || buffer[7] > dices * DICE_FACES))) {
+        return 1;
+    }
+
+    // Every pawn must be inside the board, WIN pawns must be on their home cell
+    for (int slot = 0; slot < 2 * MAX_PAWNS; slot++) {
+        unsigned int cellIndex = buffer[SNAPSHOT_PAWNS_OFFSET + slot] & SNAPSHOT_CELL_MASK;
+        unsigned int home = slot < MAX_PAWNS ? 0 : totalCells / 2;
+
+        if (slot % MAX_PAWNS >= pawns) {
+            continue;
+        }
+
+        if (cellIndex >= totalCells) {
+            return 1;
+        }
+
+        if ((buffer[SNAPSHOT_PAWNS_OFFSET + slot] & SNAPSHOT_WIN_FLAG) && cellIndex != home) {
+            return 1;
+        }
+    }
+
+    info->rows = buffer[4];
+    info->cols = buffer[5];
+    info->pawns = pawns;
+    info->dices = dices;
+    info->player1 = buffer[6] == 0;
+    info->dicesValue = buffer[7];
+    info->rng.state = 0;
+
+    for (int byte = 0; byte < 8; byte++) {
+        info->rng.state |= (uint64_t) buffer[8 + byte] << (8 * byte);
+    }
+
+    return info->rng.state == 0;
+}
+
+/**
+ * @brief Restores the board cells from a snapshot. The board must already have
+ * the snapshot dimensions and pawns; its cells are overwritten in place.
+ * @param buffer Buffer with the snapshot (already validated by 'snapshotDecodeInfo')
+ * @param boardCells Board with all cells
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int snapshotApply(const unsigned char *buffer, list *boardCells) {
+    int totalCells = buffer[4] * 2 + (buffer[5] - 2) * 2;
+
+    if (boardCells->length != totalCells || boardCells->pawns != buffer[SNAPSHOT_RULES_OFFSET]) {
+        return 1;
+    }
+    boardCells->dices = buffer[SNAPSHOT_RULES_OFFSET + 1];
+
+    // Safe cells first, then every pawn goes straight to its cell
+    for (int cellIndex = 0; cellIndex < totalCells; cellIndex++) {
+        boardCells->cells[cellIndex] = buffer[SNAPSHOT_SAFE_OFFSET + cellIndex / 8] & (1 << (cellIndex % 8)) ? CASA_SAFE : 0;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIdx = 0; pawnIdx < boardCells->pawns; pawnIdx++) {
+            unsigned char pawnByte = buffer[SNAPSHOT_PAWNS_OFFSET + player * MAX_PAWNS + pawnIdx];
+
+            casaSetPawnState(&boardCells->cells[pawnByte & SNAPSHOT_CELL_MASK], player, pawnIdx,
+                             pawnByte & SNAPSHOT_WIN_FLAG ? WIN : TRUE);
+            boardCells->pawnCells[player][pawnIdx] = pawnByte & SNAPSHOT_CELL_MASK;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes a snapshot to a file.
+ * @param fileName The name of the file
+ * @param buffer Buffer with the snapshot
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int saveSnapshotFile(const char *fileName, const unsigned char *buffer) {
+    FILE *fp = fopen(fileName, "wb");
+    size_t written;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    written = fwrite(buffer, 1, SNAPSHOT_SIZE, fp);
+
+    // 'fclose' flushes the stream, so its result must also be checked
+    if (fclose(fp) != 0 || written != SNAPSHOT_SIZE) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads a snapshot from a file.
+ * @param fileName The name of the file
+ * @param buffer Buffer with at least 'SNAPSHOT_SIZE' bytes that receives the snapshot
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int loadSnapshotFile(const char *fileName, unsigned char *buffer) {
+    FILE *fp = fopen(fileName, "rb");
+    size_t bytesRead;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    bytesRead = fread(buffer, 1, SNAPSHOT_SIZE, fp);
+    fclose(fp);
+
+    return bytesRead != SNAPSHOT_SIZE;
+}
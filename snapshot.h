@@ -0,0 +1,32 @@
+#ifndef __snapshot_h__
+#define __snapshot_h__
+
+#include <stdbool.h>
+#include "board.h"
+#include "rng.h"
+
+#define SNAPSHOT_SIZE 48  // Size in bytes of a serialised game snapshot
+#define SNAPSHOT_VERSION 2  // Snapshot format version
+#define SNAPSHOT_MAX_CELLS 128  // Max number of cells of a board that can be saved in a snapshot
+#define SAVE_FILE "jogo.sav"  // Default file used to save/restore the game
+
+/**
+ * Game state that lives outside of the board cells.
+ */
+typedef struct {
+    unsigned int rows;  // Number of board lines
+    unsigned int cols;  // Number of board columns
+    int pawns;  // Number of pawns of each player
+    int dices;  // Number of dices rolled in each play
+    bool player1;  // Whether it is player 1 turn
+    unsigned int dicesValue;  // Dices value pending for the current play (0 if none)
+    rngState rng;  // Dices generator state
+} gameInfo;
+
+int snapshotEncode(const list *boardCells, const gameInfo *info, unsigned char *buffer);
+int snapshotDecodeInfo(const unsigned char *buffer, gameInfo *info);
+int snapshotApply(const unsigned char *buffer, list *boardCells);
+int saveSnapshotFile(const char *fileName, const unsigned char *buffer);
+int loadSnapshotFile(const char *fileName, unsigned char *buffer);
+
+#endif
@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "spectator.h"
+#include "board.h"
+
+/*
+    Spectator broadcast: every board is rendered once per move, in both
+    presentation modes, into a reference counted frame. The frame is queued on
+    every viewer and sent with a single 'sendmsg' (gathering the rest of the frame
+    being sent and the waiting frame, like 'writev'). Sockets are non-blocking:
+    what a viewer can not take now is sent on the next broadcast, and a viewer
+    that falls behind skips to the newest frame, so the game never waits.
+*/
+
+
+/**
+ * @brief Gets the current time in milliseconds.
+ * @return Returns the time of a monotonic clock
+ */
+static long nowMilliseconds(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000L + time.tv_nsec / 1000000L;
+}
+
+/**
+ * @brief Initializes a spectator server as closed (broadcasts do nothing).
+ * @param server The server
+ */
+void spectatorInit(spectatorServer *server) {
+    server->listenSocket = -1;
+    server->path[0] = '\0';
+    server->totalViewers = 0;
+    server->framesSent = 0;
+    server->framesDropped = 0;
+}
+
+/**
+ * @brief Opens the local socket the viewers connect to.
+ * @param path Path of the socket, a socket left there by a previous game is replaced
+ * @param server The server
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int spectatorOpen(const char *path, spectatorServer *server) {
+    struct sockaddr_un address;
+    struct stat pathInfo;
+
+    spectatorInit(server);
+    if (strlen(path) >= sizeof(address.sun_path) || strlen(path) >= sizeof(server->path)) {
+        return 1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    // Only an old socket is removed, never a regular file
+    if (stat(path, &pathInfo) == 0 && S_ISSOCK(pathInfo.st_mode)) {
+        unlink(path);
+    }
+
+    server->listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listenSocket < 0) {
+        return 1;
+    }
+
+    if (bind(server->listenSocket, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(server->listenSocket, SOMAXCONN) != 0) {
+        close(server->listenSocket);
+        server->listenSocket = -1;
+        return 1;
+    }
+
+    strcpy(server->path, path);
+    return 0;
+}
+
+/**
+ * @brief Renders a board in both presentation modes into a new frame.
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param boardCells Board with all cells
+ * @param caption Text shown above the board in both modes
+ * @return Returns the frame, with one reference owned by the caller, NULL on 'FAILURE'
+ */
+spectatorFrame *spectatorRender(const unsigned int rows, const unsigned int cols, list *boardCells, const char *caption) {
+    spectatorFrame *frame = malloc(sizeof(spectatorFrame));
+    size_t size;
+    FILE *stream;
+
+    if (frame == NULL) {
+        return NULL;
+    }
+
+    stream = open_memstream(&frame->data, &size);
+    if (stream == NULL) {
+        free(frame);
+        return NULL;
+    }
+
+    for (int mode = 0; mode < 2; mode++) {
+        fputs(caption, stream);
+        boardPrintTo(stream, rows, cols, *boardCells, mode);
+        if (mode == 0) {
+            fflush(stream);
+            frame->length[0] = size;
+        }
+    }
+
+    if (fclose(stream) != 0) {
+        free(frame->data);
+        free(frame);
+        return NULL;
+    }
+
+    frame->length[1] = size - frame->length[0];
+    frame->references = 1;
+    return frame;
+}
+
+/**
+ * @brief Drops a reference to a frame, the frame is freed with its last reference.
+ * @param frame The frame (can be NULL)
+ */
+void spectatorRelease(spectatorFrame *frame) {
+    if (frame != NULL && --frame->references == 0) {
+        free(frame->data);
+        free(frame);
+    }
+}
+
+/**
+ * @brief Gets the data of a frame in a presentation mode.
+ * @param frame The frame
+ * @param mode The presentation mode
+ * @return Returns the first byte of the mode
+ */
+static char *frameData(spectatorFrame *frame, int mode) {
+    return mode == 0 ? frame->data : frame->data + frame->length[0];
+}
+
+/**
+ * @brief Disconnects a viewer, releasing its frames.
+ * @param server The server
+ * @param viewerIndex Index of the viewer, the last viewer takes its place
+ */
+static void dropViewer(spectatorServer *server, int viewerIndex) {
+    spectatorViewer *viewer = &server->viewers[viewerIndex];
+
+    close(viewer->socket);
+    spectatorRelease(viewer->sending);
+    spectatorRelease(viewer->waiting);
+    server->viewers[viewerIndex] = server->viewers[--server->totalViewers];
+}
+
+/**
+ * @brief Accepts the viewers waiting to connect.
+ * @param server The server
+ */
+static void acceptViewers(spectatorServer *server) {
+    int viewerSocket;
+
+    while ((viewerSocket = accept(server->listenSocket, NULL, NULL)) >= 0) {
+        spectatorViewer *viewer;
+
+        if (server->totalViewers == SPECTATOR_MAX_VIEWERS) {
+            close(viewerSocket);
+            continue;
+        }
+
+        // Sends must never block the game
+        fcntl(viewerSocket, F_SETFL, O_NONBLOCK);
+        fcntl(viewerSocket, F_SETFD, FD_CLOEXEC);
+
+        viewer = &server->viewers[server->totalViewers];
+        viewer->socket = viewerSocket;
+        viewer->mode = 0;
+        viewer->sendingMode = 0;
+        viewer->sending = NULL;
+        viewer->sent = 0;
+        viewer->waiting = NULL;
+        server->totalViewers++;
+    }
+}
+
+/**
+ * @brief Reads the presentation mode requested by a viewer, if any.
+ * @param viewer The viewer
+ * @return Returns 0 on 'SUCCESS' and 1 if the viewer is gone
+ */
+static int readViewerMode(spectatorViewer *viewer) {
+    char request[64];
+    ssize_t received;
+
+    while ((received = recv(viewer->socket, request, sizeof(request), MSG_DONTWAIT)) > 0) {
+        for (ssize_t byte = 0; byte < received; byte++) {
+            if (request[byte] == '0' || request[byte] == '1') {
+                viewer->mode = request[byte] - '0';
+            }
+        }
+    }
+
+    return received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+}
+
+/**
+ * @brief Queues a frame on a viewer. A frame already waiting is replaced (the viewer skips it).
+ * @param server The server
+ * @param viewer The viewer
+ * @param frame The frame
+ */
+static void queueFrame(spectatorServer *server, spectatorViewer *viewer, spectatorFrame *frame) {
+    frame->references++;
+
+    if (viewer->sending == NULL) {
+        viewer->sending = frame;
+        viewer->sendingMode = viewer->mode;
+        viewer->sent = 0;
+    } else {
+        if (viewer->waiting != NULL) {
+            spectatorRelease(viewer->waiting);
+            server->framesDropped++;
+        }
+        viewer->waiting = frame;
+    }
+}
+
+/**
+ * @brief Sends what the viewer socket can take without blocking.
+ * @param server The server
+ * @param viewer The viewer
+ * @return Returns 0 on 'SUCCESS' and 1 if the viewer is gone
+ */
+static int flushViewer(spectatorServer *server, spectatorViewer *viewer) {
+    while (viewer->sending != NULL) {
+        struct iovec parts[2];
+        struct msghdr message;
+        ssize_t written;
+
+        memset(&message, 0, sizeof(message));
+        parts[0].iov_base = frameData(viewer->sending, viewer->sendingMode) + viewer->sent;
+        parts[0].iov_len = viewer->sending->length[viewer->sendingMode] - viewer->sent;
+        if (viewer->waiting != NULL) {
+            parts[1].iov_base = frameData(viewer->waiting, viewer->mode);
+            parts[1].iov_len = viewer->waiting->length[viewer->mode];
+        }
+        message.msg_iov = parts;
+        message.msg_iovlen = viewer->waiting != NULL ? 2 : 1;
+
+        written = sendmsg(viewer->socket, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written < 0) {
+            return errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+        }
+
+        // Finished frames are released, the waiting frame becomes the frame being sent
+        viewer->sent += written;
+        while (viewer->sending != NULL && viewer->sent >= viewer->sending->length[viewer->sendingMode]) {
+            viewer->sent -= viewer->sending->length[viewer->sendingMode];
+            spectatorRelease(viewer->sending);
+            server->framesSent++;
+
+            viewer->sending = viewer->waiting;
+            viewer->sendingMode = viewer->mode;
+            viewer->waiting = NULL;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sends a frame to every viewer, without blocking. Connects the new viewers first.
+ * @param server The server (does nothing if it is not open)
+ * @param frame The frame, the caller keeps its reference
+ */
+void spectatorBroadcast(spectatorServer *server, spectatorFrame *frame) {
+    if (server->listenSocket < 0) {
+        return;
+    }
+
+    acceptViewers(server);
+
+    for (int viewerIndex = server->totalViewers - 1; viewerIndex >= 0; viewerIndex--) {
+        spectatorViewer *viewer = &server->viewers[viewerIndex];
+
+        if (readViewerMode(viewer) == 1) {
+            dropViewer(server, viewerIndex);
+            continue;
+        }
+
+        queueFrame(server, viewer, frame);
+        if (flushViewer(server, viewer) == 1) {
+            dropViewer(server, viewerIndex);
+        }
+    }
+}
+
+/**
+ * @brief Renders a board and sends it to every viewer.
+ * @param server The server (does nothing if it is not open)
+ * @param rows Number of board lines
+ * @param cols Number of board columns
+ * @param boardCells Board with all cells
+ * @param caption Text shown above the board
+ */
+void spectatorBroadcastBoard(spectatorServer *server, const unsigned int rows, const unsigned int cols, list *boardCells, const char *caption) {
+    spectatorFrame *frame;
+
+    if (server->listenSocket < 0) {
+        return;
+    }
+
+    frame = spectatorRender(rows, cols, boardCells, caption);
+    if (frame != NULL) {
+        spectatorBroadcast(server, frame);
+        spectatorRelease(frame);
+    }
+}
+
+/**
+ * @brief Gives the viewers up to 'SPECTATOR_DRAIN_MS' to receive their last
+ * frames, then disconnects them and removes the socket.
+ * @param server The server (does nothing if it is not open)
+ */
+void spectatorClose(spectatorServer *server) {
+    long deadline = nowMilliseconds() + SPECTATOR_DRAIN_MS;
+    struct pollfd waiting[SPECTATOR_MAX_VIEWERS];
+
+    if (server->listenSocket < 0) {
+        return;
+    }
+
+    for (;;) {
+        int totalWaiting = 0;
+        long remaining = deadline - nowMilliseconds();
+
+        for (int viewerIndex = 0; viewerIndex < server->totalViewers; viewerIndex++) {
+            if (server->viewers[viewerIndex].sending != NULL) {
+                waiting[totalWaiting].fd = server->viewers[viewerIndex].socket;
+                waiting[totalWaiting].events = POLLOUT;
+                totalWaiting++;
+            }
+        }
+
+        if (totalWaiting == 0 || remaining <= 0 || poll(waiting, totalWaiting, (int) remaining) <= 0) {
+            break;
+        }
+
+        for (int viewerIndex = server->totalViewers - 1; viewerIndex >= 0; viewerIndex--) {
+            if (server->viewers[viewerIndex].sending != NULL && flushViewer(server, &server->viewers[viewerIndex]) == 1) {
+                dropViewer(server, viewerIndex);
+            }
+        }
+    }
+
+    while (server->totalViewers > 0) {
+        dropViewer(server, server->totalViewers - 1);
+    }
+
+    close(server->listenSocket);
+    unlink(server->path);
+    spectatorInit(server);
+}
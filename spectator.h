@@ -0,0 +1,55 @@
+#ifndef __spectator_h__
+#define __spectator_h__
+
+#include <stddef.h>
+#include "board.h"
+
+#define SPECTATOR_MAX_VIEWERS 512  // Max number of viewers connected at the same time
+#define SPECTATOR_DRAIN_MS 1000  // Time given to the viewers to receive the last frames when the game ends
+#define SPECTATOR_CAPTION_SIZE 128  // Max size of the text shown above a board
+
+/**
+ * Frame: the board rendered once in both presentation modes, shared by every
+ * viewer that still has to send it and freed when the last one is done.
+ */
+typedef struct {
+    int references;  // Number of holders (the broadcaster and the viewer queues)
+    char *data;  // Full board ('modo' 0) followed by the compact board ('modo' 1)
+    size_t length[2];  // Length of each mode
+} spectatorFrame;
+
+/**
+ * Connected viewer. A viewer holds at most two frames: the one being sent and
+ * the newest one waiting, a newer frame replaces the waiting one (coalescing),
+ * so a slow viewer never makes the game wait and skips to the latest board.
+ */
+typedef struct {
+    int socket;
+    int mode;  // Presentation mode, 0 or 1, chosen by the viewer sending '0' or '1'
+    int sendingMode;  // Presentation mode of the frame being sent
+    spectatorFrame *sending;  // Frame being sent, NULL if none
+    size_t sent;  // Bytes of 'sending' already sent
+    spectatorFrame *waiting;  // Next frame, NULL if none
+} spectatorViewer;
+
+/**
+ * Spectator server: local socket the viewers connect to.
+ */
+typedef struct {
+    int listenSocket;  // -1 if the server is not open
+    char path[108];  // Path of the socket (same size as 'sun_path')
+    spectatorViewer viewers[SPECTATOR_MAX_VIEWERS];
+    int totalViewers;
+    long framesSent;  // Frames fully sent to a viewer
+    long framesDropped;  // Frames a slow viewer skipped
+} spectatorServer;
+
+void spectatorInit(spectatorServer *server);
+int spectatorOpen(const char *path, spectatorServer *server);
+spectatorFrame *spectatorRender(const unsigned int rows, const unsigned int cols, list *boardCells, const char *caption);
+void spectatorRelease(spectatorFrame *frame);
+void spectatorBroadcast(spectatorServer *server, spectatorFrame *frame);
+void spectatorBroadcastBoard(spectatorServer *server, const unsigned int rows, const unsigned int cols, list *boardCells, const char *caption);
+void spectatorClose(spectatorServer *server);
+
+#endif
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <math.h>
+#include "td.h"
+#include "engine.h"
+#include "policy.h"
+#include "simulate.h"
+
+/*
+    Value function learned by TD(lambda) self-play. A position is seen right
+    after a play of 'player' (the adversary moves next) and its value is the
+    probability of 'player' winning: the logistic of a linear function of
+    sparse features. Features are relative to the lap, so weights learned on
+    one board can play on another: per player, the pawns in each progress
+    bucket, their exposure to the next adversary play in the same bucket
+    (probability of a two dices sum reaching them, see 'pawnExposure') and the
+    number of WIN pawns.
+*/
+
+
+/**
+ * @brief Loads a weight (Hogwild: no lock, the value can be slightly stale).
+ * @param weights The weights
+ * @param index The feature index
+ * @return Returns the weight
+ */
+static inline double loadWeight(const tdWeights *weights, int index) {
+    return atomic_load_explicit((_Atomic double *) &weights->weights[index], memory_order_relaxed);
+}
+
+/**
+ * @brief Adds to a weight (Hogwild: a concurrent update of the same weight can be lost).
+ * @param weights The weights
+ * @param index The feature index
+ * @param delta The value added
+ */
+static inline void addWeight(tdWeights *weights, int index, double delta) {
+    atomic_store_explicit(&weights->weights[index], loadWeight(weights, index) + delta, memory_order_relaxed);
+}
+
+/**
+ * @brief Sets all weights to 0 (every position is worth 0.5).
+ * @param weights The weights
+ */
+void tdInitWeights(tdWeights *weights) {
+    for (int feature = 0; feature < TD_FEATURES; feature++) {
+        atomic_init(&weights->weights[feature], 0);
+    }
+}
+
+/**
+ * @brief Reads the weights from a file: the number of features, then one weight per line.
+ * @param fileName The name of the weights file
+ * @param weights Receives the weights
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE' (the file can not be read or has other features)
+ */
+int tdLoadWeights(const char *fileName, tdWeights *weights) {
+    FILE *fp = fopen(fileName, "r");
+    int totalFeatures;
+    double weight;
+    int result = 0;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    if (fscanf(fp, "%d", &totalFeatures) != 1 || totalFeatures != TD_FEATURES) {
+        result = 1;
+    }
+
+    for (int feature = 0; feature < TD_FEATURES && result == 0; feature++) {
+        if (fscanf(fp, "%lf", &weight) == 1) {
+            atomic_init(&weights->weights[feature], weight);
+        } else {
+            result = 1;
+        }
+    }
+
+    if (result == 0 && fscanf(fp, "%lf", &weight) != EOF) {
+        result = 1;
+    }
+
+    fclose(fp);
+    return result;
+}
+
+/**
+ * @brief Writes the weights to a file, replacing it only once it is complete,
+ * so a checkpoint is never left half written.
+ * @param fileName The name of the weights file
+ * @param weights The weights
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+int tdSaveWeights(const char *fileName, const tdWeights *weights) {
+    char tempName[FILENAME_MAX];
+    FILE *fp;
+    int failed;
+
+    if (snprintf(tempName, sizeof(tempName), "%s.tmp", fileName) >= (int) sizeof(tempName)) {
+        return 1;
+    }
+
+    fp = fopen(tempName, "w");
+    if (fp == NULL) {
+        return 1;
+    }
+
+    failed = fprintf(fp, "%d\n", TD_FEATURES) < 0;
+    for (int feature = 0; feature < TD_FEATURES && !failed; feature++) {
+        failed = fprintf(fp, "%.9g\n", loadWeight(weights, feature)) < 0;
+    }
+
+    if (fclose(fp) != 0) {
+        failed = 1;
+    }
+
+    if (failed || rename(tempName, fileName) != 0) {
+        remove(tempName);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Gets the features of a position.
+ * @param boardCells Board with all cells
+ * @param player The player the position is seen by (0 - P1, 1 - P2), its pawns come first
+ * @param features Receives the non-zero features
+ */
+void tdFeatures(const list *boardCells, int player, tdFeatureList *features) {
+    features->length = 0;
+
+    for (int side = 0; side < 2; side++) {
+        int owner = side == 0 ? player : 1 - player;
+        int base = side * TD_SIDE_FEATURES;
+        int wins = 0;
+
+        for (int pawn = 0; pawn < 4; pawn++) {
+            int progress = pawnProgress(boardCells, owner, pawn);
+            int bucket = (int) ((long) progress * TD_BUCKETS / boardCells->length);
+            double exposure;
+
+            if (progress == boardCells->length) {
+                wins++;
+                continue;
+            }
+
+            features->index[features->length] = base + bucket;
+            features->value[features->length++] = 1;
+
+            exposure = pawnExposure(boardCells, owner, pawn);
+            if (exposure > 0) {
+                features->index[features->length] = base + TD_BUCKETS + bucket;
+                features->value[features->length++] = exposure;
+            }
+        }
+
+        features->index[features->length] = base + TD_BUCKETS * 2 + wins;
+        features->value[features->length++] = 1;
+    }
+
+    features->index[features->length] = TD_FEATURES - 1;
+    features->value[features->length++] = 1;
+}
+
+/**
+ * @brief Gets the value of sparse features.
+ * @param weights The weights
+ * @param features The features
+ * @return Returns the logistic of the weighted sum, between 0 and 1
+ */
+static double featuresValue(const tdWeights *weights, const tdFeatureList *features) {
+    double sum = 0;
+
+    for (int i = 0; i < features->length; i++) {
+        sum += loadWeight(weights, features->index[i]) * features->value[i];
+    }
+
+    return 1 / (1 + exp(-sum));
+}
+
+/**
+ * @brief Gets the value of a position, right after a play of 'player'.
+ * @param weights The weights
+ * @param boardCells Board with all cells
+ * @param player The player that just played (0 - P1, 1 - P2)
+ * @return Returns the estimated probability of 'player' winning
+ */
+double tdValue(const tdWeights *weights, const list *boardCells, int player) {
+    tdFeatureList features;
+
+    tdFeatures(boardCells, player, &features);
+    return featuresValue(weights, &features);
+}
+
+/**
+ * @brief Chooses the play that leads to the position with the highest value, at random among ties.
+ * @param weights The weights
+ * @param boardCells Board with all cells (not changed)
+ * @param player1 Whether it is player 1 to move
+ * @param dicesValue The dices value
+ * @param scratch Board of the same size where the plays are tried
+ * @param rng Generator used to break ties
+ * @return Returns the chosen pawn or '\0' if the player has no movable pawns
+ */
+char tdBestPawn(const tdWeights *weights, list *boardCells, bool player1, int dicesValue, list *scratch, rngState *rng) {
+    const char *symbols = player1 ? SYMBOLS_J1 : SYMBOLS_J2;
+    double bestValue = -1;
+    char best = '\0';
+    int ties = 0;
+
+    for (int i = 1; i < 5; i++) {
+        double value;
+
+        if (!isPawnMovable(symbols[i], boardCells, player1)) {
+            continue;
+        }
+
+        boardCopy(scratch, boardCells);
+        makePlay(scratch, symbols[i], dicesValue);
+        value = tdValue(weights, scratch, player1 ? 0 : 1);
+
+        if (value > bestValue) {
+            bestValue = value;
+            best = symbols[i];
+            ties = 1;
+        } else if (value == bestValue && rngRange(rng, ++ties) == 0) {
+            best = symbols[i];
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Plays a self-play game and learns from it by TD(lambda). The value
+ * followed is the probability of P1 winning: the value of the position after
+ * a P1 play, or 1 minus the value of the position after a P2 play. Dices are
+ * two real dices, so the sums follow their true distribution.
+ * @param weights The weights, updated after every play
+ * @param settings Training parameters
+ * @param boardCells Board with all cells, reset before the game
+ * @param scratch Board of the same size where the plays are tried
+ * @param rng Generator of the dices and of the exploration
+ * @return Returns 1 if player 1 won, 2 if player 2 won and 0 if the game reached 'SIMULATION_MAX_PLAYS'
+ */
+int tdTrainGame(tdWeights *weights, const tdSettings *settings, list *boardCells, list *scratch, rngState *rng) {
+    double trace[TD_FEATURES] = {0};
+    uint32_t explorationLimit = (uint32_t) (settings->exploration * 4294967295.0);
+    double previousValue = 0;
+    bool player1 = true;
+    int winner = 0;
+
+    boardReset(boardCells);
+
+    for (int plays = 0; plays < SIMULATION_MAX_PLAYS && winner == 0; plays++) {
+        int dicesValue = rngRollDice(rng, 2);
+        int player = player1 ? 0 : 1;
+        tdFeatureList features;
+        double value, gradient;
+        char pawn;
+
+        if (rngNext(rng) < explorationLimit) {
+            pawn = chooseRandomPawn(boardCells, player1, rng);
+        } else {
+            pawn = tdBestPawn(weights, boardCells, player1, dicesValue, scratch, rng);
+        }
+        makePlay(boardCells, pawn, dicesValue);
+
+        tdFeatures(boardCells, player, &features);
+        value = featuresValue(weights, &features);
+        gradient = value * (1 - value);
+        if (player == 1) {
+            // Seen by P1
+            value = 1 - value;
+            gradient = -gradient;
+        }
+
+        winner = checkGameWin(boardCells, boardCells->length);
+        if (winner != 0) {
+            // The game result replaces the estimate of the last position
+            value = winner == 1 ? 1 : 0;
+        }
+
+        if (plays > 0) {
+            double delta = settings->alpha * (value - previousValue);
+
+            for (int feature = 0; feature < TD_FEATURES; feature++) {
+                if (trace[feature] != 0) {
+                    addWeight(weights, feature, delta * trace[feature]);
+                }
+            }
+        }
+
+        for (int feature = 0; feature < TD_FEATURES; feature++) {
+            trace[feature] *= settings->lambda;
+        }
+        for (int i = 0; i < features.length; i++) {
+            trace[features.index[i]] += gradient * features.value[i];
+        }
+
+        previousValue = value;
+        player1 = !player1;
+    }
+
+    return winner;
+}
@@ -0,0 +1,50 @@
+#ifndef __td_h__
+#define __td_h__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "board.h"
+#include "rng.h"
+
+#define TD_BUCKETS 16  // Progress buckets a lap is split into
+#define TD_SIDE_FEATURES (TD_BUCKETS * 2 + 5)  // Progress and exposure per bucket plus WIN count (0 to 4) of one player
+#define TD_FEATURES (TD_SIDE_FEATURES * 2 + 1)  // Both players plus a bias
+#define TD_MAX_ACTIVE ((4 + 4 + 1) * 2 + 1)  // Max number of non-zero features of a position
+
+/**
+ * Weights of the learned value function. Training threads read and update
+ * them without locks (Hogwild), each weight is only ever loaded or stored
+ * whole, so a concurrent update can be lost but never torn.
+ */
+typedef struct {
+    _Atomic double weights[TD_FEATURES];
+} tdWeights;
+
+/**
+ * Sparse features of a position: 'length' pairs of feature index and value.
+ * An index can appear more than once (pawns in the same bucket).
+ */
+typedef struct {
+    int index[TD_MAX_ACTIVE];
+    double value[TD_MAX_ACTIVE];
+    int length;
+} tdFeatureList;
+
+/**
+ * Training parameters.
+ */
+typedef struct {
+    double alpha;  // Learning rate
+    double lambda;  // Trace decay
+    double exploration;  // Probability of a random play instead of the best one
+} tdSettings;
+
+void tdInitWeights(tdWeights *weights);
+int tdLoadWeights(const char *fileName, tdWeights *weights);
+int tdSaveWeights(const char *fileName, const tdWeights *weights);
+void tdFeatures(const list *boardCells, int player, tdFeatureList *features);
+double tdValue(const tdWeights *weights, const list *boardCells, int player);
+char tdBestPawn(const tdWeights *weights, list *boardCells, bool player1, int dicesValue, list *scratch, rngState *rng);
+int tdTrainGame(tdWeights *weights, const tdSettings *settings, list *boardCells, list *scratch, rngState *rng);
+
+#endif
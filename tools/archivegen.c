@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../rng.h"
+#include "../simulate.h"
+#include "../archive.h"
+#include "../scheduler.h"
+
+/*
+    Simulates random games (the same games as 'simulateGames', game 'n' is
+    seeded with 'seed + n') and stores them in a columnar archive. Each task
+    records one block; blocks are appended to the file as they finish, so their
+    order in the file depends on the threads but the index keeps the number of
+    the first game of each block.
+*/
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    long games;
+    long blockGames;
+    uint64_t seed;
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    archiveBlock blocks[MAX_WORKERS];  // Block being recorded by each worker thread
+    archiveWriter writer;
+    pthread_mutex_t writerLock;
+    int failed;  // Set if a block could not be written
+} generatorState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: archivegen [-r <lines>] [-c <columns>] [-s <safe cells file>] [-g <games>] [-b <games per block>] [-S <seed>] [-t <threads>] [-o <archive file>]");
+    printf("  defaults: 3x7 board without safe cells, 100000 games, %d games per block, seed 1, archive games.nta\n", ARCHIVE_BLOCK_GAMES);
+}
+
+/**
+ * @brief Simulates and records a random game (see 'simulateGame').
+ * @param block Block where the game is recorded
+ * @param boardCells Board in its initial position
+ * @param rng Generator used for the dices and the pawn choices
+ */
+static void recordGame(archiveBlock *block, list *boardCells, rngState *rng) {
+    bool player1 = true;
+    int winner = 0;
+
+    archiveBeginGame(block);
+    for (int plays = 0; plays < SIMULATION_MAX_PLAYS; plays++) {
+        int dicesValue;
+
+        winner = checkGameWin(boardCells, boardCells->length);
+        if (winner != 0) {
+            break;
+        }
+
+        dicesValue = rngRollDice(rng, 2);
+        archiveMakePlay(block, boardCells, chooseRandomPawn(boardCells, player1, rng), dicesValue);
+        player1 = !player1;
+    }
+    archiveEndGame(block, winner);
+}
+
+/**
+ * @brief Records the games of one block and appends it to the archive.
+ * @param task The task id, the block number
+ * @param worker Index of the worker thread
+ * @param arg The generator state
+ */
+static void runBlockTask(long task, int worker, void *arg) {
+    generatorState *state = arg;
+    archiveBlock *block = &state->blocks[worker];
+    list *boardCells = &state->boards[worker];
+    long firstGame = task * state->blockGames;
+    long lastGame = firstGame + state->blockGames < state->games ? firstGame + state->blockGames : state->games;
+
+    archiveBlockReset(block, (uint64_t) firstGame);
+    for (long game = firstGame; game < lastGame; game++) {
+        rngState rng;
+
+        rngSeed(&rng, state->seed + (uint64_t) game);
+        boardReset(boardCells);
+        recordGame(block, boardCells, &rng);
+    }
+
+    pthread_mutex_lock(&state->writerLock);
+    if (archiveWriteBlock(&state->writer, block) == 1) {
+        state->failed = 1;
+    }
+    pthread_mutex_unlock(&state->writerLock);
+}
+
+int main(int argc, char *argv[])
+{
+    static generatorState state;
+    unsigned int rows = 3, cols = 7;
+    int threads = availableCores();
+    const char *fileName = "games.nta";
+    safeCellSet safeCells;
+    list boardCells;
+    double start, elapsed;
+    long totalBlocks;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.games = 100000;
+    state.blockGames = ARCHIVE_BLOCK_GAMES;
+    state.seed = 1;
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:g:b:S:t:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'g':
+                state.games = strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                state.blockGames = strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'o':
+                fileName = optarg;
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    // A block holds at most 'blockGames * SIMULATION_MAX_PLAYS' plays, counted in 32 bits
+    if (!validBoardSize(rows, cols) || state.games < 1 ||
+        state.blockGames < 1 || state.blockGames > UINT32_MAX / SIMULATION_MAX_PLAYS || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        archiveBlockInit(&state.blocks[worker]);
+        if (result == 0 && boardClone(&state.boards[worker], &boardCells) == 1) {
+            result = 1;
+        }
+    }
+
+    if (result == 0 && archiveWriterOpen(fileName, rows, cols, &boardCells, &state.writer) == 1) {
+        fprintf(stderr, "archivegen: can not create %s\n", fileName);
+        result = 1;
+    }
+
+    totalBlocks = (state.games + state.blockGames - 1) / state.blockGames;
+    start = now();
+    if (result == 0) {
+        pthread_mutex_init(&state.writerLock, NULL);
+        result = runWorkStealing(threads, totalBlocks, runBlockTask, &state);
+        pthread_mutex_destroy(&state.writerLock);
+
+        if (archiveWriterClose(&state.writer) == 1 || state.failed) {
+            fprintf(stderr, "archivegen: can not write %s\n", fileName);
+            result = 1;
+        }
+    }
+    elapsed = now() - start;
+
+    if (result == 0) {
+        archiveReader reader;
+
+        if (archiveReaderOpen(fileName, &reader) == 1) {
+            fprintf(stderr, "archivegen: can not read back %s\n", fileName);
+            result = 1;
+        } else {
+            uint64_t plays = 0, captures = 0;
+
+            for (uint32_t blockNumber = 0; blockNumber < reader.totalBlocks; blockNumber++) {
+                plays += reader.index[blockNumber].plays;
+                captures += reader.index[blockNumber].captures;
+            }
+
+            printf("%s: board %ux%u, %lu games in %u blocks, %lu plays, %lu captures\n", fileName, rows, cols,
+                   (unsigned long) reader.totalGames, reader.totalBlocks, (unsigned long) plays, (unsigned long) captures);
+            printf("%zu bytes (%.2f bytes/play), %.3f s, %.0f games/s\n", reader.size,
+                   plays > 0 ? (double) reader.size / plays : 0.0, elapsed, state.games / elapsed);
+            archiveReaderClose(&reader);
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+        archiveBlockFree(&state.blocks[worker]);
+    }
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../archive.h"
+#include "../scheduler.h"
+
+/*
+    Queries a game archive: counts the games where a pawn was captured after
+    a given play, optionally on a given cell. The archive is mapped in memory
+    and each block is a task. Blocks whose index ranges can not match are
+    skipped, the others only decode the captures and outcomes columns. With
+    '-V' every game is also replayed from its dices and pawns columns and the
+    captures and the winner must match the stored ones.
+*/
+
+/**
+ * Result of the query on one block.
+ */
+typedef struct {
+    long matches;  // Matching games
+    long wins[3];  // Matching games per outcome
+    long mismatches;  // Games whose replay did not match the archive (with '-V')
+    int listed;  // Entries of 'games' used
+    bool scanned;  // Whether the block was decoded
+} blockResult;
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    archiveReader reader;
+    int cell;  // Cell of the capture, -1 for any cell
+    uint32_t afterPlay;  // Captures must happen after this play (plays count from 1)
+    int listGames;  // Matching games to keep per block
+    bool verify;
+    blockResult *results;  // One per block
+    uint64_t *games;  // 'listGames' per block
+    list boards[MAX_WORKERS];  // Board of each worker thread (with '-V')
+} queryState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: archiveq [-f <archive file>] [-k <cell>] [-a <after play>] [-l <games to list>] [-V] [-t <threads>]");
+    puts("  counts the games where a pawn was captured after the given play (on the given cell)");
+    puts("  defaults: archive games.nta, any cell, after play 20, no games listed");
+}
+
+/**
+ * @brief Checks whether the index of a block rules out any match.
+ * @param state The query state
+ * @param entry The index entry of the block
+ * @return Returns whether the block can be skipped
+ */
+static bool skipBlock(const queryState *state, const archiveBlockIndex *entry) {
+    return entry->captures == 0 || entry->maxCapturePlay <= state->afterPlay ||
+           (state->cell >= 0 && ((uint32_t) state->cell < entry->minCaptureCell || (uint32_t) state->cell > entry->maxCaptureCell));
+}
+
+/**
+ * @brief Replays the games of a block and compares them with the archive.
+ * @param state The query state
+ * @param blockNumber The block
+ * @param boardCells Board used for the replay
+ * @return Returns the number of games that do not match
+ */
+static long verifyBlock(const queryState *state, uint32_t blockNumber, list *boardCells) {
+    const archiveBlockIndex *entry = &state->reader.index[blockNumber];
+    const unsigned char *lengths = archiveColumn(&state->reader, blockNumber, ARCHIVE_LENGTHS);
+    const unsigned char *dices = archiveColumn(&state->reader, blockNumber, ARCHIVE_DICES);
+    const unsigned char *pawns = archiveColumn(&state->reader, blockNumber, ARCHIVE_PAWNS);
+    const unsigned char *captures = archiveColumn(&state->reader, blockNumber, ARCHIVE_CAPTURES);
+    const unsigned char *outcomes = archiveColumn(&state->reader, blockNumber, ARCHIVE_OUTCOMES);
+    const unsigned char *lengthsEnd = lengths + entry->columnSize[ARCHIVE_LENGTHS];
+    const unsigned char *capturesEnd = captures + entry->columnSize[ARCHIVE_CAPTURES];
+    uint32_t play = 0;
+
+    for (uint32_t game = 0; game < entry->games; game++) {
+        uint32_t plays, events, eventPlay = 0;
+        bool player1 = true;
+        bool matches;
+
+        if (archiveReadVarint(&lengths, lengthsEnd, &plays) == 1 || archiveReadVarint(&captures, capturesEnd, &events) == 1 ||
+            (events > 0 && archiveReadVarint(&captures, capturesEnd, &eventPlay) == 1)) {
+            return entry->games - game;
+        }
+        matches = play + plays <= entry->plays;
+
+        boardReset(boardCells);
+        for (uint32_t gamePlay = 1; gamePlay <= plays && matches; gamePlay++, play++) {
+            int adversary = player1 ? 1 : 0;
+            int before[4];
+            char pawn = (player1 ? SYMBOLS_J1 : SYMBOLS_J2)[archivePawn(pawns, play) + 1];
+
+            memcpy(before, boardCells->pawnCells[adversary], sizeof(before));
+            makePlay(boardCells, pawn, archiveDices(dices, play));
+
+            for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+                uint32_t cell, delta;
+
+                if (boardCells->pawnCells[adversary][pawnIndex] == before[pawnIndex]) {
+                    continue;
+                }
+
+                // The next stored capture must be this one
+                if (events == 0 || eventPlay != gamePlay || archiveReadVarint(&captures, capturesEnd, &cell) == 1 ||
+                    cell != (uint32_t) before[pawnIndex] ||
+                    (--events > 0 && archiveReadVarint(&captures, capturesEnd, &delta) == 1)) {
+                    matches = false;
+                    break;
+                }
+                if (events > 0) {
+                    eventPlay += delta;
+                }
+            }
+            player1 = !player1;
+        }
+
+        if (!matches || events != 0 || checkGameWin(boardCells, boardCells->length) != archiveOutcome(outcomes, game)) {
+            // The columns can not be followed after a mismatch
+            return entry->games - game;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Runs the query on one block.
+ * @param task The task id, the block number
+ * @param worker Index of the worker thread
+ * @param arg The query state
+ */
+static void runQueryTask(long task, int worker, void *arg) {
+    queryState *state = arg;
+    const archiveBlockIndex *entry = &state->reader.index[task];
+    blockResult *result = &state->results[task];
+    uint64_t *games = state->games + task * state->listGames;
+    const unsigned char *captures, *capturesEnd, *outcomes;
+
+    if (state->verify) {
+        result->mismatches = verifyBlock(state, (uint32_t) task, &state->boards[worker]);
+    }
+
+    if (skipBlock(state, entry)) {
+        return;
+    }
+
+    result->scanned = true;
+    captures = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_CAPTURES);
+    capturesEnd = captures + entry->columnSize[ARCHIVE_CAPTURES];
+    outcomes = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_OUTCOMES);
+
+    for (uint32_t game = 0; game < entry->games; game++) {
+        uint32_t events, play = 0;
+        bool matches = false;
+
+        // The columns were checked by 'archiveReaderOpen', a failed read only stops the scan
+        if (archiveReadVarint(&captures, capturesEnd, &events) == 1) {
+            return;
+        }
+
+        for (uint32_t event = 0; event < events; event++) {
+            uint32_t delta, cell;
+
+            if (archiveReadVarint(&captures, capturesEnd, &delta) == 1 || archiveReadVarint(&captures, capturesEnd, &cell) == 1) {
+                return;
+            }
+            play += delta;
+            matches |= play > state->afterPlay && (state->cell < 0 || cell == (uint32_t) state->cell);
+        }
+
+        if (matches) {
+            result->matches++;
+            result->wins[archiveOutcome(outcomes, game)]++;
+            if (result->listed < state->listGames) {
+                games[result->listed++] = entry->firstGame + game;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Compares two blocks by their first game (for 'qsort').
+ * @param a Pointer to the index entry pointer of a block
+ * @param b Pointer to the index entry pointer of another block
+ * @return Returns a negative number, 0 or a positive number
+ */
+static int compareFirstGame(const void *a, const void *b) {
+    const archiveBlockIndex *blockA = *(const archiveBlockIndex *const *) a;
+    const archiveBlockIndex *blockB = *(const archiveBlockIndex *const *) b;
+
+    return (blockA->firstGame > blockB->firstGame) - (blockA->firstGame < blockB->firstGame);
+}
+
+/**
+ * @brief Prints the first matching games, in game order.
+ * @param state The query state
+ */
+static void listGames(const queryState *state) {
+    const archiveBlockIndex **order = malloc(sizeof(archiveBlockIndex *) * state->reader.totalBlocks);
+    int listed = 0;
+
+    if (order == NULL) {
+        return;
+    }
+
+    for (uint32_t blockNumber = 0; blockNumber < state->reader.totalBlocks; blockNumber++) {
+        order[blockNumber] = &state->reader.index[blockNumber];
+    }
+    qsort(order, state->reader.totalBlocks, sizeof(archiveBlockIndex *), compareFirstGame);
+
+    printf("games:");
+    for (uint32_t i = 0; i < state->reader.totalBlocks && listed < state->listGames; i++) {
+        long blockNumber = order[i] - state->reader.index;
+        const blockResult *result = &state->results[blockNumber];
+
+        for (int game = 0; game < result->listed && listed < state->listGames; game++, listed++) {
+            printf(" %lu", (unsigned long) state->games[blockNumber * state->listGames + game]);
+        }
+    }
+    putchar('\n');
+
+    free(order);
+}
+
+int main(int argc, char *argv[])
+{
+    static queryState state;
+    const char *fileName = "games.nta";
+    int threads = availableCores();
+    blockResult total = {0, {0, 0, 0}, 0, 0, false};
+    long scanned = 0;
+    uint64_t scannedBytes = 0;
+    double start, elapsed;
+    int option;
+    int result = 0;
+
+    state.cell = -1;
+    state.afterPlay = 20;
+
+    while ((option = getopt(argc, argv, "f:k:a:l:Vt:h")) != -1) {
+        switch (option) {
+            case 'f':
+                fileName = optarg;
+                break;
+            case 'k':
+                state.cell = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'a':
+                state.afterPlay = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                state.listGames = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'V':
+                state.verify = true;
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                return 1;
+        }
+    }
+
+    if (state.cell < -1 || state.listGames < 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        return 1;
+    }
+
+    if (archiveReaderOpen(fileName, &state.reader) == 1) {
+        fprintf(stderr, "archiveq: %s is missing or is not a valid archive\n", fileName);
+        return 1;
+    }
+
+    state.results = calloc(state.reader.totalBlocks > 0 ? state.reader.totalBlocks : 1, sizeof(blockResult));
+    state.games = malloc(sizeof(uint64_t) * (state.reader.totalBlocks * (size_t) state.listGames + 1));
+    if (state.results == NULL || state.games == NULL) {
+        result = 1;
+    }
+
+    if (state.verify) {
+        // The archive keeps the safe cells, so the board of the games is rebuilt from it
+        safeCellSet safeCells = {(unsigned char *) state.reader.isSafe, (int) state.reader.totalCells, NULL};
+        list boardCells;
+
+        initializeCellsList(&boardCells);
+        if (result == 0 && boardSetup(&boardCells, &safeCells, (int) state.reader.totalCells) == 1) {
+            result = 1;
+        }
+
+        for (int worker = 0; worker < threads; worker++) {
+            initializeCellsList(&state.boards[worker]);
+            if (result == 0 && boardClone(&state.boards[worker], &boardCells) == 1) {
+                result = 1;
+            }
+        }
+        freeBoardCells(&boardCells);
+    }
+
+    start = now();
+    if (result == 0) {
+        result = runWorkStealing(threads, state.reader.totalBlocks, runQueryTask, &state);
+    }
+    elapsed = now() - start;
+
+    if (result == 0) {
+        for (uint32_t blockNumber = 0; blockNumber < state.reader.totalBlocks; blockNumber++) {
+            const blockResult *block = &state.results[blockNumber];
+
+            total.matches += block->matches;
+            total.mismatches += block->mismatches;
+            for (int outcome = 0; outcome < 3; outcome++) {
+                total.wins[outcome] += block->wins[outcome];
+            }
+            if (block->scanned) {
+                scanned++;
+                scannedBytes += state.reader.index[blockNumber].columnSize[ARCHIVE_CAPTURES];
+            }
+        }
+
+        printf("%s: board %ux%u, %lu games in %u blocks\n", fileName, state.reader.rows, state.reader.cols,
+               (unsigned long) state.reader.totalGames, state.reader.totalBlocks);
+        if (state.cell >= 0) {
+            printf("games with a pawn captured on cell %d after play %u: %ld\n", state.cell, state.afterPlay, total.matches);
+        } else {
+            printf("games with a pawn captured after play %u: %ld\n", state.afterPlay, total.matches);
+        }
+        printf("  P1 won %ld, P2 won %ld, unfinished %ld\n", total.wins[1], total.wins[2], total.wins[0]);
+        printf("blocks scanned %ld, skipped %ld, %lu bytes decoded, %.3f s, %.0f games/s\n", scanned,
+               (long) state.reader.totalBlocks - scanned, (unsigned long) scannedBytes, elapsed,
+               elapsed > 0 ? state.reader.totalGames / elapsed : 0.0);
+
+        if (state.listGames > 0) {
+            listGames(&state);
+        }
+
+        if (state.verify) {
+            printf("verify: %ld games do not match their replay\n", total.mismatches);
+            result = total.mismatches != 0;
+        }
+    }
+
+    for (int worker = 0; worker < threads && state.verify; worker++) {
+        freeBoardCells(&state.boards[worker]);
+    }
+    free(state.results);
+    free(state.games);
+    archiveReaderClose(&state.reader);
+
+    return result;
+}
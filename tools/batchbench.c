@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../batch.h"
+#include "../scheduler.h"
+
+/*
+    Compares the batched structure-of-arrays engine with the scalar engine:
+    both simulate the same games (same seeds), every game result must match,
+    and the throughput of each engine is reported in games per second.
+*/
+
+
+int main(int argc, char *argv[])
+{
+    unsigned int rows = 3, cols = 7;
+    long games = 100000;
+    uint64_t seed = 1;
+    safeCellSet safeCells;
+    simulationStats scalarStats = {0}, batchStats = {0};
+    gameResult *scalarResults, *batchResults;
+    double start, scalarTime, batchTime;
+    long mismatches = 0;
+    int option;
+
+    initializeSafeCells(&safeCells);
+    while ((option = getopt(argc, argv, "r:c:g:S:s:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'g':
+                games = strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            default:
+                freeSafeCells(&safeCells);
+                puts("Usage: batchbench [-r <lines>] [-c <columns>] [-g <games>] [-S <seed>] [-s <safe cells file>]");
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || games <= 0) {
+        puts(INVAL_PARAMS);
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    scalarResults = malloc(sizeof(gameResult) * games);
+    batchResults = malloc(sizeof(gameResult) * games);
+    if (scalarResults == NULL || batchResults == NULL) {
+        free(scalarResults);
+        free(batchResults);
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    start = now();
+    simulateGames(rows, cols, &safeCells, STANDARD_PAWNS, STANDARD_DICES, games, seed, &scalarStats, scalarResults, NULL);
+    scalarTime = now() - start;
+
+    start = now();
+    batchSimulateGames(rows, cols, &safeCells, games, seed, &batchStats, batchResults);
+    batchTime = now() - start;
+
+    for (long game = 0; game < games; game++) {
+        if (memcmp(&scalarResults[game], &batchResults[game], sizeof(gameResult)) != 0) {
+            if (mismatches++ < 10) {
+                printf("game %ld: scalar winner %d plays %d captures %d, batch winner %d plays %d captures %d\n", game,
+                       scalarResults[game].winner, scalarResults[game].plays, scalarResults[game].captures,
+                       batchResults[game].winner, batchResults[game].plays, batchResults[game].captures);
+            }
+        }
+    }
+
+    printf("board %ux%u, %ld games\n", rows, cols, games);
+    printf("scalar: %.0f games/s (%.3f s)\n", games / scalarTime, scalarTime);
+    printf("batch:  %.0f games/s (%.3f s), %.2fx\n", games / batchTime, batchTime, scalarTime / batchTime);
+    printf("mismatching games: %ld\n", mismatches);
+
+    free(scalarResults);
+    free(batchResults);
+    freeSafeCells(&safeCells);
+    return mismatches != 0;
+}
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../search.h"
+#include "../book.h"
+#include "../scheduler.h"
+
+/*
+    Opening book generator: plays random games from the initial position and
+    collects every distinct position of their first plies. For each position and
+    each dices value the best pawn is searched with Monte Carlo rollouts, in
+    parallel, and written to a book file that 'bookOpen' maps in memory.
+    The written book is then mapped and probed to check every entry.
+*/
+
+#define DICES_VALUES (MAX_DICES_VALUE - 1)  // Dices values from 2 to 12
+
+/**
+ * Position reached in the first plies of a game.
+ */
+typedef struct {
+    uint64_t key;  // Position key, without dices value
+    int pawnCells[2][4];  // Cell of each pawn
+    unsigned char winMask;  // Bit 'player * 4 + pawn' set if the pawn is WIN
+    bool player1;  // Whether it is player 1 to move
+} bookPosition;
+
+/**
+ * State shared by all search tasks.
+ */
+typedef struct {
+    const bookPosition *positions;
+    bookEntry *entries;  // 'DICES_VALUES' entries per position, pawn '\0' if not stored
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    int rollouts;
+    uint64_t seed;
+} bookState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: bookgen [-r <lines>] [-c <columns>] [-s <safe cells file>] [-p <plies>] [-g <games>]");
+    puts("               [-R <rollouts>] [-t <threads>] [-S <seed>] [-o <book file>]");
+    puts("  defaults: 3x7 board without safe cells, 4 plies of 2000 games, 64 rollouts per pawn, book.bin");
+}
+
+/**
+ * @brief Compares two positions by key (for 'qsort').
+ * @param first The first position
+ * @param second The second position
+ * @return Returns -1, 0 or 1
+ */
+static int comparePositions(const void *first, const void *second) {
+    uint64_t firstKey = ((const bookPosition *) first)->key;
+    uint64_t secondKey = ((const bookPosition *) second)->key;
+
+    return (firstKey > secondKey) - (firstKey < secondKey);
+}
+
+/**
+ * @brief Records the current position of a board.
+ * @param boardCells Board with all cells
+ * @param player1 Whether it is player 1 to move
+ * @param position Receives the position
+ */
+static void recordPosition(list *boardCells, bool player1, bookPosition *position) {
+    position->key = bookKey(boardCells, player1, 0);
+    position->player1 = player1;
+    position->winMask = 0;
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIdx = 0; pawnIdx < 4; pawnIdx++) {
+            int cellIndex = boardCells->pawnCells[player][pawnIdx];
+
+            position->pawnCells[player][pawnIdx] = cellIndex;
+            if (casaPawnState(boardCells->cells[cellIndex], player, pawnIdx) == WIN) {
+                position->winMask |= 1 << (player * 4 + pawnIdx);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Puts the pawns of a board in a recorded position.
+ * @param boardCells Board with all cells
+ * @param position The position
+ */
+static void placePosition(list *boardCells, const bookPosition *position) {
+    boardReset(boardCells);
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIdx = 0; pawnIdx < 4; pawnIdx++) {
+            int cellIndex = position->pawnCells[player][pawnIdx];
+            bool win = position->winMask & (1 << (player * 4 + pawnIdx));
+
+            casaSetPawnState(&boardCells->cells[boardCells->pawnCells[player][pawnIdx]], player, pawnIdx, FALSE);
+            casaSetPawnState(&boardCells->cells[cellIndex], player, pawnIdx, win ? WIN : TRUE);
+            boardCells->pawnCells[player][pawnIdx] = cellIndex;
+        }
+    }
+
+    assert(bookKey(boardCells, position->player1, 0) == position->key);
+}
+
+/**
+ * @brief Plays random games and collects the distinct positions of their first plies.
+ * @param boardCells Board in its initial position
+ * @param games Number of games
+ * @param plies Number of plies recorded per game
+ * @param seed Seed of the games, game 'n' is seeded with 'seed + n'
+ * @param positions Receives the positions (allocated, must be freed)
+ * @return Returns the number of distinct positions, -1 on 'FAILURE'
+ */
+static long collectPositions(list *boardCells, long games, int plies, uint64_t seed, bookPosition **positions) {
+    long totalPositions = 0;
+    long distinct = 0;
+
+    *positions = malloc(sizeof(bookPosition) * games * plies);
+    if (*positions == NULL) {
+        return -1;
+    }
+
+    for (long game = 0; game < games; game++) {
+        bool player1 = true;
+        rngState rng;
+
+        boardReset(boardCells);
+        rngSeed(&rng, seed + game);
+
+        for (int ply = 0; ply < plies && checkGameWin(boardCells, boardCells->length) == 0; ply++) {
+            int dicesValue;
+
+            recordPosition(boardCells, player1, &(*positions)[totalPositions++]);
+            dicesValue = rngRollDice(&rng, 2);
+            makePlay(boardCells, chooseRandomPawn(boardCells, player1, &rng), dicesValue);
+            player1 = !player1;
+        }
+    }
+
+    // Sorts the positions to drop the repeated ones
+    qsort(*positions, totalPositions, sizeof(bookPosition), comparePositions);
+    for (long position = 0; position < totalPositions; position++) {
+        if (distinct == 0 || (*positions)[position].key != (*positions)[distinct - 1].key) {
+            (*positions)[distinct++] = (*positions)[position];
+        }
+    }
+
+    boardReset(boardCells);
+    return distinct;
+}
+
+/**
+ * @brief Searches the best pawn of a position for every dices value.
+ * @param task The task id, the index of the position
+ * @param worker Index of the worker thread
+ * @param arg The book state
+ */
+static void searchPosition(long task, int worker, void *arg) {
+    bookState *state = arg;
+    const bookPosition *position = &state->positions[task];
+    list *boardCells = &state->boards[worker];
+
+    placePosition(boardCells, position);
+
+    for (int dicesValue = 2; dicesValue <= MAX_DICES_VALUE; dicesValue++) {
+        bookEntry *entry = &state->entries[task * DICES_VALUES + dicesValue - 2];
+        rngState rng;
+        double score;
+
+        rngSeed(&rng, state->seed + task * DICES_VALUES + dicesValue);
+        memset(entry, 0, sizeof(bookEntry));
+        entry->pawn = searchBestPawn(boardCells, position->player1, dicesValue, state->rollouts, &rng, &score);
+
+        // Positions with a single movable pawn need no book entry
+        if (score < 0) {
+            entry->pawn = '\0';
+        } else {
+            entry->key = bookKey(boardCells, position->player1, dicesValue);
+            entry->score = (uint16_t) (score * UINT16_MAX + 0.5);
+        }
+    }
+}
+
+/**
+ * @brief Maps the written book and checks every entry can be found.
+ * @param fileName The name of the book file
+ * @param boardCells Board the book was built for
+ * @param entries The written entries
+ * @param totalEntries Number of entries
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int verifyBook(const char *fileName, const list *boardCells, const bookEntry *entries, long totalEntries) {
+    openingBook book;
+    long misses = 0;
+    double start, elapsed;
+
+    if (bookOpen(fileName, boardCells, &book) == 1) {
+        fprintf(stderr, "Could not map %s\n", fileName);
+        return 1;
+    }
+
+    start = now();
+    for (long entry = 0; entry < totalEntries; entry++) {
+        const bookEntry *found = bookProbe(&book, entries[entry].key);
+
+        misses += found == NULL || found->pawn != entries[entry].pawn;
+    }
+    elapsed = now() - start;
+
+    printf("mapped %s (%zu bytes), %ld entries probed, %ld misses, %.0f probes/s\n", fileName, book.size,
+           totalEntries, misses, totalEntries / (elapsed > 0 ? elapsed : 1e-9));
+
+    bookClose(&book);
+    return misses != 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static bookState state;
+    unsigned int rows = 3, cols = 7;
+    int plies = 4;
+    long games = 2000;
+    int threads = availableCores();
+    const char *outputFile = "book.bin";
+    safeCellSet safeCells;
+    list boardCells;
+    bookPosition *positions = NULL;
+    long totalPositions;
+    long totalEntries = 0;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.rollouts = SEARCH_ROLLOUTS;
+    state.seed = 1;
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:p:g:R:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'p':
+                plies = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'g':
+                games = strtol(optarg, NULL, 10);
+                break;
+            case 'R':
+                state.rollouts = (int) strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || plies <= 0 ||
+        games <= 0 || state.rollouts <= 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalPositions = collectPositions(&boardCells, games, plies, state.seed, &positions);
+    state.positions = positions;
+    state.entries = totalPositions > 0 ? malloc(sizeof(bookEntry) * totalPositions * DICES_VALUES) : NULL;
+    if (state.entries == NULL) {
+        result = 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        if (result == 0 && boardClone(&state.boards[worker], &boardCells) == 1) {
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        result = runWorkStealing(threads, totalPositions, searchPosition, &state);
+    }
+
+    if (result == 0) {
+        // Keeps the entries that have a choice to make
+        for (long entry = 0; entry < totalPositions * DICES_VALUES; entry++) {
+            if (state.entries[entry].pawn != '\0') {
+                state.entries[totalEntries++] = state.entries[entry];
+            }
+        }
+
+        printf("board %ux%u, %ld games, %d plies: %ld positions, %ld book entries (%d rollouts per pawn)\n",
+               rows, cols, games, plies, totalPositions, totalEntries, state.rollouts);
+
+        if (bookWrite(outputFile, &boardCells, state.entries, totalEntries) == 1) {
+            fprintf(stderr, "Could not write %s\n", outputFile);
+            result = 1;
+        } else {
+            result = verifyBook(outputFile, &boardCells, state.entries, totalEntries);
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+    }
+    free(state.entries);
+    free(positions);
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
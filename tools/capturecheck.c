@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../reference.h"
+#include "../rng.h"
+#include "../simulate.h"
+#include "../scheduler.h"
+
+/*
+    Cross-check of the capture scan against the original capture logic: random
+    games on random board sizes are played on the optimised engine and, with
+    the same pawns and dices, on the reference engine with its original capture
+    rules ('refMakePlayOriginal', captures on every traversed cell, safe or not).
+    The only documented difference is that captures now skip safe cells, so the
+    captures and the whole board must match after every play, except for plays
+    that go through a safe cell (other than the adversary home) holding an
+    adversary pawn. Those plays are counted as rule fix plays and end the game,
+    since both boards differ from there on. Half of the games are played on
+    boards without safe cells, where every play is compared.
+*/
+
+#define GAMES_PER_TASK 256  // Games played by each task
+#define CHECK_MAX_CELLS 64  // Max number of cells of a generated board
+
+/**
+ * Counters of a worker thread.
+ */
+typedef struct {
+    long games;
+    long plays;  // Plays compared
+    long ruleFixPlays;  // Plays where the safe cell rule applies (not compared)
+    long captures;  // Captures of the plays compared
+} checkCounters;
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    long games;
+    uint64_t seed;
+    checkCounters counters[MAX_WORKERS];
+    atomic_int failed;  // Set by the first game where the engines differ
+    long failedGame;
+    int failedPlay;
+    const char *reason;
+} checkState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: capturecheck [-g <games>] [-t <threads>] [-S <seed>]");
+    puts("  compares the captures of the engine with the original capture logic, except where captures skip safe cells");
+    puts("  defaults: 100000 games on boards from 3x5 to 9x20, half of them without safe cells, seed 1");
+}
+
+/**
+ * @brief Converts the reference board to packed cells.
+ * @param boardCells The reference board
+ * @param cells Receives the cells
+ */
+static void referenceCells(refList *boardCells, casa *cells) {
+    refNode *currentNode = boardCells->head;
+
+    for (int cellIndex = 0; cellIndex < boardCells->length; cellIndex++) {
+        cells[cellIndex] = 0;
+        for (int player = 0; player < 2; player++) {
+            for (int pawnIndex = 0; pawnIndex < STANDARD_PAWNS; pawnIndex++) {
+                casaSetPawnState(&cells[cellIndex], player, pawnIndex, currentNode->item.jogador_peao[player][pawnIndex]);
+            }
+        }
+        casaSetSafe(&cells[cellIndex], currentNode->item.casaSegura ? TRUE : FALSE);
+        currentNode = currentNode->next;
+    }
+}
+
+/**
+ * @brief Checks whether the safe cell rule applies to a play: the pawn goes
+ * through a safe cell, other than the adversary home, holding an adversary pawn.
+ * Must be called before the play.
+ * @param boardCells Board with all cells
+ * @param pawn The given pawn
+ * @param amount The amount of cells the pawn should advance (based on dices value)
+ * @return Returns whether the original capture logic would capture a safe pawn
+ */
+static bool capturesSafePawn(list *boardCells, char pawn, int amount) {
+    int adversary = 1 - getPawnPlayer(pawn);
+    int adversaryHome = adversary * (boardCells->length / 2);
+    int pathCells[MAX_PLAY_AMOUNT];
+    int totalPathCells = getPlayPath(boardCells, pawn, amount, pathCells);
+
+    for (int i = 0; i < totalPathCells; i++) {
+        casa cell = boardCells->cells[pathCells[i]];
+
+        if (pathCells[i] != adversaryHome && casaIsSafe(cell) == TRUE && (cell & CASA_PLAYER_PAWNS(adversary)) != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Plays a random game on both engines, comparing them after every play.
+ * @param state The check state
+ * @param game The game number, seeds the board and the plays
+ * @param counters Counters of the worker thread
+ * @param failedPlay Receives the play where the engines differ
+ * @param reason Receives what differs
+ * @return Returns 1 if the engines differ, 0 if they match and -1 if a board could not be allocated
+ */
+static int checkGame(checkState *state, long game, checkCounters *counters, int *failedPlay, const char **reason) {
+    unsigned char isSafe[CHECK_MAX_CELLS] = {0};
+    casa refCells[CHECK_MAX_CELLS];
+    safeCellSet safeCells;
+    list boardCells;
+    refList refBoardCells;
+    bool player1 = true;
+    int rows, cols, safeDensity, totalCells;
+    int result = 0;
+    rngState rng;
+
+    rngSeed(&rng, state->seed + (uint64_t) game);
+
+    // Boards from 3x5 to 9x20, so both the specialised and the generic play kernels are used
+    rows = 3 + 2 * rngRange(&rng, 4);
+    cols = 5 + rngRange(&rng, 16);
+    totalCells = rows * 2 + (cols - 2) * 2;
+    safeDensity = game % 2 == 0 ? 0 : 1 + rngRange(&rng, 3);  // Out of 8
+    for (int cellIndex = 1; cellIndex < totalCells; cellIndex++) {
+        isSafe[cellIndex] = rngRange(&rng, 8) < safeDensity;
+    }
+    safeCells = (safeCellSet) {isSafe, totalCells, NULL};
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeBoardCells(&boardCells);
+        return -1;
+    }
+    refInitializeCellsList(&refBoardCells);
+    if (refBoardSetup(&refBoardCells, &safeCells, totalCells) == 1) {
+        freeBoardCells(&boardCells);
+        refFreeBoardCells(&refBoardCells);
+        return -1;
+    }
+
+    for (int play = 0; play < SIMULATION_MAX_PLAYS && checkGameWin(&boardCells, totalCells) == 0; play++) {
+        int dicesValue = rngRollDice(&rng, STANDARD_DICES);
+        char pawn = chooseRandomPawn(&boardCells, player1, &rng);
+        int captures, refCaptures;
+
+        if (capturesSafePawn(&boardCells, pawn, dicesValue)) {
+            counters->ruleFixPlays++;
+            break;
+        }
+
+        captures = makePlay(&boardCells, pawn, dicesValue);
+        refCaptures = refMakePlayOriginal(&refBoardCells, pawn, dicesValue);
+        referenceCells(&refBoardCells, refCells);
+        counters->plays++;
+        counters->captures += captures;
+
+        *failedPlay = play;
+        if (captures != refCaptures) {
+            *reason = "captures differ";
+            result = 1;
+            break;
+        }
+        if (memcmp(boardCells.cells, refCells, sizeof(casa) * totalCells) != 0) {
+            *reason = "board state differs";
+            result = 1;
+            break;
+        }
+        player1 = !player1;
+    }
+
+    counters->games++;
+    freeBoardCells(&boardCells);
+    refFreeBoardCells(&refBoardCells);
+    return result;
+}
+
+/**
+ * @brief Runs a task: plays and compares a range of games.
+ * @param task The task id, identifies the range of games
+ * @param worker Index of the worker thread
+ * @param arg The check state
+ */
+static void runCheckTask(long task, int worker, void *arg) {
+    checkState *state = arg;
+    long firstGame = task * GAMES_PER_TASK;
+    long lastGame = firstGame + GAMES_PER_TASK < state->games ? firstGame + GAMES_PER_TASK : state->games;
+
+    for (long game = firstGame; game < lastGame && !atomic_load(&state->failed); game++) {
+        const char *reason = "a board could not be allocated";
+        int failedPlay = -1;
+
+        // Keeps the first failing game, the other tasks stop at their next game
+        if (checkGame(state, game, &state->counters[worker], &failedPlay, &reason) != 0 &&
+            atomic_exchange(&state->failed, 1) == 0) {
+            state->failedGame = game;
+            state->failedPlay = failedPlay;
+            state->reason = reason;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static checkState state;
+    int threads = availableCores();
+    checkCounters total = {0};
+    int option;
+
+    state.games = 100000;
+    state.seed = 1;
+
+    while ((option = getopt(argc, argv, "g:t:S:h")) != -1) {
+        switch (option) {
+            case 'g':
+                state.games = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                return 1;
+        }
+    }
+
+    if (state.games < 1 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        return 1;
+    }
+
+    if (runWorkStealing(threads, (state.games + GAMES_PER_TASK - 1) / GAMES_PER_TASK, runCheckTask, &state) == 1) {
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        total.games += state.counters[worker].games;
+        total.plays += state.counters[worker].plays;
+        total.ruleFixPlays += state.counters[worker].ruleFixPlays;
+        total.captures += state.counters[worker].captures;
+    }
+
+    printf("%ld games, %ld plays compared (%ld captures), %ld games ended at a play where captures skip safe cells\n",
+           total.games, total.plays, total.captures, total.ruleFixPlays);
+
+    if (atomic_load(&state.failed)) {
+        printf("%s in game %ld (seed %llu), play %d\n", state.reason, state.failedGame,
+               (unsigned long long) (state.seed + state.failedGame), state.failedPlay + 1);
+        return 1;
+    }
+
+    puts("no mismatches");
+    return 0;
+}
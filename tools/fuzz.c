@@ -0,0 +1,608 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../reference.h"
+#include "../rng.h"
+#include "../scheduler.h"
+
+/*
+    Differential fuzzer: generates random positions (board size, safe cells and
+    pawn placement) and random dice/pawn sequences, plays them on the frozen
+    linked-list reference engine ('reference.c') and on the optimised engine,
+    and compares the captures and the full board state after every move.
+    The first mismatching case is minimised to a short reproducer.
+    Each engine also plays every case on its own, timed, to compare throughput.
+*/
+
+#define FUZZ_MAX_CELLS 64  // Max number of cells of a generated board
+#define FUZZ_MAX_MOVES 1024  // Max number of moves of a case
+#define FUZZ_WIN -1  // Pawn position of a WIN pawn
+
+/**
+ * A pawn move, pawn letter and dices value.
+ */
+typedef struct {
+    char pawn;
+    int amount;
+} fuzzMove;
+
+/**
+ * A fuzz case: starting position and the moves played from it.
+ */
+typedef struct {
+    unsigned int rows;
+    unsigned int cols;
+    int totalCells;
+    unsigned char isSafe[FUZZ_MAX_CELLS];  // Safe cells besides the home cells
+    int pawnCells[2][4];  // Cell of each pawn, 'FUZZ_WIN' if the pawn is WIN
+    int moves;
+    fuzzMove move[FUZZ_MAX_MOVES];
+} fuzzCase;
+
+/**
+ * Mismatch found by 'compareCase'.
+ */
+typedef struct {
+    int move;  // Index of the move after which the engines differ
+    int captures[2];  // Pawns captured in that move by the engine and by the reference
+    casa cells[2][FUZZ_MAX_CELLS];  // Board state of the engine and of the reference
+    const char *reason;
+} fuzzMismatch;
+
+/**
+ * Counters of a worker thread.
+ */
+typedef struct {
+    long cases;
+    long moves;  // Moves played by each engine
+    double engineTime;  // Seconds spent by the optimised engine
+    double referenceTime;  // Seconds spent by the reference engine
+} fuzzCounters;
+
+/**
+ * State shared by all fuzz tasks.
+ */
+typedef struct {
+    long cases;
+    long casesPerTask;
+    int maxMoves;
+    uint64_t seed;
+    fuzzCounters counters[MAX_WORKERS];
+    atomic_int failed;  // Set by the first task that finds a mismatch
+    long failedCase;
+    fuzzCase failure;  // The failing case, as generated
+} fuzzState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: fuzz [-n <cases>] [-m <moves per case>] [-b <cases per task>] [-t <threads>] [-S <seed>]");
+    puts("  defaults: 100000 cases of 200 moves, tasks of 1000 cases, one thread per core");
+}
+
+/**
+ * @brief Generates a random fuzz case.
+ * @param rng The generator state
+ * @param fuzz Receives the case
+ * @param moves Number of moves of the case
+ */
+static void generateCase(rngState *rng, fuzzCase *fuzz, int moves) {
+    int safeDensity = rngRange(rng, 4);  // Out of 8, from no safe cells to 3 in 8
+    int player = rngRange(rng, 2);
+
+    // Boards from 3x5 to 9x20, so both the specialised and the generic play kernels are used
+    fuzz->rows = 3 + 2 * rngRange(rng, 4);
+    fuzz->cols = 5 + rngRange(rng, 16);
+    fuzz->totalCells = fuzz->rows * 2 + (fuzz->cols - 2) * 2;
+
+    memset(fuzz->isSafe, 0, sizeof(fuzz->isSafe));
+    for (int cellIndex = 1; cellIndex < fuzz->totalCells; cellIndex++) {
+        fuzz->isSafe[cellIndex] = rngRange(rng, 8) < safeDensity;
+    }
+
+    // Pawns are WIN, at home or anywhere on the board
+    for (int playerIndex = 0; playerIndex < 2; playerIndex++) {
+        for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+            int kind = rngRange(rng, 8);
+
+            if (kind == 0) {
+                fuzz->pawnCells[playerIndex][pawnIndex] = FUZZ_WIN;
+            } else if (kind <= 2) {
+                fuzz->pawnCells[playerIndex][pawnIndex] = playerIndex * (fuzz->totalCells / 2);
+            } else {
+                fuzz->pawnCells[playerIndex][pawnIndex] = rngRange(rng, fuzz->totalCells);
+            }
+        }
+    }
+
+    // Players take turns, each move with any pawn of the player (unmovable pawns are skipped)
+    fuzz->moves = moves;
+    for (int moveIndex = 0; moveIndex < moves; moveIndex++) {
+        fuzz->move[moveIndex].pawn = (player == 0 ? SYMBOLS_J1 : SYMBOLS_J2)[1 + rngRange(rng, 4)];
+        fuzz->move[moveIndex].amount = rngRollDice(rng, 2);
+        player ^= 1;
+    }
+}
+
+/**
+ * @brief Sets up the optimised engine board with the case starting position.
+ * @param boardCells Receives the board
+ * @param fuzz The case
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int setupEngine(list *boardCells, const fuzzCase *fuzz) {
+    safeCellSet safeCells = {(unsigned char *) fuzz->isSafe, fuzz->totalCells, NULL};
+    int homes[2] = {0, fuzz->totalCells / 2};
+
+    initializeCellsList(boardCells);
+    if (boardSetup(boardCells, &safeCells, fuzz->totalCells) == 1) {
+        return 1;
+    }
+
+    for (int cellIndex = 0; cellIndex < fuzz->totalCells; cellIndex++) {
+        boardCells->cells[cellIndex] &= CASA_SAFE;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+            int cellIndex = fuzz->pawnCells[player][pawnIndex];
+
+            if (cellIndex == FUZZ_WIN) {
+                casaSetPawnState(&boardCells->cells[homes[player]], player, pawnIndex, WIN);
+                boardCells->pawnCells[player][pawnIndex] = homes[player];
+            } else {
+                casaSetPawnState(&boardCells->cells[cellIndex], player, pawnIndex, TRUE);
+                boardCells->pawnCells[player][pawnIndex] = cellIndex;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sets up the reference engine board with the case starting position.
+ * @param boardCells Receives the board
+ * @param fuzz The case
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int setupReference(refList *boardCells, const fuzzCase *fuzz) {
+    safeCellSet safeCells = {(unsigned char *) fuzz->isSafe, fuzz->totalCells, NULL};
+    int homes[2] = {0, fuzz->totalCells / 2};
+    refNode *currentNode;
+
+    refInitializeCellsList(boardCells);
+    if (refBoardSetup(boardCells, &safeCells, fuzz->totalCells) == 1) {
+        refFreeBoardCells(boardCells);
+        return 1;
+    }
+
+    currentNode = boardCells->head;
+    for (int cellIndex = 0; cellIndex < fuzz->totalCells; cellIndex++) {
+        for (int player = 0; player < 2; player++) {
+            for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+                int pawnCell = fuzz->pawnCells[player][pawnIndex];
+
+                if (pawnCell == FUZZ_WIN && cellIndex == homes[player]) {
+                    currentNode->item.jogador_peao[player][pawnIndex] = WIN;
+                } else {
+                    currentNode->item.jogador_peao[player][pawnIndex] = pawnCell == cellIndex ? TRUE : FALSE;
+                }
+            }
+        }
+        currentNode = currentNode->next;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Converts the reference board to packed cells.
+ * @param boardCells The reference board
+ * @param cells Receives the cells
+ */
+static void referenceCells(refList *boardCells, casa *cells) {
+    refNode *currentNode = boardCells->head;
+
+    for (int cellIndex = 0; cellIndex < boardCells->length; cellIndex++) {
+        cells[cellIndex] = 0;
+        for (int player = 0; player < 2; player++) {
+            for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+                casaSetPawnState(&cells[cellIndex], player, pawnIndex, currentNode->item.jogador_peao[player][pawnIndex]);
+            }
+        }
+        casaSetSafe(&cells[cellIndex], currentNode->item.casaSegura ? TRUE : FALSE);
+        currentNode = currentNode->next;
+    }
+}
+
+/**
+ * @brief Checks that the pawn position index of the optimised engine matches its cells.
+ * @param boardCells The optimised engine board
+ * @return Returns whether the index is consistent
+ */
+static bool pawnIndexConsistent(list *boardCells) {
+    int homes[2] = {0, boardCells->length / 2};
+
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+            int cellIndex = boardCells->pawnCells[player][pawnIndex];
+            state pawnState;
+
+            if (cellIndex < 0 || cellIndex >= boardCells->length) {
+                return false;
+            }
+
+            pawnState = casaPawnState(boardCells->cells[cellIndex], player, pawnIndex);
+            if (pawnState == FALSE || (pawnState == WIN && cellIndex != homes[player])) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Plays a case on both engines, comparing them after every move.
+ * @param fuzz The case
+ * @param mismatch Receives the first mismatch (can be NULL)
+ * @return Returns 1 if the engines differ, 0 if they match and -1 if a board could not be allocated
+ */
+static int compareCase(const fuzzCase *fuzz, fuzzMismatch *mismatch) {
+    static const fuzzMismatch noMismatch;
+    fuzzMismatch found = noMismatch;
+    list boardCells;
+    refList refBoardCells;
+    int result = 0;
+
+    if (setupEngine(&boardCells, fuzz) == 1) {
+        freeBoardCells(&boardCells);
+        return -1;
+    }
+    if (setupReference(&refBoardCells, fuzz) == 1) {
+        freeBoardCells(&boardCells);
+        return -1;
+    }
+
+    found.move = -1;
+    for (int moveIndex = 0; moveIndex < fuzz->moves && result == 0; moveIndex++) {
+        char pawn = fuzz->move[moveIndex].pawn;
+        bool player1 = validPawn(pawn, true);
+        int winner = checkGameWin(&boardCells, fuzz->totalCells);
+        bool movable;
+
+        found.move = moveIndex;
+        if (winner != refCheckGameWin(&refBoardCells, fuzz->totalCells)) {
+            found.reason = "checkGameWin differs";
+            result = 1;
+            break;
+        }
+        if (winner != 0) {
+            break;
+        }
+
+        movable = isPawnMovable(pawn, &boardCells, player1);
+        if (movable != refIsPawnMovable(pawn, &refBoardCells, player1)) {
+            found.reason = "isPawnMovable differs";
+            result = 1;
+            break;
+        }
+        if (!movable) {
+            continue;
+        }
+
+        found.captures[0] = makePlay(&boardCells, pawn, fuzz->move[moveIndex].amount);
+        found.captures[1] = refMakePlay(&refBoardCells, pawn, fuzz->move[moveIndex].amount);
+        memcpy(found.cells[0], boardCells.cells, sizeof(casa) * fuzz->totalCells);
+        referenceCells(&refBoardCells, found.cells[1]);
+
+        if (found.captures[0] != found.captures[1]) {
+            found.reason = "captures differ";
+            result = 1;
+        } else if (memcmp(found.cells[0], found.cells[1], sizeof(casa) * fuzz->totalCells) != 0) {
+            found.reason = "board state differs";
+            result = 1;
+        } else if (!pawnIndexConsistent(&boardCells)) {
+            found.reason = "pawn position index does not match the cells";
+            result = 1;
+        }
+    }
+
+    if (mismatch != NULL) {
+        *mismatch = found;
+    }
+
+    freeBoardCells(&boardCells);
+    refFreeBoardCells(&refBoardCells);
+    return result;
+}
+
+/**
+ * @brief Plays a case on the optimised engine only.
+ * @param fuzz The case
+ * @return Returns the number of moves played, -1 if the board could not be allocated
+ */
+static long playEngine(const fuzzCase *fuzz) {
+    list boardCells;
+    long played = 0;
+
+    if (setupEngine(&boardCells, fuzz) == 1) {
+        freeBoardCells(&boardCells);
+        return -1;
+    }
+
+    for (int moveIndex = 0; moveIndex < fuzz->moves; moveIndex++) {
+        char pawn = fuzz->move[moveIndex].pawn;
+
+        if (checkGameWin(&boardCells, fuzz->totalCells) != 0) {
+            break;
+        }
+        if (isPawnMovable(pawn, &boardCells, validPawn(pawn, true))) {
+            makePlay(&boardCells, pawn, fuzz->move[moveIndex].amount);
+            played++;
+        }
+    }
+
+    freeBoardCells(&boardCells);
+    return played;
+}
+
+/**
+ * @brief Plays a case on the reference engine only.
+ * @param fuzz The case
+ * @return Returns the number of moves played, -1 if the board could not be allocated
+ */
+static long playReference(const fuzzCase *fuzz) {
+    refList boardCells;
+    long played = 0;
+
+    if (setupReference(&boardCells, fuzz) == 1) {
+        return -1;
+    }
+
+    for (int moveIndex = 0; moveIndex < fuzz->moves; moveIndex++) {
+        char pawn = fuzz->move[moveIndex].pawn;
+
+        if (refCheckGameWin(&boardCells, fuzz->totalCells) != 0) {
+            break;
+        }
+        if (refIsPawnMovable(pawn, &boardCells, validPawn(pawn, true))) {
+            refMakePlay(&boardCells, pawn, fuzz->move[moveIndex].amount);
+            played++;
+        }
+    }
+
+    refFreeBoardCells(&boardCells);
+    return played;
+}
+
+/**
+ * @brief Runs a task: generates, times and compares a range of cases.
+ * @param task The task id, identifies the range of cases
+ * @param worker Index of the worker thread
+ * @param arg The fuzz state
+ */
+static void runFuzzTask(long task, int worker, void *arg) {
+    fuzzState *state = arg;
+    fuzzCounters *counters = &state->counters[worker];
+    long firstCase = task * state->casesPerTask;
+    long lastCase = firstCase + state->casesPerTask < state->cases ? firstCase + state->casesPerTask : state->cases;
+    fuzzCase fuzz;
+
+    for (long caseIndex = firstCase; caseIndex < lastCase && !atomic_load(&state->failed); caseIndex++) {
+        rngState rng;
+        double start;
+        long played;
+
+        rngSeed(&rng, state->seed + caseIndex);
+        generateCase(&rng, &fuzz, state->maxMoves);
+
+        start = now();
+        played = playEngine(&fuzz);
+        counters->engineTime += now() - start;
+
+        start = now();
+        if (playReference(&fuzz) != played) {
+            played = -1;
+        }
+        counters->referenceTime += now() - start;
+
+        counters->cases++;
+        counters->moves += played > 0 ? played : 0;
+
+        // Keeps the first failing case, the other tasks stop at their next case
+        if ((played < 0 || compareCase(&fuzz, NULL) != 0) && atomic_exchange(&state->failed, 1) == 0) {
+            state->failedCase = caseIndex;
+            state->failure = fuzz;
+        }
+    }
+}
+
+/**
+ * @brief Shrinks a failing case: drops moves, sends pawns home and removes
+ * safe cells while the engines still differ, until nothing else can be removed.
+ * @param fuzz The failing case, replaced by the minimised case
+ */
+static void minimiseCase(fuzzCase *fuzz) {
+    static fuzzCase candidate;
+    fuzzMismatch mismatch;
+    bool changed = true;
+
+    if (compareCase(fuzz, &mismatch) != 1) {
+        return;
+    }
+    fuzz->moves = mismatch.move + 1;
+
+    while (changed) {
+        changed = false;
+
+        // Drops single moves, last ones first
+        for (int moveIndex = fuzz->moves - 1; moveIndex >= 0; moveIndex--) {
+            candidate = *fuzz;
+            memmove(&candidate.move[moveIndex], &candidate.move[moveIndex + 1], sizeof(fuzzMove) * (candidate.moves - moveIndex - 1));
+            candidate.moves--;
+
+            if (compareCase(&candidate, &mismatch) == 1) {
+                candidate.moves = mismatch.move + 1;
+                *fuzz = candidate;
+                changed = true;
+            }
+        }
+
+        // Sends pawns back to their home cell
+        for (int player = 0; player < 2; player++) {
+            for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+                int home = player * (fuzz->totalCells / 2);
+
+                if (fuzz->pawnCells[player][pawnIndex] == home) {
+                    continue;
+                }
+
+                candidate = *fuzz;
+                candidate.pawnCells[player][pawnIndex] = home;
+                if (compareCase(&candidate, NULL) == 1) {
+                    *fuzz = candidate;
+                    changed = true;
+                }
+            }
+        }
+
+        // Removes safe cells
+        for (int cellIndex = 0; cellIndex < fuzz->totalCells; cellIndex++) {
+            if (!fuzz->isSafe[cellIndex]) {
+                continue;
+            }
+
+            candidate = *fuzz;
+            candidate.isSafe[cellIndex] = 0;
+            if (compareCase(&candidate, NULL) == 1) {
+                *fuzz = candidate;
+                changed = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Prints a failing case and the state of both engines after the failing move.
+ * @param fuzz The minimised case
+ */
+static void printReproducer(const fuzzCase *fuzz) {
+    static fuzzMismatch mismatch;
+
+    compareCase(fuzz, &mismatch);
+
+    printf("board %ux%u (%d cells)\n", fuzz->rows, fuzz->cols, fuzz->totalCells);
+
+    printf("safe cells:");
+    for (int cellIndex = 0; cellIndex < fuzz->totalCells; cellIndex++) {
+        if (fuzz->isSafe[cellIndex]) {
+            printf(" %d", cellIndex);
+        }
+    }
+
+    printf("\npawns:");
+    for (int player = 0; player < 2; player++) {
+        for (int pawnIndex = 0; pawnIndex < 4; pawnIndex++) {
+            char pawn = (player == 0 ? SYMBOLS_J1 : SYMBOLS_J2)[1 + pawnIndex];
+
+            if (fuzz->pawnCells[player][pawnIndex] == FUZZ_WIN) {
+                printf(" %c=WIN", pawn);
+            } else {
+                printf(" %c=%d", pawn, fuzz->pawnCells[player][pawnIndex]);
+            }
+        }
+    }
+
+    printf("\nmoves:");
+    for (int moveIndex = 0; moveIndex < fuzz->moves; moveIndex++) {
+        printf(" %c%d", fuzz->move[moveIndex].pawn, fuzz->move[moveIndex].amount);
+    }
+
+    printf("\n%s after move %d\n", mismatch.reason, mismatch.move + 1);
+    printf("captures: engine %d, reference %d\n", mismatch.captures[0], mismatch.captures[1]);
+    for (int cellIndex = 0; cellIndex < fuzz->totalCells; cellIndex++) {
+        if (mismatch.cells[0][cellIndex] != mismatch.cells[1][cellIndex]) {
+            printf("cell %d: engine 0x%05x, reference 0x%05x\n", cellIndex, mismatch.cells[0][cellIndex],
+                   mismatch.cells[1][cellIndex]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static fuzzState state;
+    int threads = availableCores();
+    fuzzCounters total = {0};
+    int option;
+
+    state.cases = 100000;
+    state.casesPerTask = 1000;
+    state.maxMoves = 200;
+    state.seed = 1;
+
+    while ((option = getopt(argc, argv, "n:m:b:t:S:h")) != -1) {
+        switch (option) {
+            case 'n':
+                state.cases = strtol(optarg, NULL, 10);
+                break;
+            case 'm':
+                state.maxMoves = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                state.casesPerTask = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                return 1;
+        }
+    }
+
+    if (state.cases <= 0 || state.casesPerTask <= 0 || state.maxMoves <= 0 || state.maxMoves > FUZZ_MAX_MOVES ||
+        threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        return 1;
+    }
+
+    if (runWorkStealing(threads, (state.cases + state.casesPerTask - 1) / state.casesPerTask, runFuzzTask, &state) == 1) {
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        total.cases += state.counters[worker].cases;
+        total.moves += state.counters[worker].moves;
+        total.engineTime += state.counters[worker].engineTime;
+        total.referenceTime += state.counters[worker].referenceTime;
+    }
+
+    printf("%ld cases, %ld moves per engine, %d threads\n", total.cases, total.moves, threads);
+    printf("reference: %.0f moves/s per thread (%.3f s)\n", total.moves / total.referenceTime, total.referenceTime);
+    printf("engine:    %.0f moves/s per thread (%.3f s), %.2fx\n", total.moves / total.engineTime, total.engineTime,
+           total.referenceTime / total.engineTime);
+
+    if (atomic_load(&state.failed)) {
+        printf("\nmismatch in case %ld (seed %llu), minimised reproducer:\n", state.failedCase,
+               (unsigned long long) (state.seed + state.failedCase));
+        minimiseCase(&state.failure);
+        printReproducer(&state.failure);
+        return 1;
+    }
+
+    puts("no mismatches");
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../heatmap.h"
+#include "../scheduler.h"
+
+/*
+    Capture and traffic analytics: simulates random games on one board
+    configuration and counts, per cell, the plays that land on it or pass
+    through it, the pawns captured on it and the pawns that were safe on it.
+    Each worker thread has its own heatmap, merged when all games are finished.
+*/
+
+/**
+ * State shared by all heatmap tasks.
+ */
+typedef struct {
+    unsigned int rows;
+    unsigned int cols;
+    const safeCellSet *safeCells;
+    long games;
+    long batchSize;  // Number of games per batch
+    uint64_t seed;
+    heatmap traffic[MAX_WORKERS];  // Counters of each worker thread
+} heatmapState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: heatmap [-r <lines>] [-c <columns>] [-s <safe cells file>] [-g <games>] [-b <batch size>]");
+    puts("               [-t <threads>] [-S <seed>] [-o <output.csv>]");
+    puts("  defaults: 3x7 board without safe cells, 10000 games, batches of 100 games, one thread per core");
+}
+
+/**
+ * @brief Runs a batch of games, recording them in the worker heatmap.
+ * @param task The task id, identifies the batch
+ * @param worker Index of the worker thread
+ * @param arg The heatmap state
+ */
+static void runHeatmapBatch(long task, int worker, void *arg) {
+    heatmapState *state = arg;
+    long firstGame = task * state->batchSize;
+    long games = state->games - firstGame < state->batchSize ? state->games - firstGame : state->batchSize;
+    simulationStats stats = {0};
+
+    simulateGames(state->rows, state->cols, state->safeCells, STANDARD_PAWNS, STANDARD_DICES, games, state->seed + firstGame, &stats, NULL,
+                  &state->traffic[worker]);
+}
+
+int main(int argc, char *argv[])
+{
+    static heatmapState state;
+    safeCellSet safeCells;
+    int threads = availableCores();
+    const char *outputFile = NULL;
+    FILE *output;
+    list boardCells;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.rows = 3;
+    state.cols = 7;
+    state.games = 10000;
+    state.batchSize = 100;
+    state.seed = 1;
+    state.safeCells = &safeCells;
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:g:b:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                state.rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                state.cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'g':
+                state.games = strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                state.batchSize = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(state.rows, state.cols) ||
+        state.games <= 0 || state.batchSize <= 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = state.rows * 2 + (state.cols - 2) * 2;
+
+    // Board used for the safe cells of the rendered heatmap
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        if (heatmapInit(&state.traffic[worker], totalCells) == 1) {
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        result = runWorkStealing(threads, (state.games + state.batchSize - 1) / state.batchSize, runHeatmapBatch, &state);
+    }
+
+    if (result == 0) {
+        // Merges the counters of every worker
+        for (int worker = 1; worker < threads; worker++) {
+            heatmapMerge(&state.traffic[0], &state.traffic[worker]);
+        }
+
+        printf("board %ux%u, %ld games, %ld plays\n", state.rows, state.cols, state.games, state.traffic[0].plays);
+        heatmapPrint(state.rows, state.cols, &state.traffic[0], &boardCells);
+
+        if (outputFile != NULL) {
+            output = fopen(outputFile, "w");
+            if (output != NULL) {
+                heatmapWriteCsv(output, &state.traffic[0], &boardCells);
+                fclose(output);
+            } else {
+                fprintf(stderr, "Could not open %s\n", outputFile);
+                result = 1;
+            }
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        heatmapFree(&state.traffic[worker]);
+    }
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
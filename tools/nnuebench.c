@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../nnue.h"
+#include "../scheduler.h"
+
+/*
+    Measures the network evaluation speed with and without incremental
+    updates. The same random games (game n seeded with seed + n) are played
+    three times on all cores: only making the plays, evaluating every
+    position with an accumulator updated by 'nnuePlay', and evaluating every
+    position with an accumulator computed from scratch by 'nnueRefresh'. The
+    time of the first pass is taken out of the others, so the evals/s only
+    count the evaluation work. Both evaluations must give the same output on
+    every position (compared through a checksum per game).
+*/
+
+#define GAMES_PER_TASK 64  // Games played by each task
+
+/**
+ * How the positions of a pass are evaluated.
+ */
+typedef enum {PLAYS_ONLY = 0, INCREMENTAL = 1, REFRESH = 2} benchMode;
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    nnueNetwork network;
+    benchMode mode;
+    long games;
+    uint64_t seed;
+    uint64_t *checksums[3];  // Checksum of the outputs of each game, per mode
+    long *plays;  // Plays of each game
+    list boards[MAX_WORKERS];  // Board of each worker thread
+} benchState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: nnuebench [-r <lines>] [-c <columns>] [-s <safe cells file>] [-w <weights file>] [-g <games>] [-t <threads>] [-S <seed>]");
+    puts("  evals/s of the network with incremental updates and with the accumulator computed from scratch");
+    puts("  defaults: 3x7 board without safe cells, network with random weights (from the seed), 20000 games, seed 1");
+}
+
+/**
+ * @brief Plays a range of random games and evaluates their positions.
+ * @param task The task id, identifies the range of games
+ * @param worker Index of the worker thread
+ * @param arg The benchmark state
+ */
+static void runBenchTask(long task, int worker, void *arg) {
+    benchState *state = arg;
+    list *boardCells = &state->boards[worker];
+    long firstGame = task * GAMES_PER_TASK;
+    long lastGame = firstGame + GAMES_PER_TASK < state->games ? firstGame + GAMES_PER_TASK : state->games;
+    nnueAccumulator accumulator;
+
+    for (long game = firstGame; game < lastGame; game++) {
+        uint64_t checksum = 0;
+        bool player1 = true;
+        long plays = 0;
+        rngState rng;
+
+        rngSeed(&rng, state->seed + (uint64_t) game);
+        boardReset(boardCells);
+        if (state->mode == INCREMENTAL) {
+            nnueRefresh(&state->network, boardCells, &accumulator);
+        }
+
+        while (plays < SIMULATION_MAX_PLAYS && checkGameWin(boardCells, boardCells->length) == 0) {
+            int dicesValue = rngRollDice(&rng, STANDARD_DICES);
+            char pawn = chooseRandomPawn(boardCells, player1, &rng);
+
+            switch (state->mode) {
+                case PLAYS_ONLY:
+                    makePlay(boardCells, pawn, dicesValue);
+                    break;
+                case INCREMENTAL:
+                    nnuePlay(&state->network, &accumulator, boardCells, pawn, dicesValue);
+                    checksum = checksum * 31 + (uint32_t) nnueOutput(&state->network, &accumulator);
+                    break;
+                case REFRESH:
+                    makePlay(boardCells, pawn, dicesValue);
+                    nnueRefresh(&state->network, boardCells, &accumulator);
+                    checksum = checksum * 31 + (uint32_t) nnueOutput(&state->network, &accumulator);
+                    break;
+            }
+            player1 = !player1;
+            plays++;
+        }
+
+        state->checksums[state->mode][game] = checksum;
+        state->plays[game] = plays;
+    }
+}
+
+/**
+ * @brief Runs a pass over all the games.
+ * @param state The benchmark state
+ * @param threads Number of worker threads
+ * @param mode How the positions are evaluated
+ * @param elapsed Receives the time of the pass in seconds
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int runPass(benchState *state, int threads, benchMode mode, double *elapsed) {
+    double start = now();
+    int result;
+
+    state->mode = mode;
+    result = runWorkStealing(threads, (state->games + GAMES_PER_TASK - 1) / GAMES_PER_TASK, runBenchTask, state);
+    *elapsed = now() - start;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    static benchState state;
+    unsigned int rows = 3, cols = 7;
+    int threads = availableCores();
+    const char *weightsFile = NULL;
+    safeCellSet safeCells;
+    list boardCells;
+    double times[3];
+    long evaluations = 0, mismatches = 0;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.games = 20000;
+    state.seed = 1;
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:w:g:t:S:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'w':
+                weightsFile = optarg;
+                break;
+            case 'g':
+                state.games = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || state.games < 1 ||
+        threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    if (weightsFile != NULL) {
+        if (nnueLoad(weightsFile, &state.network) == 1 || state.network.totalCells != totalCells) {
+            fprintf(stderr, "nnuebench: %s is missing or is not a weights file of a %ux%u board\n", weightsFile, rows, cols);
+            nnueNetworkFree(&state.network);
+            freeSafeCells(&safeCells);
+            return 1;
+        }
+    } else {
+        nnueModel model;
+        rngState rng;
+
+        rngSeed(&rng, state.seed);
+        if (nnueModelInit(&model, totalCells, &rng) == 1 || nnueNetworkInit(&state.network, totalCells) == 1) {
+            nnueModelFree(&model);
+            nnueNetworkFree(&state.network);
+            freeSafeCells(&safeCells);
+            return 1;
+        }
+        nnueQuantize(&model, &state.network);
+        nnueModelFree(&model);
+    }
+
+    initializeCellsList(&boardCells);
+    for (int mode = 0; mode < 3; mode++) {
+        state.checksums[mode] = calloc(state.games, sizeof(uint64_t));
+        if (state.checksums[mode] == NULL) {
+            result = 1;
+        }
+    }
+    state.plays = calloc(state.games, sizeof(long));
+    if (state.plays == NULL || boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        result = 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        if (result == 0 && boardClone(&state.boards[worker], &boardCells) == 1) {
+            result = 1;
+        }
+    }
+
+    for (int mode = PLAYS_ONLY; mode <= REFRESH && result == 0; mode++) {
+        result = runPass(&state, threads, mode, &times[mode]);
+    }
+
+    if (result == 0) {
+        double incremental = times[INCREMENTAL] - times[PLAYS_ONLY];
+        double refresh = times[REFRESH] - times[PLAYS_ONLY];
+
+        for (long game = 0; game < state.games; game++) {
+            evaluations += state.plays[game];
+            mismatches += state.checksums[INCREMENTAL][game] != state.checksums[REFRESH][game];
+        }
+
+        printf("board %ux%u, %d threads, %ld games, %ld evaluations, %dx%dx1 layers, %s\n", rows, cols, threads,
+               state.games, evaluations, NNUE_HIDDEN1, NNUE_HIDDEN2,
+               weightsFile != NULL ? weightsFile : "random weights");
+        printf("plays only:  %8.3f s\n", times[PLAYS_ONLY]);
+        printf("incremental: %8.3f s, %12.0f evals/s\n", times[INCREMENTAL], incremental > 0 ? evaluations / incremental : 0.0);
+        printf("refresh:     %8.3f s, %12.0f evals/s\n", times[REFRESH], refresh > 0 ? evaluations / refresh : 0.0);
+        printf("speedup %.2fx, %ld games with different outputs\n", incremental > 0 ? refresh / incremental : 0.0, mismatches);
+        result = mismatches != 0;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+    }
+    for (int mode = 0; mode < 3; mode++) {
+        free(state.checksums[mode]);
+    }
+    free(state.plays);
+    freeBoardCells(&boardCells);
+    nnueNetworkFree(&state.network);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
@@ -0,0 +1,384 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../archive.h"
+#include "../nnue.h"
+#include "../scheduler.h"
+
+/*
+    Fits the network of 'nnue.h' to the outcomes of recorded games. The games
+    of an archive (see 'tools/archivegen') are replayed block by block on all
+    cores and every position after a play is a training sample whose target
+    is whether P1 won. The positions of a block are shuffled before training,
+    otherwise the consecutive positions of a game pull the model towards the
+    outcome of that game. The threads update the float model without locks
+    (Hogwild). Every tenth game is held out to measure the validation loss
+    and accuracy. After each epoch the model is quantised and written to the
+    weights file, which can be given to 'tools/tournament -N' and to
+    'tools/nnuebench -w'. At the end the quantised network is compared with
+    the float model on the held out positions, and its incrementally updated
+    accumulators with the ones computed from scratch.
+*/
+
+#define VALIDATION_GAMES 10  // One game in this many is held out
+
+/**
+ * Position replayed from the archive.
+ */
+typedef struct {
+    int features[NNUE_MAX_ACTIVE];
+    int totalActive;
+    bool validation;  // Whether the game of the position is held out
+    float target;  // 1 if P1 won the game, 0 if P2 won
+} trainSample;
+
+/**
+ * Result of an epoch (or of the final check) on one block.
+ */
+typedef struct {
+    double trainLoss;  // Sum of the cross entropy of the training positions
+    long trainPositions;
+    double validationLoss;  // Sum of the cross entropy of the held out positions
+    long validationPositions;
+    long correct;  // Held out positions whose winner was predicted
+    double maxDifference;  // Largest difference between the quantised and the float probabilities (final check)
+    double sumDifference;  // Sum of the differences (final check)
+    long accumulatorMismatches;  // Incremental accumulators different from the refreshed ones (final check)
+} blockResult;
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    archiveReader reader;
+    nnueModel model;
+    nnueNetwork network;  // Quantised model
+    double rate;  // Learning rate
+    bool checking;  // Whether the tasks run the final check instead of training
+    uint64_t seed;  // Seed of the shuffles of the current epoch
+    blockResult *results;  // One per block
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    trainSample *samples[MAX_WORKERS];  // Positions of the block of each worker thread
+} trainState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: nnuetrain [-f <archive file>] [-e <epochs>] [-l <learning rate>] [-t <threads>] [-S <seed>] [-o <weights file>]");
+    puts("  fits the network to the outcomes of the archive games, one game in 10 held out for validation");
+    puts("  defaults: archive games.nta, 10 epochs, learning rate 0.01, seed 1, weights written to nnue.bin");
+}
+
+/**
+ * @brief Gets the cross entropy of a prediction.
+ * @param p1Wins The predicted probability of P1 winning
+ * @param target 1 if P1 won, 0 if P2 won
+ * @return Returns the loss
+ */
+static double crossEntropy(double p1Wins, double target) {
+    double p = p1Wins < 1e-12 ? 1e-12 : p1Wins > 1 - 1e-12 ? 1 - 1e-12 : p1Wins;
+
+    return -(target * log(p) + (1 - target) * log(1 - p));
+}
+
+/**
+ * @brief Checks the quantised network on a position: compares it with the
+ * float model and the incremental accumulator with the refreshed one.
+ * @param state The trainer state
+ * @param boardCells Board of the position
+ * @param accumulator Incrementally updated accumulator of the position
+ * @param features Active features of the position
+ * @param totalActive Number of active features
+ * @param result Result of the block
+ */
+static void checkPosition(const trainState *state, const list *boardCells, const nnueAccumulator *accumulator,
+                          const int *features, int totalActive, blockResult *result) {
+    nnueAccumulator refreshed;
+    double difference = fabs(nnueValue(&state->network, accumulator, 0) - nnueModelValue(&state->model, features, totalActive));
+
+    nnueRefresh(&state->network, boardCells, &refreshed);
+    if (memcmp(refreshed.values, accumulator->values, sizeof(refreshed.values)) != 0) {
+        result->accumulatorMismatches++;
+    }
+
+    result->validationPositions++;
+    result->sumDifference += difference;
+    if (difference > result->maxDifference) {
+        result->maxDifference = difference;
+    }
+}
+
+/**
+ * @brief Trains the model on the positions of a block, in random order, and
+ * measures it on the held out ones.
+ * @param state The trainer state
+ * @param samples The positions of the block
+ * @param totalSamples Number of positions
+ * @param rng Generator of the shuffle
+ * @param result Result of the block
+ */
+static void trainSamples(trainState *state, trainSample *samples, long totalSamples, rngState *rng, blockResult *result) {
+    for (long i = totalSamples - 1; i > 0; i--) {
+        long other = rngRange(rng, (int) (i + 1));
+        trainSample swap = samples[i];
+
+        samples[i] = samples[other];
+        samples[other] = swap;
+    }
+
+    for (long i = 0; i < totalSamples; i++) {
+        const trainSample *sample = &samples[i];
+
+        if (sample->validation) {
+            double p1Wins = nnueModelValue(&state->model, sample->features, sample->totalActive);
+
+            result->validationLoss += crossEntropy(p1Wins, sample->target);
+            result->correct += (p1Wins > 0.5) == (sample->target > 0.5);
+            result->validationPositions++;
+        } else {
+            double p1Wins = nnueModelTrain(&state->model, sample->features, sample->totalActive, sample->target, state->rate);
+
+            result->trainLoss += crossEntropy(p1Wins, sample->target);
+            result->trainPositions++;
+        }
+    }
+}
+
+/**
+ * @brief Replays the games of a block and trains the model on their positions
+ * (or runs the final check on the held out ones).
+ * @param task The task id, the block number
+ * @param worker Index of the worker thread
+ * @param arg The trainer state
+ */
+static void runBlockTask(long task, int worker, void *arg) {
+    trainState *state = arg;
+    const archiveBlockIndex *entry = &state->reader.index[task];
+    const unsigned char *lengths = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_LENGTHS);
+    const unsigned char *dices = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_DICES);
+    const unsigned char *pawns = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_PAWNS);
+    const unsigned char *outcomes = archiveColumn(&state->reader, (uint32_t) task, ARCHIVE_OUTCOMES);
+    const unsigned char *lengthsEnd = lengths + entry->columnSize[ARCHIVE_LENGTHS];
+    blockResult *result = &state->results[task];
+    list *boardCells = &state->boards[worker];
+    trainSample *samples = state->samples[worker];
+    nnueAccumulator accumulator;
+    long totalSamples = 0;
+    uint32_t play = 0;
+    rngState rng;
+
+    memset(result, 0, sizeof(blockResult));
+    for (uint32_t game = 0; game < entry->games; game++) {
+        int winner = archiveOutcome(outcomes, game);
+        bool validation = (entry->firstGame + game) % VALIDATION_GAMES == 0;
+        bool player1 = true;
+        uint32_t plays;
+
+        // The columns were checked by 'archiveReaderOpen', a failed read only stops the block
+        if (archiveReadVarint(&lengths, lengthsEnd, &plays) == 1) {
+            break;
+        }
+
+        // Unfinished games have no outcome to learn, and only held out games are checked
+        if (winner == 0 || (state->checking && !validation)) {
+            play += plays;
+            continue;
+        }
+
+        boardReset(boardCells);
+        if (state->checking) {
+            nnueRefresh(&state->network, boardCells, &accumulator);
+        }
+
+        for (uint32_t gamePlay = 0; gamePlay < plays; gamePlay++, play++) {
+            char pawn = (player1 ? SYMBOLS_J1 : SYMBOLS_J2)[archivePawn(pawns, play) + 1];
+            trainSample *sample = &samples[totalSamples++];
+
+            if (state->checking) {
+                nnuePlay(&state->network, &accumulator, boardCells, pawn, archiveDices(dices, play));
+            } else {
+                makePlay(boardCells, pawn, archiveDices(dices, play));
+            }
+            player1 = !player1;
+
+            sample->totalActive = nnueFeatures(boardCells, sample->features);
+            sample->validation = validation;
+            sample->target = winner == 1;
+            if (state->checking) {
+                checkPosition(state, boardCells, &accumulator, sample->features, sample->totalActive, result);
+            }
+        }
+    }
+
+    if (!state->checking) {
+        rngSeed(&rng, state->seed ^ ((uint64_t) task << 32));
+        trainSamples(state, samples, totalSamples, &rng, result);
+    }
+}
+
+/**
+ * @brief Adds the results of every block.
+ * @param state The trainer state
+ * @param total Receives the sums
+ */
+static void sumResults(const trainState *state, blockResult *total) {
+    memset(total, 0, sizeof(blockResult));
+    for (uint32_t blockNumber = 0; blockNumber < state->reader.totalBlocks; blockNumber++) {
+        const blockResult *block = &state->results[blockNumber];
+
+        total->trainLoss += block->trainLoss;
+        total->trainPositions += block->trainPositions;
+        total->validationLoss += block->validationLoss;
+        total->validationPositions += block->validationPositions;
+        total->correct += block->correct;
+        total->sumDifference += block->sumDifference;
+        total->accumulatorMismatches += block->accumulatorMismatches;
+        if (block->maxDifference > total->maxDifference) {
+            total->maxDifference = block->maxDifference;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static trainState state;
+    const char *fileName = "games.nta";
+    const char *outputFile = "nnue.bin";
+    int epochs = 10;
+    int threads = availableCores();
+    uint64_t seed = 1;
+    safeCellSet safeCells;
+    list boardCells;
+    blockResult total;
+    uint32_t maxPlays = 0;
+    rngState rng;
+    int option;
+    int result = 0;
+
+    state.rate = 0.01;
+
+    while ((option = getopt(argc, argv, "f:e:l:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'f':
+                fileName = optarg;
+                break;
+            case 'e':
+                epochs = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'l':
+                state.rate = strtod(optarg, NULL);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                return 1;
+        }
+    }
+
+    if (epochs < 1 || state.rate <= 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        return 1;
+    }
+
+    if (archiveReaderOpen(fileName, &state.reader) == 1) {
+        fprintf(stderr, "nnuetrain: %s is missing or is not a valid archive\n", fileName);
+        return 1;
+    }
+
+    // The archive keeps the safe cells, so the board of the games is rebuilt from it
+    safeCells.isSafe = (unsigned char *) state.reader.isSafe;
+    safeCells.length = (int) state.reader.totalCells;
+    safeCells.memory = NULL;
+    initializeCellsList(&boardCells);
+    rngSeed(&rng, seed);
+    state.results = calloc(state.reader.totalBlocks > 0 ? state.reader.totalBlocks : 1, sizeof(blockResult));
+    if (state.results == NULL || boardSetup(&boardCells, &safeCells, (int) state.reader.totalCells) == 1 ||
+        nnueModelInit(&state.model, (int) state.reader.totalCells, &rng) == 1 ||
+        nnueNetworkInit(&state.network, (int) state.reader.totalCells) == 1) {
+        result = 1;
+    }
+
+    // Each worker keeps the positions of a whole block
+    for (uint32_t blockNumber = 0; blockNumber < state.reader.totalBlocks; blockNumber++) {
+        if (state.reader.index[blockNumber].plays > maxPlays) {
+            maxPlays = state.reader.index[blockNumber].plays;
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        state.samples[worker] = malloc(sizeof(trainSample) * (maxPlays + 1));
+        if (result == 0 && (state.samples[worker] == NULL || boardClone(&state.boards[worker], &boardCells) == 1)) {
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        printf("%s: board %ux%u, %lu games, %d threads, %d features, %dx%dx1 layers, learning rate %g\n", fileName,
+               state.reader.rows, state.reader.cols, (unsigned long) state.reader.totalGames, threads,
+               state.model.totalFeatures, NNUE_HIDDEN1, NNUE_HIDDEN2, state.rate);
+        puts("epoch  train loss  valid loss  accuracy   positions/s");
+    }
+
+    for (int epoch = 1; epoch <= epochs && result == 0; epoch++) {
+        double start = now(), elapsed;
+
+        state.seed = seed + (uint64_t) epoch;
+        result = runWorkStealing(threads, state.reader.totalBlocks, runBlockTask, &state);
+        elapsed = now() - start;
+        sumResults(&state, &total);
+
+        printf("%5d %11.4f %11.4f %8.1f%% %13.0f\n", epoch,
+               total.trainPositions > 0 ? total.trainLoss / total.trainPositions : 0.0,
+               total.validationPositions > 0 ? total.validationLoss / total.validationPositions : 0.0,
+               total.validationPositions > 0 ? 100.0 * total.correct / total.validationPositions : 0.0,
+               elapsed > 0 ? (total.trainPositions + total.validationPositions) / elapsed : 0.0);
+        fflush(stdout);
+
+        nnueQuantize(&state.model, &state.network);
+        if (result == 0 && nnueSave(outputFile, &state.network) == 1) {
+            fprintf(stderr, "Could not write the weights file %s\n", outputFile);
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        state.checking = true;
+        result = runWorkStealing(threads, state.reader.totalBlocks, runBlockTask, &state);
+        sumResults(&state, &total);
+
+        printf("weights written to %s\n", outputFile);
+        printf("quantised vs float on %ld held out positions: mean difference %.5f, max %.5f\n", total.validationPositions,
+               total.validationPositions > 0 ? total.sumDifference / total.validationPositions : 0.0, total.maxDifference);
+        printf("incremental accumulators different from the refreshed ones: %ld\n", total.accumulatorMismatches);
+        result = total.accumulatorMismatches != 0;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+        free(state.samples[worker]);
+    }
+    freeBoardCells(&boardCells);
+    nnueNetworkFree(&state.network);
+    nnueModelFree(&state.model);
+    free(state.results);
+    archiveReaderClose(&state.reader);
+
+    return result;
+}
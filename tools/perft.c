@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../scheduler.h"
+
+/*
+    Perft: counts the move sequences of a given depth from the initial
+    position, over every dices value. A node is a position with a player to
+    move; each dices value (2 to 12) and each legal move of that value leads to
+    a child. A finished game is a leaf before the given depth. The work is split
+    at the root, one task per dices value. Every move given by 'generateMoves'
+    is checked against the result of 'makePlay' (the tool is built with asserts).
+*/
+
+#define MAX_PERFT_DEPTH 16  // Defines the max search depth
+#define DICES_VALUES (MAX_DICES_VALUE - 1)  // Dices values from 2 to 12
+
+/**
+ * Counters of a perft search.
+ */
+typedef struct {
+    long leaves;  // Positions at the given depth or where the game ended
+    long moves;  // Moves made
+    long captures;  // Adversary pawns captured
+    long wins;  // Pawns that completed their lap
+    long finished;  // Games that ended before the given depth
+} perftCounters;
+
+/**
+ * State shared by all root tasks.
+ */
+typedef struct {
+    int depth;
+    list boards[MAX_WORKERS][MAX_PERFT_DEPTH + 1];  // One board per ply of each worker thread
+    perftCounters perDices[DICES_VALUES];  // Counters of each root dices value
+} perftState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: perft [-r <lines>] [-c <columns>] [-s <safe cells file>] [-d <depth>] [-t <threads>]");
+    printf("  defaults: 3x7 board without safe cells, depth 3 (max %d)\n", MAX_PERFT_DEPTH);
+}
+
+/**
+ * @brief Counts the leaves below a position.
+ * @param boards Boards of the plies, 'boards[0]' has the position
+ * @param player1 Whether it is player 1 to move
+ * @param depth Plies left
+ * @param counters Receives the counts
+ */
+static void perft(list *boards, bool player1, int depth, perftCounters *counters) {
+    gameMove moves[MAX_MOVES];
+    int totalMoves;
+
+    if (depth == 0) {
+        counters->leaves++;
+        return;
+    }
+
+    if (checkGameWin(&boards[0], boards[0].length) != 0) {
+        counters->leaves++;
+        counters->finished++;
+        return;
+    }
+
+    totalMoves = generateMoves(&boards[0], player1, 0, moves);
+    for (int i = 0; i < totalMoves; i++) {
+        int captures;
+
+        boardCopy(&boards[1], &boards[0]);
+        captures = makePlay(&boards[1], moves[i].pawn, moves[i].dicesValue);
+
+        // The generator must predict the play
+        assert(captures == moves[i].captures);
+        assert(boards[1].pawnCells[player1 ? 0 : 1][getPawnIndex(moves[i].pawn)] == moves[i].destination);
+        assert((casaPawnState(boards[1].cells[moves[i].destination], player1 ? 0 : 1, getPawnIndex(moves[i].pawn)) == WIN) == moves[i].win);
+        (void) captures;
+
+        counters->moves++;
+        counters->captures += moves[i].captures;
+        counters->wins += moves[i].win;
+        perft(boards + 1, !player1, depth - 1, counters);
+    }
+}
+
+/**
+ * @brief Counts the leaves below the initial position for one root dices value.
+ * @param task The task id, the dices value less 2
+ * @param worker Index of the worker thread
+ * @param arg The perft state
+ */
+static void runPerftTask(long task, int worker, void *arg) {
+    perftState *state = arg;
+    list *boards = state->boards[worker];
+    perftCounters *counters = &state->perDices[task];
+    gameMove moves[MAX_MOVES];
+    int totalMoves;
+
+    boardReset(&boards[0]);
+    totalMoves = generateMoves(&boards[0], true, (int) task + 2, moves);
+
+    for (int i = 0; i < totalMoves; i++) {
+        boardCopy(&boards[1], &boards[0]);
+        makePlay(&boards[1], moves[i].pawn, moves[i].dicesValue);
+
+        counters->moves++;
+        counters->captures += moves[i].captures;
+        counters->wins += moves[i].win;
+        perft(boards + 1, false, state->depth - 1, counters);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static perftState state;
+    unsigned int rows = 3, cols = 7;
+    int threads = availableCores();
+    safeCellSet safeCells;
+    list boardCells;
+    perftCounters total = {0, 0, 0, 0, 0};
+    double start, elapsed;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.depth = 3;
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:d:t:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'd':
+                state.depth = (int) strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || state.depth < 1 ||
+        state.depth > MAX_PERFT_DEPTH || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    // More threads than root tasks would only sit idle
+    threads = threads < DICES_VALUES ? threads : DICES_VALUES;
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        for (int ply = 0; ply <= state.depth; ply++) {
+            initializeCellsList(&state.boards[worker][ply]);
+            if (result == 0 && boardClone(&state.boards[worker][ply], &boardCells) == 1) {
+                result = 1;
+            }
+        }
+    }
+
+    start = now();
+    if (result == 0) {
+        result = runWorkStealing(threads, DICES_VALUES, runPerftTask, &state);
+    }
+    elapsed = now() - start;
+
+    if (result == 0) {
+        printf("board %ux%u, depth %d, %d threads\n", rows, cols, state.depth, threads);
+        puts("dices          leaves          moves       captures           wins       finished");
+
+        for (int dices = 0; dices < DICES_VALUES; dices++) {
+            perftCounters *counters = &state.perDices[dices];
+
+            printf("%5d %15ld %14ld %14ld %14ld %14ld\n", dices + 2, counters->leaves, counters->moves,
+                   counters->captures, counters->wins, counters->finished);
+            total.leaves += counters->leaves;
+            total.moves += counters->moves;
+            total.captures += counters->captures;
+            total.wins += counters->wins;
+            total.finished += counters->finished;
+        }
+
+        printf("total %15ld %14ld %14ld %14ld %14ld\n", total.leaves, total.moves, total.captures, total.wins, total.finished);
+        printf("%.3f s, %.0f moves/s\n", elapsed, total.moves / elapsed);
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        for (int ply = 0; ply <= state.depth; ply++) {
+            freeBoardCells(&state.boards[worker][ply]);
+        }
+    }
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
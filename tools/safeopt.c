@@ -0,0 +1,577 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../scheduler.h"
+
+/*
+    Searches safe cells layouts that make P1 and P2 win random games equally
+    often. Simulated annealing walks the safe cells bitmap of one board (a
+    step adds, removes or moves a safe cell, the home cells are always safe)
+    and each candidate is scored by the distance of the P1 win rate from 50%.
+    The games of a candidate are simulated in rounds on all cores, game n
+    seeded with seed + n for every candidate so that two layouts are compared
+    on the same dices. After each round a sequential probability ratio test
+    checks whether the candidate is clearly worse than the current layout
+    (its win rate is further from 50% by more than a margin) and, if so,
+    stops it early. The best layouts are simulated again with other seeds
+    and written as safe cells config files, one cell per line. With '-n' the
+    number of safe cells is fixed and every step moves a safe cell (a board
+    without safe cells is already close to balanced).
+*/
+
+#define GAMES_PER_TASK 250  // Games simulated by each task
+#define MAX_BEST_LAYOUTS 32  // Max number of layouts written
+#define CONFIDENCE_Z 1.96  // Normal quantile of a 95% confidence interval
+#define MAX_FILE_NAME 256  // Max length of an output file name
+
+/**
+ * A safe cells layout and its simulated results.
+ */
+typedef struct {
+    unsigned char *isSafe;  // 'isSafe[n]' is 1 if cell 'n' is safe (home cells excluded)
+    long p1Wins;
+    long p2Wins;
+} safeLayout;
+
+/**
+ * State shared by all tasks.
+ */
+typedef struct {
+    int totalCells;
+    const unsigned char *isSafe;  // Layout being simulated
+    uint64_t seed;  // Game n is seeded with 'seed + n'
+    long firstGame;  // First game of the current round
+    long roundGames;  // Games of the current round
+    _Atomic long p1Wins;
+    _Atomic long p2Wins;
+    list boards[MAX_WORKERS];  // Board of each worker thread
+} optimiserState;
+
+/**
+ * Settings of the sequential probability ratio test.
+ */
+typedef struct {
+    double margin;  // Extra distance from 50% of a clearly worse layout
+    double upperBound;  // Log likelihood ratio at which a layout is clearly worse
+} sprtSettings;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: safeopt [-r <lines>] [-c <columns>] [-p <pawns>] [-d <dices>] [-s <initial safe cells file>] [-n <safe cells>]");
+    puts("               [-i <iterations>] [-g <max games per layout>] [-b <games per round>] [-D <margin>] [-a <alpha>]");
+    puts("               [-T <temperature>] [-k <layouts written>] [-o <output prefix>] [-t <threads>] [-S <seed>]");
+    puts("  searches the safe cells that bring the P1 win rate of random games closest to 50%");
+    puts("  defaults: 3x7 board, 4 pawns, 2 dices, no initial safe cells (random ones with -n), any number of safe cells,");
+    puts("            300 iterations, 20000 games per layout in rounds of 2000, layouts 1% worse stopped at 5% error,");
+    puts("            temperature 0.005, best 3 written to safe-<n>.txt");
+}
+
+/**
+ * @brief Gets the P1 win rate of a layout.
+ * @param layout The layout
+ * @return Returns the share of the finished games won by P1
+ */
+static double p1Rate(const safeLayout *layout) {
+    long finished = layout->p1Wins + layout->p2Wins;
+
+    return finished > 0 ? (double) layout->p1Wins / finished : 0.5;
+}
+
+/**
+ * @brief Gets how far a layout is from balanced.
+ * @param layout The layout
+ * @return Returns the distance of the P1 win rate from 50%
+ */
+static double imbalance(const safeLayout *layout) {
+    return fabs(p1Rate(layout) - 0.5);
+}
+
+/**
+ * @brief Simulates a range of games of the current round.
+ * @param task The task id, identifies the range of games
+ * @param worker Index of the worker thread
+ * @param arg The optimiser state
+ */
+static void runSimulationTask(long task, int worker, void *arg) {
+    optimiserState *state = arg;
+    list *boardCells = &state->boards[worker];
+    long firstGame = task * GAMES_PER_TASK;
+    long lastGame = firstGame + GAMES_PER_TASK < state->roundGames ? firstGame + GAMES_PER_TASK : state->roundGames;
+    long wins[3] = {0, 0, 0};
+    gameResult result;
+    rngState rng;
+
+    // The home cells stay safe, every other cell follows the layout
+    for (int cellIndex = 0; cellIndex < state->totalCells; cellIndex++) {
+        if (cellIndex != 0 && cellIndex != state->totalCells / 2) {
+            casaSetSafe(&boardCells->cells[cellIndex], state->isSafe[cellIndex] ? TRUE : FALSE);
+        }
+    }
+
+    for (long game = firstGame; game < lastGame; game++) {
+        boardReset(boardCells);
+        rngSeed(&rng, state->seed + (uint64_t) (state->firstGame + game));
+        simulateGame(boardCells, &rng, &result, NULL);
+        wins[result.winner]++;
+    }
+
+    atomic_fetch_add(&state->p1Wins, wins[1]);
+    atomic_fetch_add(&state->p2Wins, wins[2]);
+}
+
+/**
+ * @brief Log likelihood ratio of a clearly worse P1 win rate against an
+ * equally good one, on one side of 50%.
+ * @param layout The layout and its results so far
+ * @param good P1 win rate as far from 50% as the current layout
+ * @param worse P1 win rate further from 50% by the margin
+ * @return Returns the log likelihood ratio
+ */
+static double likelihoodRatio(const safeLayout *layout, double good, double worse) {
+    return layout->p1Wins * log(worse / good) + layout->p2Wins * log((1 - worse) / (1 - good));
+}
+
+/**
+ * @brief Checks whether a layout is clearly worse than the current one. The
+ * win rate can be off on either side of 50%, so a test is run on each side
+ * (each with half of the error).
+ * @param layout The layout and its results so far
+ * @param target Distance from 50% of the current layout
+ * @param sprt The test settings
+ * @return Returns whether the layout is clearly worse
+ */
+static bool clearlyWorse(const safeLayout *layout, double target, const sprtSettings *sprt) {
+    double high = 0.5 + target < 0.99 ? 0.5 + target : 0.99;
+    double low = 0.5 - target > 0.01 ? 0.5 - target : 0.01;
+    double highWorse = high + sprt->margin < 0.995 ? high + sprt->margin : 0.995;
+    double lowWorse = low - sprt->margin > 0.005 ? low - sprt->margin : 0.005;
+
+    return likelihoodRatio(layout, high, highWorse) >= sprt->upperBound ||
+           likelihoodRatio(layout, low, lowWorse) >= sprt->upperBound;
+}
+
+/**
+ * @brief Simulates the games of a layout in rounds, stopping early when it is
+ * clearly worse than the current layout.
+ * @param state The optimiser state
+ * @param threads Number of worker threads
+ * @param layout The layout, receives its results
+ * @param maxGames Games simulated if the layout is not stopped
+ * @param roundGames Games of each round
+ * @param target Distance from 50% of the current layout, negative to never stop early
+ * @param sprt The test settings
+ * @param played Receives the number of games simulated
+ * @return Returns 1 if the layout was stopped early, 0 if all its games were simulated and -1 on 'FAILURE'
+ */
+static int evaluateLayout(optimiserState *state, int threads, safeLayout *layout, long maxGames, long roundGames,
+                          double target, const sprtSettings *sprt, long *played) {
+    layout->p1Wins = 0;
+    layout->p2Wins = 0;
+    state->isSafe = layout->isSafe;
+
+    for (*played = 0; *played < maxGames;) {
+        state->firstGame = *played;
+        state->roundGames = maxGames - *played < roundGames ? maxGames - *played : roundGames;
+        atomic_store(&state->p1Wins, 0);
+        atomic_store(&state->p2Wins, 0);
+        if (runWorkStealing(threads, (state->roundGames + GAMES_PER_TASK - 1) / GAMES_PER_TASK, runSimulationTask, state) == 1) {
+            fputs("Not enough memory to simulate the games\n", stderr);
+            return -1;
+        }
+
+        layout->p1Wins += atomic_load(&state->p1Wins);
+        layout->p2Wins += atomic_load(&state->p2Wins);
+        *played += state->roundGames;
+
+        if (target >= 0 && *played < maxGames && clearlyWorse(layout, target, sprt)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Changes a layout by one step: adds or removes a safe cell, or moves
+ * one to a cell that is not safe.
+ * @param layout The layout
+ * @param totalCells Number of cells of the board
+ * @param fixedCount Whether the number of safe cells must be kept
+ * @param rng Generator of the step
+ */
+static void stepLayout(safeLayout *layout, int totalCells, bool fixedCount, rngState *rng) {
+    int safeCount = 0;
+    int cellIndex;
+
+    for (int i = 0; i < totalCells; i++) {
+        safeCount += layout->isSafe[i];
+    }
+
+    // Any cell but the homes (cell 0 and the middle cell) can change
+    do {
+        cellIndex = rngRange(rng, totalCells);
+    } while (cellIndex == 0 || cellIndex == totalCells / 2);
+
+    layout->isSafe[cellIndex] = !layout->isSafe[cellIndex];
+
+    // Half of the steps keep the number of safe cells (all of them with a fixed number)
+    if (safeCount > 0 && safeCount < totalCells - 2 && (fixedCount || rngRange(rng, 2) == 0)) {
+        int other;
+
+        do {
+            other = rngRange(rng, totalCells);
+        } while (other == 0 || other == totalCells / 2 || layout->isSafe[other] != layout->isSafe[cellIndex]);
+        layout->isSafe[other] = !layout->isSafe[other];
+    }
+}
+
+/**
+ * @brief Keeps a layout among the best ones if it is better than the last one
+ * and different from all of them.
+ * @param best The best layouts, sorted from the most balanced
+ * @param totalBest Number of best layouts kept
+ * @param keep Max number of best layouts
+ * @param layout The layout
+ * @param totalCells Number of cells of the board
+ * @return Returns whether the layout became the most balanced one
+ */
+static bool keepBest(safeLayout *best, int *totalBest, int keep, const safeLayout *layout, int totalCells) {
+    int position = *totalBest;
+    unsigned char *isSafe;
+
+    for (int i = 0; i < *totalBest; i++) {
+        if (memcmp(best[i].isSafe, layout->isSafe, totalCells) == 0) {
+            return false;
+        }
+    }
+
+    while (position > 0 && imbalance(layout) < imbalance(&best[position - 1])) {
+        position--;
+    }
+    if (position == keep) {
+        return false;
+    }
+
+    // The last layout is dropped when the list is full, its bitmap is reused
+    isSafe = *totalBest == keep ? best[keep - 1].isSafe : best[*totalBest].isSafe;
+    if (*totalBest < keep) {
+        (*totalBest)++;
+    }
+    memmove(&best[position + 1], &best[position], sizeof(safeLayout) * (*totalBest - 1 - position));
+    best[position] = *layout;
+    best[position].isSafe = isSafe;
+    memcpy(isSafe, layout->isSafe, totalCells);
+
+    return position == 0;
+}
+
+/**
+ * @brief Writes a layout as a safe cells config file, one cell per line.
+ * @param fileName The name of the config file
+ * @param layout The layout
+ * @param totalCells Number of cells of the board
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int writeLayout(const char *fileName, const safeLayout *layout, int totalCells) {
+    FILE *fp = fopen(fileName, "w");
+    bool failed = false;
+
+    if (fp == NULL) {
+        return 1;
+    }
+
+    for (int cellIndex = 0; cellIndex < totalCells; cellIndex++) {
+        if (layout->isSafe[cellIndex] && fprintf(fp, "%d\n", cellIndex) < 0) {
+            failed = true;
+        }
+    }
+
+    return fclose(fp) != 0 || failed;
+}
+
+/**
+ * @brief Prints the safe cells of a layout.
+ * @param layout The layout
+ * @param totalCells Number of cells of the board
+ */
+static void printCells(const safeLayout *layout, int totalCells) {
+    int printed = 0;
+
+    for (int cellIndex = 0; cellIndex < totalCells; cellIndex++) {
+        if (layout->isSafe[cellIndex]) {
+            printf("%s%d", printed++ > 0 ? "," : " ", cellIndex);
+        }
+    }
+    if (printed == 0) {
+        printf(" none");
+    }
+}
+
+/**
+ * @brief Compares two layouts by imbalance (for 'qsort').
+ * @param a Pointer to a layout
+ * @param b Pointer to another layout
+ * @return Returns a negative number, 0 or a positive number
+ */
+static int compareImbalance(const void *a, const void *b) {
+    double imbalanceA = imbalance(a);
+    double imbalanceB = imbalance(b);
+
+    return (imbalanceA > imbalanceB) - (imbalanceA < imbalanceB);
+}
+
+int main(int argc, char *argv[])
+{
+    static optimiserState state;
+    static safeLayout best[MAX_BEST_LAYOUTS];
+    unsigned int rows = 3, cols = 7;
+    int pawns = STANDARD_PAWNS, dices = STANDARD_DICES;
+    int iterations = 300, keep = 3, totalBest = 0, safeCount = -1, initialCount = 0;
+    long maxGames = 20000, roundGames = 2000, totalGames = 0, played;
+    double alpha = 0.05, temperature = 0.005;
+    const char *prefix = "safe";
+    int threads = availableCores();
+    uint64_t seed = 1;
+    sprtSettings sprt = {0.01, 0};
+    safeCellSet safeCells;
+    safeLayout current, candidate;
+    list boardCells;
+    rngState rng;
+    long stopped = 0, accepted = 0;
+    double start, elapsed;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    initializeSafeCells(&safeCells);
+    while ((option = getopt(argc, argv, "r:c:p:d:s:n:i:g:b:D:a:T:k:o:t:S:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'p':
+                pawns = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'd':
+                dices = (int) strtol(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'n':
+                safeCount = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'i':
+                iterations = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'g':
+                maxGames = strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                roundGames = strtol(optarg, NULL, 10);
+                break;
+            case 'D':
+                sprt.margin = strtod(optarg, NULL);
+                break;
+            case 'a':
+                alpha = strtod(optarg, NULL);
+                break;
+            case 'T':
+                temperature = strtod(optarg, NULL);
+                break;
+            case 'k':
+                keep = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'o':
+                prefix = optarg;
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    // Counted only for a valid board size, 0 (rejected below) otherwise
+    totalCells = validBoardSize(rows, cols) ? (int) (rows * 2 + (cols - 2) * 2) : 0;
+    if (totalCells == 0 || !validGameRules(pawns, dices) ||
+        iterations < 0 || maxGames < 1 || roundGames < 1 || sprt.margin <= 0 || sprt.margin >= 0.5 || alpha <= 0 ||
+        alpha >= 0.5 || temperature < 0 || safeCount < -1 || safeCount > totalCells - 2 || keep < 1 || keep > MAX_BEST_LAYOUTS || strlen(prefix) > MAX_FILE_NAME - 16 ||
+        threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    // Wald's bound for clearly worse layouts, half of the error on each side of 50%
+    sprt.upperBound = log((1 - alpha) / (alpha / 2));
+
+    state.totalCells = totalCells;
+    state.seed = seed;
+    initializeCellsList(&boardCells);
+    boardCells.pawns = pawns;
+    boardCells.dices = dices;
+    current.isSafe = calloc(totalCells, 1);
+    candidate.isSafe = calloc(totalCells, 1);
+    if (current.isSafe == NULL || candidate.isSafe == NULL || boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        result = 1;
+    }
+
+    for (int i = 0; i < keep && result == 0; i++) {
+        best[i].isSafe = calloc(totalCells, 1);
+        if (best[i].isSafe == NULL) {
+            result = 1;
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        if (result == 0 && boardClone(&state.boards[worker], &boardCells) == 1) {
+            result = 1;
+        }
+    }
+
+    // The search starts from the given safe cells (cells beyond the board are ignored)
+    for (int cellIndex = 1; cellIndex < totalCells && cellIndex < safeCells.length && result == 0; cellIndex++) {
+        current.isSafe[cellIndex] = safeCells.isSafe[cellIndex] && cellIndex != totalCells / 2;
+        initialCount += current.isSafe[cellIndex];
+    }
+
+    // Without initial safe cells a fixed number of them starts at random cells
+    rngSeed(&rng, seed ^ 0x5afe5afe5afe5afeULL);
+    if (result == 0 && safeCount >= 0 && initialCount == 0) {
+        while (initialCount < safeCount) {
+            int cellIndex = rngRange(&rng, totalCells);
+
+            if (cellIndex != 0 && cellIndex != totalCells / 2 && !current.isSafe[cellIndex]) {
+                current.isSafe[cellIndex] = 1;
+                initialCount++;
+            }
+        }
+    }
+
+    if (result == 0 && safeCount >= 0 && initialCount != safeCount) {
+        fprintf(stderr, "The initial safe cells file has %d cells of this board, not %d\n", initialCount, safeCount);
+        result = 1;
+    }
+    start = now();
+    if (result == 0) {
+        printf("board %ux%u, %d pawns, %d dices, %d threads, %d iterations of up to %ld games (rounds of %ld)\n", rows, cols,
+               pawns, dices, threads, iterations, maxGames, roundGames);
+        printf("stop when %.1f%% further from 50%% at %.0f%% error, temperature %g\n", sprt.margin * 100, alpha * 100, temperature);
+        result = evaluateLayout(&state, threads, &current, maxGames, roundGames, -1, &sprt, &played) == -1;
+        totalGames += played;
+        keepBest(best, &totalBest, keep, &current, totalCells);
+        puts("iteration      games   P1 wins   safe cells");
+        printf("%9d %10ld %8.2f%%  ", 0, totalGames, p1Rate(&current) * 100);
+        printCells(&current, totalCells);
+        putchar('\n');
+    }
+
+    for (int iteration = 1; iteration <= iterations && result == 0; iteration++) {
+        // Linear cooling, the last iterations only accept better layouts
+        double heat = temperature * (iterations - iteration) / iterations;
+        int evaluation;
+        double delta;
+
+        memcpy(candidate.isSafe, current.isSafe, totalCells);
+        stepLayout(&candidate, totalCells, safeCount >= 0, &rng);
+
+        evaluation = evaluateLayout(&state, threads, &candidate, maxGames, roundGames, imbalance(&current), &sprt, &played);
+        totalGames += played;
+        if (evaluation == -1) {
+            result = 1;
+            break;
+        }
+        if (evaluation == 1) {
+            stopped++;
+            continue;
+        }
+
+        if (keepBest(best, &totalBest, keep, &candidate, totalCells)) {
+            printf("%9d %10ld %8.2f%%  ", iteration, totalGames, p1Rate(&candidate) * 100);
+            printCells(&candidate, totalCells);
+            putchar('\n');
+            fflush(stdout);
+        }
+
+        delta = imbalance(&candidate) - imbalance(&current);
+        if (delta <= 0 || (heat > 0 && rngNext(&rng) / 4294967296.0 < exp(-delta / heat))) {
+            unsigned char *swap = current.isSafe;
+
+            current = candidate;
+            candidate.isSafe = swap;
+            accepted++;
+        }
+    }
+    elapsed = now() - start;
+
+    if (result == 0) {
+        printf("%ld games in %.2f s (%.0f games/s), %ld layouts stopped early, %ld accepted, %ld games saved\n", totalGames,
+               elapsed, totalGames / elapsed, stopped, accepted, (long) (iterations + 1) * maxGames - totalGames);
+    }
+
+    // The best layouts were picked on the search games, so they are measured again on other games
+    state.seed = seed ^ 0xbe57be57be57be57ULL;
+    for (int i = 0; i < totalBest && result == 0; i++) {
+        result = evaluateLayout(&state, threads, &best[i], maxGames, roundGames, -1, &sprt, &played) == -1;
+    }
+    if (result == 0) {
+        qsort(best, totalBest, sizeof(safeLayout), compareImbalance);
+        puts("rank   P1 wins (95% CI)    file        safe cells");
+    }
+
+    for (int i = 0; i < totalBest && result == 0; i++) {
+        char fileName[MAX_FILE_NAME];
+        long finished = best[i].p1Wins + best[i].p2Wins;
+        double rate = p1Rate(&best[i]);
+
+        snprintf(fileName, sizeof(fileName), "%s-%d.txt", prefix, i + 1);
+        if (writeLayout(fileName, &best[i], totalCells) == 1) {
+            fprintf(stderr, "Could not write the safe cells file %s\n", fileName);
+            result = 1;
+            break;
+        }
+
+        printf("%4d %8.2f%% +/- %.2f%%  %s ", i + 1, rate * 100,
+               finished > 0 ? CONFIDENCE_Z * sqrt(rate * (1 - rate) / finished) * 100 : 0.0, fileName);
+        printCells(&best[i], totalCells);
+        putchar('\n');
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+    }
+    for (int i = 0; i < keep; i++) {
+        free(best[i].isSafe);
+    }
+    free(current.isSafe);
+    free(candidate.isSafe);
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../scheduler.h"
+
+/*
+    Parameter sweep driver: simulates random games for every combination of
+    board lines, board columns, pawns per player, dices per play and safe cells
+    layout and writes one CSV row per configuration as soon as all of its games
+    are finished.
+*/
+
+#define MAX_SWEEP_VALUES 64  // Defines the max number of values per swept parameter
+#define MAX_FILE_NAME 256  // Defines the max length of a safe cells config file name
+
+/**
+ * A single board configuration of the sweep and its accumulated results.
+ */
+typedef struct {
+    unsigned int rows;
+    unsigned int cols;
+    unsigned int pawns;
+    unsigned int dices;
+    char safeCellsFile[MAX_FILE_NAME];  // Config file name or "none"
+    safeCellSet safeCells;  // Safe cells read from the config file
+    _Atomic long batchesLeft;  // Number of batches not finished yet
+    _Atomic long p1Wins;
+    _Atomic long p2Wins;
+    _Atomic long plays;
+    _Atomic long captures;
+} sweepConfig;
+
+/**
+ * State shared by all sweep tasks.
+ */
+typedef struct {
+    sweepConfig *configs;
+    long batchesPerConfig;  // Number of batches each configuration is split in
+    long gamesPerConfig;
+    long batchSize;  // Number of games per batch
+    uint64_t seed;
+    FILE *output;  // CSV output stream
+    pthread_mutex_t outputLock;  // Serialises the CSV rows written by the workers
+} sweepState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: sweep -r <lines> -c <columns> [-p <pawns>] [-d <dices>] [-s <safe cells files>] [-g <games>]");
+    puts("             [-b <batch size>] [-t <threads>] [-S <seed>] [-o <output.csv>]");
+    puts("  <lines>, <columns>, <pawns>, <dices>   comma separated values and/or ranges 'first:last[:step]', e.g. 3,5 or 5:11:2");
+    puts("  <safe cells files>   comma separated config files, 'none' for no safe cells (default)");
+    printf("  defaults: %d pawns (1 to %d), %d dices (1 to %d), 1000 games per configuration, batches of 100 games,\n",
+           STANDARD_PAWNS, MAX_PAWNS, STANDARD_DICES, MAX_DICES);
+    puts("  one thread per core, stdout");
+}
+
+/**
+ * @brief Parses a comma separated list of values and ranges ('first:last[:step]').
+ * @param text The text to parse
+ * @param values Array that receives the values
+ * @return Returns the number of values read or -1 if the text is not valid
+ */
+static int parseValueList(const char *text, unsigned int *values) {
+    int totalValues = 0;
+    char *end;
+
+    while (*text != '\0') {
+        long first = strtol(text, &end, 10);
+        long last = first;
+        long step = 1;
+
+        if (end == text) {
+            return -1;
+        }
+
+        if (*end == ':') {
+            text = end + 1;
+            last = strtol(text, &end, 10);
+            if (end == text) {
+                return -1;
+            }
+
+            if (*end == ':') {
+                text = end + 1;
+                step = strtol(text, &end, 10);
+                if (end == text || step <= 0) {
+                    return -1;
+                }
+            }
+        }
+
+        // Values beyond 'MAX_CELLS' are never valid, bounding them keeps the steps and board sizes from wrapping
+        if (first <= 0 || last > MAX_CELLS || step > MAX_CELLS) {
+            return -1;
+        }
+
+        for (long value = first; value <= last; value += step) {
+            if (totalValues == MAX_SWEEP_VALUES) {
+                return -1;
+            }
+            values[totalValues++] = (unsigned int) value;
+        }
+
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return -1;
+        }
+        text = end;
+    }
+
+    return totalValues;
+}
+
+/**
+ * @brief Splits a comma separated list of file names.
+ * @param text The text to split
+ * @param names Array that receives the names
+ * @return Returns the number of names read or -1 if the text is not valid
+ */
+static int parseNameList(const char *text, char names[][MAX_FILE_NAME]) {
+    int totalNames = 0;
+
+    while (*text != '\0') {
+        size_t length = strcspn(text, ",");
+
+        if (length == 0 || length >= MAX_FILE_NAME || totalNames == MAX_SWEEP_VALUES) {
+            return -1;
+        }
+
+        memcpy(names[totalNames], text, length);
+        names[totalNames++][length] = '\0';
+
+        text += length;
+        if (*text == ',') {
+            text++;
+        }
+    }
+
+    return totalNames;
+}
+
+/**
+ * @brief Writes the CSV row with the results of a finished configuration.
+ * @param state The sweep state
+ * @param config The finished configuration
+ */
+static void writeConfigResults(sweepState *state, sweepConfig *config) {
+    double games = (double) state->gamesPerConfig;
+    long p1Wins = atomic_load(&config->p1Wins);
+    long p2Wins = atomic_load(&config->p2Wins);
+
+    pthread_mutex_lock(&state->outputLock);
+    fprintf(state->output, "%u,%u,%u,%u,%s,%ld,%.4f,%.4f,%ld,%.2f,%.2f\n",
+            config->rows, config->cols, config->pawns, config->dices, config->safeCellsFile, state->gamesPerConfig,
+            p1Wins / games, p2Wins / games, state->gamesPerConfig - p1Wins - p2Wins,
+            atomic_load(&config->plays) / games, atomic_load(&config->captures) / games);
+    fflush(state->output);
+    pthread_mutex_unlock(&state->outputLock);
+}
+
+/**
+ * @brief Runs a batch of games of one configuration.
+ * @param task The task id, identifies the configuration and the batch
+ * @param worker Index of the worker thread (not used)
+ * @param arg The sweep state
+ */
+static void runSweepBatch(long task, int worker, void *arg) {
+    sweepState *state = arg;
+    sweepConfig *config = &state->configs[task / state->batchesPerConfig];
+    long batch = task % state->batchesPerConfig;
+    long firstGame = batch * state->batchSize;
+    long games = state->gamesPerConfig - firstGame < state->batchSize ? state->gamesPerConfig - firstGame : state->batchSize;
+    simulationStats stats = {0};
+
+    (void) worker;
+
+    // Each batch has its own seed, so results do not depend on the scheduling
+    simulateGames(config->rows, config->cols, &config->safeCells, (int) config->pawns, (int) config->dices, games, state->seed ^ ((uint64_t) task << 32), &stats, NULL, NULL);
+
+    atomic_fetch_add(&config->p1Wins, stats.p1Wins);
+    atomic_fetch_add(&config->p2Wins, stats.p2Wins);
+    atomic_fetch_add(&config->plays, stats.plays);
+    atomic_fetch_add(&config->captures, stats.captures);
+
+    // The worker finishing the last batch writes the configuration results
+    if (atomic_fetch_sub(&config->batchesLeft, 1) == 1) {
+        writeConfigResults(state, config);
+    }
+}
+
+/**
+ * @brief Frees the configurations and their safe cells.
+ * @param configs The configurations (allocated with 'calloc')
+ * @param totalConfigs The number of configurations
+ */
+static void freeConfigs(sweepConfig *configs, long totalConfigs) {
+    for (long c = 0; c < totalConfigs; c++) {
+        freeSafeCells(&configs[c].safeCells);
+    }
+    free(configs);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int rowValues[MAX_SWEEP_VALUES], colValues[MAX_SWEEP_VALUES];
+    unsigned int pawnValues[MAX_SWEEP_VALUES] = {STANDARD_PAWNS}, diceValues[MAX_SWEEP_VALUES] = {STANDARD_DICES};
+    char safeCellsFiles[MAX_SWEEP_VALUES][MAX_FILE_NAME] = {"none"};
+    int totalRows = 0, totalCols = 0, totalPawns = 1, totalDices = 1, totalLayouts = 1;
+    int threads = availableCores();
+    long totalConfigs;
+    const char *outputFile = NULL;
+    sweepState state;
+    int option;
+    int result;
+
+    state.gamesPerConfig = 1000;
+    state.batchSize = 100;
+    state.seed = 1;
+
+    while ((option = getopt(argc, argv, "r:c:p:d:s:g:b:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                totalRows = parseValueList(optarg, rowValues);
+                break;
+            case 'c':
+                totalCols = parseValueList(optarg, colValues);
+                break;
+            case 'p':
+                totalPawns = parseValueList(optarg, pawnValues);
+                break;
+            case 'd':
+                totalDices = parseValueList(optarg, diceValues);
+                break;
+            case 's':
+                totalLayouts = parseNameList(optarg, safeCellsFiles);
+                break;
+            case 'g':
+                state.gamesPerConfig = strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                state.batchSize = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                return 1;
+        }
+    }
+
+    if (totalRows <= 0 || totalCols <= 0 || totalPawns <= 0 || totalDices <= 0 || totalLayouts <= 0 || state.gamesPerConfig <= 0 ||
+        state.batchSize <= 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        return 1;
+    }
+
+    totalConfigs = (long) totalRows * totalCols * totalPawns * totalDices * totalLayouts;
+    state.configs = calloc(totalConfigs, sizeof(sweepConfig));
+    if (state.configs == NULL) {
+        return 1;
+    }
+
+    state.batchesPerConfig = (state.gamesPerConfig + state.batchSize - 1) / state.batchSize;
+
+    // Builds the configuration grid, checking every board with the game rules
+    for (long c = 0; c < totalConfigs; c++) {
+        sweepConfig *config = &state.configs[c];
+        const char *layout = safeCellsFiles[c % totalLayouts];
+
+        config->rows = rowValues[c / totalLayouts / totalDices / totalPawns / totalCols];
+        config->cols = colValues[c / totalLayouts / totalDices / totalPawns % totalCols];
+        config->pawns = pawnValues[c / totalLayouts / totalDices % totalPawns];
+        config->dices = diceValues[c / totalLayouts % totalDices];
+        strcpy(config->safeCellsFile, layout);
+        atomic_init(&config->batchesLeft, state.batchesPerConfig);
+
+        if (!validBoardSize(config->rows, config->cols) || !validGameRules((int) config->pawns, (int) config->dices)) {
+            fprintf(stderr, "Invalid board %ux%u with %u pawns and %u dices\n", config->rows, config->cols, config->pawns, config->dices);
+            freeConfigs(state.configs, totalConfigs);
+            return 1;
+        }
+
+        if (strcmp(layout, "none") != 0 && getSafeCellsFromConfigFile((char *) layout, &config->safeCells) == 1) {
+            freeConfigs(state.configs, totalConfigs);
+            return 1;
+        }
+    }
+
+    state.output = outputFile != NULL ? fopen(outputFile, "w") : stdout;
+    if (state.output == NULL) {
+        fprintf(stderr, "Could not open %s\n", outputFile);
+        freeConfigs(state.configs, totalConfigs);
+        return 1;
+    }
+
+    pthread_mutex_init(&state.outputLock, NULL);
+    fputs("rows,cols,pawns,dices,safe_cells,games,p1_win_rate,p2_win_rate,unfinished,mean_length,mean_captures\n", state.output);
+    fflush(state.output);
+
+    result = runWorkStealing(threads, totalConfigs * state.batchesPerConfig, runSweepBatch, &state);
+
+    pthread_mutex_destroy(&state.outputLock);
+    if (state.output != stdout) {
+        fclose(state.output);
+    }
+    freeConfigs(state.configs, totalConfigs);
+
+    return result;
+}
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../policy.h"
+#include "../td.h"
+#include "../scheduler.h"
+
+/*
+    TD(lambda) self-play trainer. Training runs in epochs: the games of an
+    epoch are spread over all cores and every thread updates the shared
+    weights without locks (Hogwild). After each epoch the learned policy plays
+    the random policy (same dices sequences, seats swapped) and the weights are
+    written to the checkpoint file, which can be given to 'tools/tournament -T'
+    or to the game with '--opponent'.
+*/
+
+#define CONFIDENCE_Z 1.96  // Normal quantile of a 95% confidence interval
+
+/**
+ * State shared by all training and evaluation tasks.
+ */
+typedef struct {
+    tdWeights weights;
+    tdSettings settings;
+    long gamesPerTask;
+    long games;  // Games of the current epoch or evaluation
+    uint64_t seed;  // Seed of the current epoch or evaluation
+    _Atomic long wins;  // Evaluation games won by the learned policy
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    policyContext contexts[MAX_WORKERS];  // Policy state and scratch board of each worker thread
+} trainState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: tdtrain [-r <lines>] [-c <columns>] [-s <safe cells file>] [-e <epochs>] [-g <games per epoch>]");
+    puts("               [-a <learning rate>] [-l <lambda>] [-x <exploration>] [-v <evaluation games>] [-k <epochs per checkpoint>]");
+    puts("               [-w <initial weights file>] [-b <games per task>] [-t <threads>] [-S <seed>] [-o <weights file>]");
+    puts("  defaults: 3x7 board without safe cells, 20 epochs of 10000 games, learning rate 0.01, lambda 0.7,");
+    puts("            exploration 0.05, 2000 evaluation games, checkpoint every epoch to td.txt");
+}
+
+/**
+ * @brief Plays a range of self-play training games.
+ * @param task The task id, identifies the range of games
+ * @param worker Index of the worker thread
+ * @param arg The trainer state
+ */
+static void runTrainTask(long task, int worker, void *arg) {
+    trainState *state = arg;
+    long firstGame = task * state->gamesPerTask;
+    long lastGame = firstGame + state->gamesPerTask < state->games ? firstGame + state->gamesPerTask : state->games;
+    rngState rng;
+
+    rngSeed(&rng, state->seed + task);
+    for (long game = firstGame; game < lastGame; game++) {
+        tdTrainGame(&state->weights, &state->settings, &state->boards[worker], &state->contexts[worker].scratch, &rng);
+    }
+}
+
+/**
+ * @brief Plays a game between the learned and the random policies.
+ * @param boardCells Board with all cells, reset before the game
+ * @param context Policy state
+ * @param weights The learned weights
+ * @param learnedPlayer1 Whether the learned policy is player 1
+ * @param dicesSeed Seed of the dices
+ * @return Returns 1 if the learned policy won, 0 otherwise
+ */
+static int playRandom(list *boardCells, policyContext *context, const tdWeights *weights, bool learnedPlayer1, uint64_t dicesSeed) {
+    bool player1 = true;
+    rngState dices;
+
+    boardReset(boardCells);
+    rngSeed(&dices, dicesSeed);
+
+    for (int plays = 0; plays < SIMULATION_MAX_PLAYS; plays++) {
+        int winner = checkGameWin(boardCells, boardCells->length);
+        int dicesValue;
+        char pawn;
+
+        if (winner != 0) {
+            return (winner == 1) == learnedPlayer1;
+        }
+
+        dicesValue = rngRollDice(&dices, 2);
+        if (player1 == learnedPlayer1) {
+            pawn = tdPolicy(boardCells, player1, dicesValue, context, weights);
+        } else {
+            pawn = randomPolicy(boardCells, player1, dicesValue, context, NULL);
+        }
+        makePlay(boardCells, pawn, dicesValue);
+        player1 = !player1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Plays a range of evaluation game pairs, each dices sequence with both seatings.
+ * @param task The task id, identifies the range of game pairs
+ * @param worker Index of the worker thread
+ * @param arg The trainer state
+ */
+static void runEvaluationTask(long task, int worker, void *arg) {
+    trainState *state = arg;
+    long firstPair = task * state->gamesPerTask;
+    long lastPair = firstPair + state->gamesPerTask < state->games ? firstPair + state->gamesPerTask : state->games;
+    long wins = 0;
+
+    rngSeed(&state->contexts[worker].rng, state->seed ^ ((uint64_t) (task + 1) << 40));
+    for (long gamePair = firstPair; gamePair < lastPair; gamePair++) {
+        wins += playRandom(&state->boards[worker], &state->contexts[worker], &state->weights, true, state->seed + gamePair);
+        wins += playRandom(&state->boards[worker], &state->contexts[worker], &state->weights, false, state->seed + gamePair);
+    }
+
+    atomic_fetch_add(&state->wins, wins);
+}
+
+int main(int argc, char *argv[])
+{
+    static trainState state;
+    unsigned int rows = 3, cols = 7;
+    int epochs = 20, checkpointEpochs = 1;
+    long gamesPerEpoch = 10000, evaluationGames = 2000;
+    int threads = availableCores();
+    uint64_t seed = 1;
+    const char *outputFile = "td.txt";
+    safeCellSet safeCells;
+    list boardCells;
+    long totalGames = 0;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.settings.alpha = 0.01;
+    state.settings.lambda = 0.7;
+    state.settings.exploration = 0.05;
+    state.gamesPerTask = 50;
+    tdInitWeights(&state.weights);
+    initializeSafeCells(&safeCells);
+
+    while ((option = getopt(argc, argv, "r:c:s:e:g:a:l:x:v:k:w:b:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'e':
+                epochs = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'g':
+                gamesPerEpoch = strtol(optarg, NULL, 10);
+                break;
+            case 'a':
+                state.settings.alpha = strtod(optarg, NULL);
+                break;
+            case 'l':
+                state.settings.lambda = strtod(optarg, NULL);
+                break;
+            case 'x':
+                state.settings.exploration = strtod(optarg, NULL);
+                break;
+            case 'v':
+                evaluationGames = strtol(optarg, NULL, 10);
+                break;
+            case 'k':
+                checkpointEpochs = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'w':
+                if (tdLoadWeights(optarg, &state.weights) == 1) {
+                    fprintf(stderr, "Could not read the weights file %s\n", optarg);
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'b':
+                state.gamesPerTask = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || epochs < 1 ||
+        gamesPerEpoch < 1 || state.settings.alpha <= 0 || state.settings.lambda < 0 || state.settings.lambda > 1 ||
+        state.settings.exploration < 0 || state.settings.exploration > 1 || evaluationGames < 0 ||
+        checkpointEpochs < 1 || state.gamesPerTask <= 0 || threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        initializeCellsList(&state.contexts[worker].scratch);
+        if (result == 0 && (boardClone(&state.boards[worker], &boardCells) == 1 ||
+                            policyContextInit(&state.contexts[worker], &boardCells, seed) == 1)) {
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        printf("board %ux%u, %d threads, %d features, alpha %g, lambda %g, exploration %g\n", rows, cols, threads,
+               TD_FEATURES, state.settings.alpha, state.settings.lambda, state.settings.exploration);
+        puts("epoch      games   games/s   vs random (95% CI)");
+    }
+
+    for (int epoch = 1; epoch <= epochs && result == 0; epoch++) {
+        double start = now(), elapsed;
+
+        state.games = gamesPerEpoch;
+        state.seed = seed + (uint64_t) epoch * gamesPerEpoch;
+        result = runWorkStealing(threads, (gamesPerEpoch + state.gamesPerTask - 1) / state.gamesPerTask, runTrainTask, &state);
+        elapsed = now() - start;
+        totalGames += gamesPerEpoch;
+
+        printf("%5d %10ld %9.0f", epoch, totalGames, gamesPerEpoch / elapsed);
+
+        // Every evaluation plays the same dices sequences, so the epochs can be compared
+        if (result == 0 && evaluationGames >= 2) {
+            long played = evaluationGames / 2 * 2;
+            double score, margin;
+
+            state.games = evaluationGames / 2;
+            state.seed = seed ^ 0x5eed5eed5eed5eedULL;
+            atomic_store(&state.wins, 0);
+            result = runWorkStealing(threads, (state.games + state.gamesPerTask - 1) / state.gamesPerTask, runEvaluationTask, &state);
+
+            score = (double) atomic_load(&state.wins) / played;
+            margin = CONFIDENCE_Z * sqrt(score * (1 - score) / played);
+            printf("   %5.1f%% +/- %.1f%%", score * 100, margin * 100);
+        }
+        putchar('\n');
+        fflush(stdout);
+
+        if (result == 0 && (epoch % checkpointEpochs == 0 || epoch == epochs) && tdSaveWeights(outputFile, &state.weights) == 1) {
+            fprintf(stderr, "Could not write the weights file %s\n", outputFile);
+            result = 1;
+        }
+    }
+
+    if (result == 0) {
+        printf("weights written to %s\n", outputFile);
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+        policyContextFree(&state.contexts[worker]);
+    }
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../policy.h"
+#include "../evaluate.h"
+#include "../td.h"
+#include "../nnue.h"
+#include "../book.h"
+#include "../scheduler.h"
+
+/*
+    Round-robin tournament between pawn choice policies. Every pairing plays
+    the same dices sequences (game pair 'n' of every pairing uses the seed
+    'seed + n') twice, once with each policy as player 1, so neither the dices
+    nor the first move advantage favour a policy. Games run on the real engine
+    and are spread over all cores. Results are reported per pairing and as
+    Bradley-Terry Elo ratings with 95% confidence intervals.
+*/
+
+#define MAX_POLICIES 8  // Defines the max number of policies in a tournament
+#define MAX_PAIRINGS (MAX_POLICIES * (MAX_POLICIES - 1) / 2)
+#define ELO_SCALE (400 / M_LN10)  // Elo points per natural log unit of the odds
+#define CONFIDENCE_Z 1.96  // Normal quantile of a 95% confidence interval
+
+/**
+ * Results of a pairing, from the point of view of its first policy.
+ */
+typedef struct {
+    int first;  // Index of the first policy
+    int second;  // Index of the second policy
+    _Atomic long wins;
+    _Atomic long losses;
+    _Atomic long draws;
+} pairingResult;
+
+/**
+ * State shared by all tournament tasks.
+ */
+typedef struct {
+    pawnPolicy policies[MAX_POLICIES];
+    int totalPolicies;
+    pairingResult pairings[MAX_PAIRINGS];
+    int totalPairings;
+    long gamePairs;  // Dices sequences per pairing, each one played with both seatings
+    long pairsPerTask;
+    long tasksPerPairing;
+    uint64_t seed;
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    policyContext contexts[MAX_WORKERS];  // Policy state of each worker thread
+} tournamentState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: tournament [-r <lines>] [-c <columns>] [-s <safe cells file>] [-p <policies>] [-g <games>]");
+    puts("                  [-R <rollouts>] [-B <book file>] [-w <weights file>] [-T <td weights file>]");
+    puts("                  [-N <nnue weights file>] [-b <game pairs per task>] [-t <threads>] [-S <seed>]");
+    puts("  <policies>   comma separated list of random, forward, capture, safest, search, eval, td (needs -T) and nnue (needs -N)");
+    puts("  defaults: 3x7 board without safe cells, random to search, 200 games per pairing, 16 rollouts, no book,");
+    puts("            default evaluation weights");
+}
+
+/**
+ * @brief Parses a comma separated list of policy names.
+ * @param text The text to parse
+ * @param state Receives the policies
+ * @param search Settings given to the search policy
+ * @param weights Settings given to the evaluation policy
+ * @param learned Settings given to the learned policy, NULL if not loaded
+ * @param network Settings given to the network policy, NULL if not loaded
+ * @return Returns 0 on 'SUCCESS' and 1 if a name is not valid
+ */
+static int parsePolicies(const char *text, tournamentState *state, const searchSettings *search, const evalWeights *weights,
+                         const tdWeights *learned, const nnueNetwork *network) {
+    state->totalPolicies = 0;
+
+    while (*text != '\0') {
+        size_t length = strcspn(text, ",");
+        pawnPolicy *policy = &state->policies[state->totalPolicies];
+
+        if (length == 0 || length >= POLICY_NAME_SIZE || state->totalPolicies == MAX_POLICIES) {
+            return 1;
+        }
+
+        memcpy(policy->name, text, length);
+        policy->name[length] = '\0';
+        policy->choose = findPolicy(policy->name);
+        policy->settings = policy->choose == searchPolicy ? (const void *) search :
+                           policy->choose == evalPolicy ? (const void *) weights :
+                           policy->choose == tdPolicy ? (const void *) learned :
+                           policy->choose == nnuePolicy ? (const void *) network : NULL;
+        if (policy->choose == NULL || (policy->choose == tdPolicy && learned == NULL) ||
+            (policy->choose == nnuePolicy && network == NULL)) {
+            return 1;
+        }
+        state->totalPolicies++;
+
+        text += length;
+        if (*text == ',') {
+            text++;
+        }
+    }
+
+    return state->totalPolicies < 2;
+}
+
+/**
+ * @brief Plays a game between two policies.
+ * @param boardCells Board with all cells, reset before the game
+ * @param context Policy state
+ * @param player1Policy Policy of player 1
+ * @param player2Policy Policy of player 2
+ * @param dicesSeed Seed of the dices
+ * @param policySeed Seed of the policies random choices
+ * @return Returns 1 if player 1 won, 2 if player 2 won and 0 if the game reached 'SIMULATION_MAX_PLAYS'
+ */
+static int playGame(list *boardCells, policyContext *context, const pawnPolicy *player1Policy,
+                    const pawnPolicy *player2Policy, uint64_t dicesSeed, uint64_t policySeed) {
+    bool player1 = true;
+    rngState dices;
+
+    boardReset(boardCells);
+    rngSeed(&dices, dicesSeed);
+    rngSeed(&context->rng, policySeed);
+
+    for (int plays = 0; plays < SIMULATION_MAX_PLAYS; plays++) {
+        const pawnPolicy *policy = player1 ? player1Policy : player2Policy;
+        int winner = checkGameWin(boardCells, boardCells->length);
+        int dicesValue;
+
+        if (winner != 0) {
+            return winner;
+        }
+
+        dicesValue = rngRollDice(&dices, 2);
+        makePlay(boardCells, policy->choose(boardCells, player1, dicesValue, context, policy->settings), dicesValue);
+        player1 = !player1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Plays a range of game pairs of a pairing, each dices sequence with both seatings.
+ * @param task The task id, identifies the pairing and the range of game pairs
+ * @param worker Index of the worker thread
+ * @param arg The tournament state
+ */
+static void runTournamentTask(long task, int worker, void *arg) {
+    tournamentState *state = arg;
+    long pairingIndex = task / state->tasksPerPairing;
+    pairingResult *pairing = &state->pairings[pairingIndex];
+    long firstPair = task % state->tasksPerPairing * state->pairsPerTask;
+    long lastPair = firstPair + state->pairsPerTask < state->gamePairs ? firstPair + state->pairsPerTask : state->gamePairs;
+    long wins = 0, losses = 0, draws = 0;
+
+    for (long gamePair = firstPair; gamePair < lastPair; gamePair++) {
+        for (int seat = 0; seat < 2; seat++) {
+            const pawnPolicy *first = &state->policies[pairing->first];
+            const pawnPolicy *second = &state->policies[pairing->second];
+            uint64_t policySeed = (state->seed + gamePair) ^ ((uint64_t) (pairingIndex * 2 + seat + 1) << 48);
+            int winner;
+
+            if (seat == 0) {
+                winner = playGame(&state->boards[worker], &state->contexts[worker], first, second, state->seed + gamePair, policySeed);
+            } else {
+                // Same dices, seats swapped: the first policy is player 2
+                winner = playGame(&state->boards[worker], &state->contexts[worker], second, first, state->seed + gamePair, policySeed);
+                winner = winner == 0 ? 0 : 3 - winner;
+            }
+
+            wins += winner == 1;
+            losses += winner == 2;
+            draws += winner == 0;
+        }
+    }
+
+    atomic_fetch_add(&pairing->wins, wins);
+    atomic_fetch_add(&pairing->losses, losses);
+    atomic_fetch_add(&pairing->draws, draws);
+}
+
+/**
+ * @brief Converts a score (expected points per game) to an Elo difference.
+ * @param score The score, between 0 and 1
+ * @param games Number of games, used to keep the score away from 0 and 1
+ * @return Returns the Elo difference
+ */
+static double scoreToElo(double score, long games) {
+    double limit = 0.5 / games;
+
+    score = score < limit ? limit : score > 1 - limit ? 1 - limit : score;
+    return -400 * log10(1 / score - 1);
+}
+
+/**
+ * @brief Prints the result of every pairing with its Elo difference and 95% confidence interval.
+ * @param state The tournament state
+ */
+static void printPairings(tournamentState *state) {
+    puts("pairing                     wins  draws losses   score  elo diff (95% CI)");
+
+    for (int p = 0; p < state->totalPairings; p++) {
+        pairingResult *pairing = &state->pairings[p];
+        long wins = atomic_load(&pairing->wins), losses = atomic_load(&pairing->losses), draws = atomic_load(&pairing->draws);
+        long games = wins + losses + draws;
+        double score = (wins + 0.5 * draws) / games;
+        double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score) + losses * score * score) / games;
+        double margin = CONFIDENCE_Z * sqrt(variance / games);
+        char names[2 * POLICY_NAME_SIZE + 4];
+
+        snprintf(names, sizeof(names), "%s vs %s", state->policies[pairing->first].name, state->policies[pairing->second].name);
+        printf("%-24s %7ld %6ld %6ld  %5.1f%%  %+5.0f [%+.0f, %+.0f]\n", names, wins, draws, losses, score * 100,
+               scoreToElo(score, games), scoreToElo(score - margin, games), scoreToElo(score + margin, games));
+    }
+}
+
+/**
+ * @brief Fits Bradley-Terry ratings to all results (draws count as half a win,
+ * plus one virtual draw per pairing so a policy that never wins or never loses
+ * keeps a finite rating) and prints them as Elo, with 95% confidence intervals
+ * from the Fisher information. The mean rating is 0.
+ * @param state The tournament state
+ */
+static void printRatings(tournamentState *state) {
+    double strength[MAX_POLICIES], points[MAX_POLICIES], elo[MAX_POLICIES], margin[MAX_POLICIES];
+    double games[MAX_POLICIES][MAX_POLICIES] = {{0}};
+    int order[MAX_POLICIES];
+    double meanElo = 0;
+
+    for (int i = 0; i < state->totalPolicies; i++) {
+        strength[i] = 1;
+        points[i] = 0;
+        order[i] = i;
+    }
+
+    for (int p = 0; p < state->totalPairings; p++) {
+        pairingResult *pairing = &state->pairings[p];
+        double draws = atomic_load(&pairing->draws) + 1;
+        double total = atomic_load(&pairing->wins) + atomic_load(&pairing->losses) + draws;
+
+        points[pairing->first] += atomic_load(&pairing->wins) + 0.5 * draws;
+        points[pairing->second] += atomic_load(&pairing->losses) + 0.5 * draws;
+        games[pairing->first][pairing->second] = games[pairing->second][pairing->first] = total;
+    }
+
+    // Minorisation-maximisation iterations
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        for (int i = 0; i < state->totalPolicies; i++) {
+            double denominator = 0;
+
+            for (int j = 0; j < state->totalPolicies; j++) {
+                if (j != i && games[i][j] > 0) {
+                    denominator += games[i][j] / (strength[i] + strength[j]);
+                }
+            }
+            strength[i] = points[i] / denominator;
+        }
+    }
+
+    for (int i = 0; i < state->totalPolicies; i++) {
+        double information = 0;
+
+        for (int j = 0; j < state->totalPolicies; j++) {
+            double expected = strength[i] / (strength[i] + strength[j]);
+
+            if (j != i) {
+                information += games[i][j] * expected * (1 - expected);
+            }
+        }
+
+        elo[i] = ELO_SCALE * log(strength[i]);
+        margin[i] = CONFIDENCE_Z * ELO_SCALE / sqrt(information);
+        meanElo += elo[i] / state->totalPolicies;
+    }
+
+    // Sorts the policies by rating
+    for (int i = 1; i < state->totalPolicies; i++) {
+        for (int j = i; j > 0 && elo[order[j]] > elo[order[j - 1]]; j--) {
+            int swap = order[j];
+
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+
+    puts("\nrank policy              elo  95% CI");
+    for (int rank = 0; rank < state->totalPolicies; rank++) {
+        int i = order[rank];
+
+        printf("%4d %-16s %+6.0f  +/- %.0f\n", rank + 1, state->policies[i].name, elo[i] - meanElo, margin[i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static tournamentState state;
+    unsigned int rows = 3, cols = 7;
+    long games = 200;
+    int threads = availableCores();
+    const char *policyList = "random,forward,capture,safest,search";
+    const char *bookFile = NULL;
+    evalWeights weights;
+    static tdWeights learned;
+    bool learnedLoaded = false;
+    static nnueNetwork network;
+    bool networkLoaded = false;
+    searchSettings search = {NULL, 16};
+    safeCellSet safeCells;
+    list boardCells;
+    openingBook book;
+    double start, elapsed;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.pairsPerTask = 10;
+    state.seed = 1;
+    initializeSafeCells(&safeCells);
+    evalDefaultWeights(&weights);
+
+    while ((option = getopt(argc, argv, "r:c:s:p:g:R:B:w:T:N:b:t:S:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'p':
+                policyList = optarg;
+                break;
+            case 'g':
+                games = strtol(optarg, NULL, 10);
+                break;
+            case 'R':
+                search.rollouts = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'B':
+                bookFile = optarg;
+                break;
+            case 'w':
+                if (evalLoadWeights(optarg, &weights) == 1) {
+                    fprintf(stderr, "Could not read the weights file %s\n", optarg);
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (tdLoadWeights(optarg, &learned) == 1) {
+                    fprintf(stderr, "Could not read the weights file %s\n", optarg);
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                learnedLoaded = true;
+                break;
+            case 'N':
+                nnueNetworkFree(&network);
+                if (nnueLoad(optarg, &network) == 1) {
+                    fprintf(stderr, "Could not read the weights file %s\n", optarg);
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                networkLoaded = true;
+                break;
+            case 'b':
+                state.pairsPerTask = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                state.seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                showUsage();
+                nnueNetworkFree(&network);
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || games < 2 ||
+        search.rollouts <= 0 || state.pairsPerTask <= 0 || threads < 1 || threads > MAX_WORKERS ||
+        parsePolicies(policyList, &state, &search, &weights, learnedLoaded ? &learned : NULL,
+                      networkLoaded ? &network : NULL) == 1) {
+        showUsage();
+        nnueNetworkFree(&network);
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    // The network must have been trained on a board with the same cells
+    if (networkLoaded && network.totalCells != totalCells) {
+        fprintf(stderr, "The network was trained on a board with %d cells, not %d\n", network.totalCells, totalCells);
+        nnueNetworkFree(&network);
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        nnueNetworkFree(&network);
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    // The book must have been built for this board
+    book.mapping = NULL;
+    if (bookFile != NULL) {
+        if (bookOpen(bookFile, &boardCells, &book) == 1) {
+            fprintf(stderr, "Could not use the book %s with this board\n", bookFile);
+            freeBoardCells(&boardCells);
+            nnueNetworkFree(&network);
+            freeSafeCells(&safeCells);
+            return 1;
+        }
+        search.book = &book;
+    }
+
+    for (int first = 0; first < state.totalPolicies; first++) {
+        for (int second = first + 1; second < state.totalPolicies; second++) {
+            state.pairings[state.totalPairings].first = first;
+            state.pairings[state.totalPairings].second = second;
+            state.totalPairings++;
+        }
+    }
+    state.gamePairs = games / 2;
+    state.tasksPerPairing = (state.gamePairs + state.pairsPerTask - 1) / state.pairsPerTask;
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        initializeCellsList(&state.contexts[worker].scratch);
+        if (result == 0 && (boardClone(&state.boards[worker], &boardCells) == 1 ||
+                            policyContextInit(&state.contexts[worker], &boardCells, state.seed) == 1)) {
+            result = 1;
+        }
+    }
+
+    start = now();
+    if (result == 0) {
+        result = runWorkStealing(threads, state.tasksPerPairing * state.totalPairings, runTournamentTask, &state);
+    }
+    if (result == 1) {
+        fputs("Not enough memory to run the tournament\n", stderr);
+    }
+    elapsed = now() - start;
+
+    if (result == 0) {
+        printf("board %ux%u, %d policies, %ld games per pairing (%ld dices sequences, seats swapped), %d threads\n",
+               rows, cols, state.totalPolicies, state.gamePairs * 2, state.gamePairs, threads);
+        printPairings(&state);
+        printRatings(&state);
+        printf("\n%ld games in %.2f s (%.0f games/s)\n", state.gamePairs * 2 * state.totalPairings, elapsed,
+               state.gamePairs * 2 * state.totalPairings / elapsed);
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+        policyContextFree(&state.contexts[worker]);
+    }
+    bookClose(&book);
+    freeBoardCells(&boardCells);
+    nnueNetworkFree(&network);
+    freeSafeCells(&safeCells);
+
+    return result;
+}
@@ -0,0 +1,384 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../engine.h"
+#include "../simulate.h"
+#include "../policy.h"
+#include "../evaluate.h"
+#include "../scheduler.h"
+
+/*
+    Tuner of the evaluation weights by SPSA (simultaneous perturbation
+    stochastic approximation). Each iteration perturbs all weights at once in a
+    random direction, plays the two perturbed weight sets against each other
+    (same dices sequences, seats swapped, on all cores) and moves the weights
+    along the direction by the score difference. The evaluation policy only
+    compares positions, so the weights are kept with a sum of absolute values
+    of 1. The tuned weights are then played against the initial ones and
+    written to a weights file.
+*/
+
+#define SPSA_ALPHA 0.602  // Decay exponent of the step size
+#define SPSA_GAMMA 0.101  // Decay exponent of the perturbation size
+#define BENCHMARK_EVALUATIONS 4000000  // Evaluations timed before tuning
+#define CONFIDENCE_Z 1.96  // Normal quantile of a 95% confidence interval
+
+/**
+ * State shared by all self-play tasks.
+ */
+typedef struct {
+    evalWeights weights[2];  // Weights of the two sides of the match
+    _Atomic long wins[2];  // Games won by each side
+    long gamePairs;  // Dices sequences of the match, each one played with both seatings
+    long pairsPerTask;
+    uint64_t seed;  // Seed of the dices of the match
+    list boards[MAX_WORKERS];  // Board of each worker thread
+    policyContext contexts[MAX_WORKERS];  // Policy state of each worker thread
+} tuneState;
+
+
+/**
+ * @brief Prints the program usage.
+ */
+static void showUsage(void) {
+    puts("Usage: tune [-r <lines>] [-c <columns>] [-s <safe cells file>] [-w <initial weights file>] [-i <iterations>]");
+    puts("            [-g <games per iteration>] [-a <step size>] [-C <perturbation size>] [-v <verification games>]");
+    puts("            [-b <game pairs per task>] [-t <threads>] [-S <seed>] [-o <weights file>]");
+    puts("  defaults: 3x7 board without safe cells, default weights, 100 iterations of 400 games, step 0.05,");
+    puts("            perturbation 0.1, 4000 verification games, weights.txt");
+}
+
+/**
+ * @brief Scales the weights so the sum of their absolute values is 1.
+ * @param weights The weights
+ */
+static void normalizeWeights(evalWeights *weights) {
+    double norm = 0;
+
+    for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+        norm += fabs(weights->weights[feature]);
+    }
+
+    for (int feature = 0; feature < EVAL_FEATURES && norm > 0; feature++) {
+        weights->weights[feature] /= norm;
+    }
+}
+
+/**
+ * @brief Prints weights on one line.
+ * @param weights The weights
+ */
+static void printWeights(const evalWeights *weights) {
+    static const char *NAMES[EVAL_FEATURES] = {"progress", "safe", "exposure", "win"};
+
+    for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+        printf(" %s %+.4f", NAMES[feature], weights->weights[feature]);
+    }
+    putchar('\n');
+}
+
+/**
+ * @brief Times the evaluation on the positions of random games. Also checks
+ * that the evaluation of one player is minus the evaluation of the other.
+ * @param boardCells Board in its initial position (played on)
+ * @param weights The weights
+ * @param seed Seed of the games
+ * @return Returns the evaluations per second
+ */
+static double benchmarkEvaluation(list *boardCells, const evalWeights *weights, uint64_t seed) {
+    rngState rng;
+    bool player1 = true;
+    volatile double checksum = 0;  // Keeps the evaluations from being optimised away
+    double start = now();
+
+    rngSeed(&rng, seed);
+    boardReset(boardCells);
+
+    for (long evaluations = 0; evaluations < BENCHMARK_EVALUATIONS; evaluations += 64) {
+        int dicesValue;
+
+        if (checkGameWin(boardCells, boardCells->length) != 0) {
+            boardReset(boardCells);
+        }
+
+        for (int repeat = 0; repeat < 64; repeat++) {
+            checksum += evaluatePosition(boardCells, repeat & 1, weights);
+        }
+        assert(fabs(evaluatePosition(boardCells, 0, weights) + evaluatePosition(boardCells, 1, weights)) < 1e-9);
+
+        dicesValue = rngRollDice(&rng, 2);
+        makePlay(boardCells, chooseRandomPawn(boardCells, player1, &rng), dicesValue);
+        player1 = !player1;
+    }
+
+    return BENCHMARK_EVALUATIONS / (now() - start);
+}
+
+/**
+ * @brief Plays a game between two weight sets with the evaluation policy.
+ * @param boardCells Board with all cells, reset before the game
+ * @param context Policy state
+ * @param player1Weights Weights of player 1
+ * @param player2Weights Weights of player 2
+ * @param dicesSeed Seed of the dices
+ * @return Returns 1 if player 1 won, 2 if player 2 won and 0 if the game reached 'SIMULATION_MAX_PLAYS'
+ */
+static int playGame(list *boardCells, policyContext *context, const evalWeights *player1Weights,
+                    const evalWeights *player2Weights, uint64_t dicesSeed) {
+    bool player1 = true;
+    rngState dices;
+
+    boardReset(boardCells);
+    rngSeed(&dices, dicesSeed);
+
+    for (int plays = 0; plays < SIMULATION_MAX_PLAYS; plays++) {
+        int winner = checkGameWin(boardCells, boardCells->length);
+        int dicesValue;
+
+        if (winner != 0) {
+            return winner;
+        }
+
+        dicesValue = rngRollDice(&dices, 2);
+        makePlay(boardCells, evalPolicy(boardCells, player1, dicesValue, context, player1 ? player1Weights : player2Weights), dicesValue);
+        player1 = !player1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Plays a range of game pairs of the match, each dices sequence with both seatings.
+ * @param task The task id, identifies the range of game pairs
+ * @param worker Index of the worker thread
+ * @param arg The tuner state
+ */
+static void runMatchTask(long task, int worker, void *arg) {
+    tuneState *state = arg;
+    long firstPair = task * state->pairsPerTask;
+    long lastPair = firstPair + state->pairsPerTask < state->gamePairs ? firstPair + state->pairsPerTask : state->gamePairs;
+    long wins[2] = {0, 0};
+
+    rngSeed(&state->contexts[worker].rng, state->seed ^ ((uint64_t) (task + 1) << 40));
+
+    for (long gamePair = firstPair; gamePair < lastPair; gamePair++) {
+        int winner = playGame(&state->boards[worker], &state->contexts[worker], &state->weights[0], &state->weights[1], state->seed + gamePair);
+
+        wins[0] += winner == 1;
+        wins[1] += winner == 2;
+
+        winner = playGame(&state->boards[worker], &state->contexts[worker], &state->weights[1], &state->weights[0], state->seed + gamePair);
+        wins[0] += winner == 2;
+        wins[1] += winner == 1;
+    }
+
+    atomic_fetch_add(&state->wins[0], wins[0]);
+    atomic_fetch_add(&state->wins[1], wins[1]);
+}
+
+/**
+ * @brief Plays a match between the two weight sets of the state.
+ * @param state The tuner state, receives the wins of each side
+ * @param threads Number of worker threads
+ * @param gamePairs Number of dices sequences
+ * @param seed Seed of the dices
+ * @return Returns 0 on 'SUCCESS' and 1 on 'FAILURE'
+ */
+static int playMatch(tuneState *state, int threads, long gamePairs, uint64_t seed) {
+    atomic_store(&state->wins[0], 0);
+    atomic_store(&state->wins[1], 0);
+    state->gamePairs = gamePairs;
+    state->seed = seed;
+
+    return runWorkStealing(threads, (gamePairs + state->pairsPerTask - 1) / state->pairsPerTask, runMatchTask, state);
+}
+
+int main(int argc, char *argv[])
+{
+    static tuneState state;
+    unsigned int rows = 3, cols = 7;
+    int iterations = 100;
+    long games = 400, verificationGames = 4000;
+    double stepSize = 0.05, perturbationSize = 0.1;
+    int threads = availableCores();
+    uint64_t seed = 1;
+    const char *outputFile = "weights.txt";
+    evalWeights initial, tuned;
+    safeCellSet safeCells;
+    list boardCells;
+    rngState rng;
+    double start;
+    long totalGames = 0;
+    int totalCells;
+    int option;
+    int result = 0;
+
+    state.pairsPerTask = 5;
+    initializeSafeCells(&safeCells);
+    evalDefaultWeights(&initial);
+
+    while ((option = getopt(argc, argv, "r:c:s:w:i:g:a:C:v:b:t:S:o:h")) != -1) {
+        switch (option) {
+            case 'r':
+                rows = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cols = (unsigned int) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                if (getSafeCellsFromConfigFile(optarg, &safeCells) == 1) {
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'w':
+                if (evalLoadWeights(optarg, &initial) == 1) {
+                    fprintf(stderr, "Could not read the weights file %s\n", optarg);
+                    freeSafeCells(&safeCells);
+                    return 1;
+                }
+                break;
+            case 'i':
+                iterations = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'g':
+                games = strtol(optarg, NULL, 10);
+                break;
+            case 'a':
+                stepSize = strtod(optarg, NULL);
+                break;
+            case 'C':
+                perturbationSize = strtod(optarg, NULL);
+                break;
+            case 'v':
+                verificationGames = strtol(optarg, NULL, 10);
+                break;
+            case 'b':
+                state.pairsPerTask = strtol(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (int) strtol(optarg, NULL, 10);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputFile = optarg;
+                break;
+            default:
+                showUsage();
+                freeSafeCells(&safeCells);
+                return 1;
+        }
+    }
+
+    if (!validBoardSize(rows, cols) || iterations < 0 ||
+        games < 2 || verificationGames < 0 || stepSize <= 0 || perturbationSize <= 0 || state.pairsPerTask <= 0 ||
+        threads < 1 || threads > MAX_WORKERS) {
+        showUsage();
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    totalCells = rows * 2 + (cols - 2) * 2;
+
+    initializeCellsList(&boardCells);
+    if (boardSetup(&boardCells, &safeCells, totalCells) == 1) {
+        freeSafeCells(&safeCells);
+        return 1;
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        initializeCellsList(&state.boards[worker]);
+        initializeCellsList(&state.contexts[worker].scratch);
+        if (result == 0 && (boardClone(&state.boards[worker], &boardCells) == 1 ||
+                            policyContextInit(&state.contexts[worker], &boardCells, seed) == 1)) {
+            result = 1;
+        }
+    }
+
+    normalizeWeights(&initial);
+    tuned = initial;
+    rngSeed(&rng, seed);
+
+    if (result == 0) {
+        printf("board %ux%u, %d threads, %.1f million evaluations/s\ninitial:", rows, cols, threads,
+               benchmarkEvaluation(&boardCells, &initial, seed) / 1e6);
+        printWeights(&initial);
+    }
+
+    start = now();
+    for (int iteration = 0; iteration < iterations && result == 0; iteration++) {
+        double step = stepSize / pow(iteration + 1 + iterations / 10.0, SPSA_ALPHA);
+        double perturbation = perturbationSize / pow(iteration + 1, SPSA_GAMMA);
+        double direction[EVAL_FEATURES];
+        double score;
+
+        for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+            direction[feature] = rngRange(&rng, 2) == 0 ? -1 : 1;
+            state.weights[0].weights[feature] = tuned.weights[feature] + perturbation * direction[feature];
+            state.weights[1].weights[feature] = tuned.weights[feature] - perturbation * direction[feature];
+        }
+
+        // Every iteration plays new dices sequences
+        result = playMatch(&state, threads, games / 2, seed + (uint64_t) iteration * games);
+        totalGames += games / 2 * 2;
+        score = (double) (atomic_load(&state.wins[0]) - atomic_load(&state.wins[1])) / (games / 2 * 2);
+
+        for (int feature = 0; feature < EVAL_FEATURES; feature++) {
+            tuned.weights[feature] += step * score / (2 * perturbation * direction[feature]);
+        }
+        normalizeWeights(&tuned);
+
+        printf("iteration %4d score %+.3f:", iteration + 1, score);
+        printWeights(&tuned);
+    }
+
+    if (result == 0 && iterations > 0) {
+        printf("%ld self-play games in %.2f s (%.0f games/s)\n", totalGames, now() - start, totalGames / (now() - start));
+    }
+
+    // Tuned weights against the initial weights, on dices sequences not used for tuning
+    if (result == 0 && verificationGames >= 2) {
+        long played = verificationGames / 2 * 2;
+        double points, score, margin;
+        long wins, losses;
+
+        state.weights[0] = tuned;
+        state.weights[1] = initial;
+        result = playMatch(&state, threads, verificationGames / 2, seed + (uint64_t) (iterations + 1) * games);
+        wins = atomic_load(&state.wins[0]);
+        losses = atomic_load(&state.wins[1]);
+        points = wins + 0.5 * (played - wins - losses);
+        score = points / played;
+        margin = CONFIDENCE_Z * sqrt(score * (1 - score) / played);
+        printf("tuned vs initial: %ld wins, %ld losses, score %.1f%% +/- %.1f%%\n", wins, losses, score * 100, margin * 100);
+    }
+
+    if (result == 0) {
+        if (evalSaveWeights(outputFile, &tuned) == 1) {
+            fprintf(stderr, "Could not write the weights file %s\n", outputFile);
+            result = 1;
+        } else {
+            printf("tuned:");
+            printWeights(&tuned);
+            printf("written to %s\n", outputFile);
+        }
+    }
+
+    for (int worker = 0; worker < threads; worker++) {
+        freeBoardCells(&state.boards[worker]);
+        policyContextFree(&state.contexts[worker]);
+    }
+    freeBoardCells(&boardCells);
+    freeSafeCells(&safeCells);
+
+    return result;
+}